@@ -0,0 +1,281 @@
+/*
+  BenchmarkBrowse_WiFi
+
+  This sketch measures how fast browse replies are received & scanned and how
+  much heap is needed while doing it. Numbers are printed per server flavour:
+  objects per second, bytes per second (incl. HTTP header) and peak heap use.
+
+  Replay mode (default) needs no network: a replay client derived from
+  WiFiClient answers each browse request with a reply built from objects
+  captured in doc/Logfiles (see captures.h) from Plex, Jellyfin, Serviio, UMS,
+  Twonky, Subsonic, Kodi and Windows Media Player. The replies run through
+  the same code as real ones: HTTP header, de-chunking, XML entity decoding,
+  DIDL-Lite scanning.
+
+  With BENCHMARK_REAL_SERVERS defined the sketch additionally connects to
+  WiFi, looks for media servers and measures the same numbers over a real
+  socket, together with the request statistics of getStats().
+
+  Build with Core Debug Level "None", log output would dominate the numbers.
+*/
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include "SoapESP32.h"
+#include "captures.h"
+
+// uncomment to benchmark media servers in your network as well
+//#define BENCHMARK_REAL_SERVERS
+
+// objects per replayed reply, rounds per flavour (best round counts)
+#define REPLAY_OBJECTS   500
+#define REPLAY_ROUNDS    5
+// replies are sent chunked in blocks of one object each
+#define REPLAY_CHUNKED   false
+
+// directory to browse on real servers, all entries are requested
+#define REAL_OBJECT_ID   "0"
+
+const char ssid[] = "MySSID";
+const char pass[] = "MyPassword";
+
+//
+// replay client: request gets swallowed, reply is generated block by block
+// (block 0: HTTP header & start of envelope, then one block per object, last
+// block: end of envelope). Only the current block is kept in RAM.
+//
+class ReplayClient : public WiFiClient {
+  public:
+    void setReply(const benchFlavour_t *flavour, uint16_t objects, bool chunked) {
+      m_flavour = flavour;
+      m_objects = objects;
+      m_chunked = chunked;
+      m_count = 0;
+      while (flavour->objects[m_count]) m_count++;
+      // announced size: sum of all blocks of content
+      m_contentSize = 0;
+      for (int i = 0; i <= m_objects + 1; i++) {
+        makeBlock(i);
+        m_contentSize += m_block.length();
+      }
+    }
+    int connect(IPAddress ip, uint16_t port) override {
+      m_next = 0;
+      m_block = "";
+      m_pos = 0;
+      m_connected = true;
+      return 1;
+    }
+    int connect(const char *host, uint16_t port) override { return connect(IPAddress(), port); }
+    // variants with connect timeout used by library
+    int connect(IPAddress ip, uint16_t port, int32_t timeout) { return connect(ip, port); }
+    int connect(const char *host, uint16_t port, int32_t timeout) { return connect(IPAddress(), port); }
+    size_t write(uint8_t c) override { return 1; }
+    size_t write(const uint8_t *buf, size_t size) override { return size; }
+    int available() override { return fill() ? m_block.length() - m_pos : 0; }
+    int read() override { return fill() ? m_block[m_pos++] : -1; }
+    int read(uint8_t *buf, size_t size) override {
+      if (!fill()) return -1;
+      size_t len = min(size, (size_t)(m_block.length() - m_pos));
+      memcpy(buf, m_block.c_str() + m_pos, len);
+      m_pos += len;
+      return len;
+    }
+    int peek() override { return fill() ? m_block[m_pos] : -1; }
+    void flush() override {}
+    void stop() override { m_connected = false; }
+    uint8_t connected() override { return m_connected && fill(); }
+
+  private:
+    const benchFlavour_t *m_flavour;
+    uint16_t m_objects, m_count;
+    bool     m_chunked, m_connected = false;
+    size_t   m_contentSize;
+    int      m_next;                // next block to make
+    String   m_block;
+    size_t   m_pos;
+
+    bool fill() {
+      while (m_connected && m_pos >= m_block.length()) {
+        if (m_next > m_objects + 2) return false;   // all sent
+        m_pos = 0;
+        if (m_next == 0) {
+          // HTTP header + start of envelope
+          m_block = "HTTP/1.1 200 OK\r\nContent-Type: text/xml; charset=\"utf-8\"\r\nConnection: close\r\nServer: ";
+          m_block += m_flavour->server;
+          m_block += m_chunked ? "\r\nTransfer-Encoding: chunked\r\n\r\n" : "\r\nContent-Length: " + String(m_contentSize) + "\r\n\r\n";
+          String header = m_block;
+          makeBlock(0);
+          m_block = header + m_block;
+          m_next++;
+        }
+        else if (m_next == m_objects + 2) {
+          m_block = m_chunked ? "0\r\n\r\n" : "";
+          m_next++;
+        }
+        else makeBlock(m_next++);
+      }
+      return m_connected;
+    }
+
+    // content block (0: start of envelope, 1..m_objects: objects, m_objects + 1: end of envelope)
+    void makeBlock(int n) {
+      String didl;
+
+      if (n == 0) {
+        m_block = "<?xml version=\"1.0\" encoding=\"utf-8\"?><s:Envelope xmlns:s=\"http://schemas.xmlsoap.org/soap/envelope/\" "
+                  "s:encodingStyle=\"http://schemas.xmlsoap.org/soap/encoding/\"><s:Body>"
+                  "<u:BrowseResponse xmlns:u=\"urn:schemas-upnp-org:service:ContentDirectory:1\"><Result>";
+        didl = "<DIDL-Lite xmlns=\"urn:schemas-upnp-org:metadata-1-0/DIDL-Lite/\" xmlns:dc=\"http://purl.org/dc/elements/1.1/\" "
+               "xmlns:upnp=\"urn:schemas-upnp-org:metadata-1-0/upnp/\" xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\">";
+      }
+      else if (n <= m_objects) {
+        m_block = "";
+        didl = m_flavour->objects[(n - 1) % m_count];
+      }
+      else {
+        m_block = "";
+        didl = "</DIDL-Lite>";
+      }
+      // DIDL-Lite is sent XML escaped inside element Result
+      for (int i = 0; i < didl.length(); i++) {
+        switch (didl[i]) {
+          case '&': m_block += "&amp;"; break;
+          case '<': m_block += "&lt;"; break;
+          case '>': m_block += "&gt;"; break;
+          case '"': m_block += "&quot;"; break;
+          default:  m_block += didl[i];
+        }
+      }
+      if (n > m_objects) {
+        m_block += "</Result><NumberReturned>" + String(m_objects) + "</NumberReturned><TotalMatches>" + String(m_objects) +
+                   "</TotalMatches><UpdateID>1</UpdateID></u:BrowseResponse></s:Body></s:Envelope>";
+      }
+      if (m_chunked && n <= m_objects + 1) {
+        m_block = String(m_block.length(), HEX) + "\r\n" + m_block + "\r\n";
+      }
+    }
+};
+
+ReplayClient replay;
+SoapESP32 replaySoap(&replay);
+
+#ifdef BENCHMARK_REAL_SERVERS
+WiFiClient client;
+WiFiUDP    udp;
+SoapESP32  soap(&client, &udp);
+#endif
+
+// collected while browsing
+struct benchResult_t {
+  uint32_t objects;
+  uint32_t minFreeHeap;
+};
+
+// browse callback: counts objects and keeps track of lowest free heap
+bool countObject(const soapObject_t *object, void *userData) {
+  benchResult_t *result = (benchResult_t *)userData;
+  uint32_t freeHeap = ESP.getFreeHeap();
+
+  result->objects++;
+  if (freeHeap < result->minFreeHeap) result->minFreeHeap = freeHeap;
+  return true;
+}
+
+// single browse request, returns false on error
+bool benchmark(SoapESP32 *soap, uint8_t srv, const char *objectId, uint32_t *us, benchResult_t *result, soapStats_t *stats) {
+  uint32_t freeHeap = ESP.getFreeHeap();
+
+  result->objects = 0;
+  result->minFreeHeap = freeHeap;
+  uint32_t start = micros();
+  bool ok = soap->browseServer(srv, objectId, countObject, result, 0, 0);
+  *us = micros() - start;
+  if (ESP.getFreeHeap() < result->minFreeHeap) result->minFreeHeap = ESP.getFreeHeap();
+  result->minFreeHeap = freeHeap - result->minFreeHeap;   // now peak heap use
+  soap->getStats(stats);
+  return ok;
+}
+
+void printHeadline() {
+  Serial.println("flavour         objects     bytes       ms    obj/s     KB/s  peak heap");
+}
+
+void printResult(const char *name, uint32_t us, const benchResult_t *result, const soapStats_t *stats) {
+  char line[100];
+
+  if (us == 0) us = 1;
+  snprintf(line, sizeof(line), "%-14s %8u %9llu %8.1f %8.0f %8.1f %10u", name, result->objects,
+           stats->bytesReceived, us / 1000.0, result->objects * 1E6 / us, stats->bytesReceived * 1E6 / 1024 / us,
+           result->minFreeHeap);
+  Serial.println(line);
+}
+
+void setup() {
+  Serial.begin(115200);
+  Serial.println();
+
+  // replay mode: each flavour gets its own server entry, replies are built from captures
+  Serial.printf("Replaying captured replies, %d objects each, best of %d rounds%s:\n",
+                REPLAY_OBJECTS, REPLAY_ROUNDS, REPLAY_CHUNKED ? ", chunked" : "");
+  printHeadline();
+  for (int i = 0; i < sizeof(flavours) / sizeof(flavours[0]); i++) {
+    uint32_t us, best = 0;
+    benchResult_t result, bestResult;
+    soapStats_t stats, bestStats;
+
+    replaySoap.addServer(IPAddress(127, 0, 0, 1), 8200 + i, "/ContentDirectory/control", flavours[i].name);
+    replay.setReply(&flavours[i], REPLAY_OBJECTS, REPLAY_CHUNKED);
+    for (int r = 0; r < REPLAY_ROUNDS; r++) {
+      if (!benchmark(&replaySoap, i, flavours[i].parentId, &us, &result, &stats)) {
+        Serial.printf("%s: browse error\n", flavours[i].name);
+        break;
+      }
+      if (best == 0 || us < best) {
+        best = us;
+        bestResult = result;
+        bestStats = stats;
+      }
+    }
+    if (best) printResult(flavours[i].name, best, &bestResult, &bestStats);
+  }
+  Serial.println();
+
+#ifdef BENCHMARK_REAL_SERVERS
+  // real mode: same numbers over a real socket
+  Serial.print("Connecting to WiFi network ");
+  WiFi.begin(ssid, pass);
+  while (WiFi.status() != WL_CONNECTED) {
+    Serial.print(".");
+    delay(500);
+  }
+  Serial.println();
+  Serial.println("Scanning local network for DLNA media servers...");
+  soap.seekServer();
+  Serial.printf("Browsing directory \"%s\" of %d server(s):\n", REAL_OBJECT_ID, soap.getServerCount());
+  printHeadline();
+
+  soapServer_t srvInfo;
+  for (uint8_t srv = 0; soap.getServerInfo(srv, &srvInfo); srv++) {
+    uint32_t us;
+    benchResult_t result;
+    soapStats_t stats;
+
+    if (!benchmark(&soap, srv, REAL_OBJECT_ID, &us, &result, &stats)) {
+      Serial.printf("%s: browse error\n", srvInfo.friendlyName.c_str());
+      continue;
+    }
+    printResult(srvInfo.friendlyName.substring(0, 14).c_str(), us, &result, &stats);
+    Serial.printf("  connect %u ms, first byte %u ms, header %u ms, scan %u ms, chunks %u, dropped %u\n",
+                  stats.connectTime, stats.firstByteTime, stats.headerTime, stats.parseTime,
+                  stats.chunks, stats.objectsDropped);
+  }
+  Serial.println();
+#endif
+
+  Serial.println("Sketch finished.");
+}
+
+void loop() {
+  // nothing to do here
+}
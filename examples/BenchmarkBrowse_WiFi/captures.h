@@ -0,0 +1,98 @@
+/*
+  Captured DIDL-Lite objects for BenchmarkBrowse_WiFi
+
+  Taken from the verbose log files in doc/Logfiles (only objects whose log
+  lines are complete). Each flavour holds objects of one directory as found
+  in the Result element, i.e. before XML escaping, and the Server header line
+  of the reply. The replay client escapes & repeats them to build replies.
+*/
+
+#ifndef CAPTURES_H
+#define CAPTURES_H
+
+struct benchFlavour_t
+{
+  const char *name;
+  const char *server;           // "Server:" header line of reply
+  const char *parentId;         // id of browsed directory
+  const char *const *objects;   // NULL terminated
+};
+
+// Plex, 3 objects
+static const char *const plexObjects[] = {
+  "<container id=\"94467912-bd40-4d2f-ad25-7b8423f7b05a\" parentID=\"0\" restricted=\"1\" searchable=\"0\"><dc:title>Video</dc:title><dc:creator>Unknown</dc:creator><upnp:genre>Unknown</upnp:genre><dc:description>Video</dc:description><upnp:class>object.container.storageFolder</upnp:class></container>",
+  "<container id=\"abe6121c-1731-4683-815c-89e1dcd2bf11\" parentID=\"0\" restricted=\"1\" searchable=\"0\"><dc:title>Music</dc:title><dc:creator>Unknown</dc:creator><upnp:genre>Unknown</upnp:genre><dc:description>Music</dc:description><upnp:class>object.container.storageFolder</upnp:class></container>",
+  "<container id=\"b0184133-f840-4a4f-a583-45f99645edcd\" parentID=\"0\" restricted=\"1\" searchable=\"0\"><dc:title>Photos</dc:title><dc:creator>Unknown</dc:creator><upnp:genre>Unknown</upnp:genre><dc:description>Photos</dc:description><upnp:class>object.container.storageFolder</upnp:class></container>",
+  NULL
+};
+
+// Jellyfin, 1 objects
+static const char *const jellyfinObjects[] = {
+  "<container restricted=\"1\" searchable=\"1\" childCount=\"6\" id=\"f137a2dd21bbc1b99aa5c0f6bf02a805\" parentID=\"e9d5075a555c1cbc394eec4cef295274\"><dc:title>Movies</dc:title><upnp:class>object.container.storageFolder</upnp:class><upnp:albumArtURI dlna:profileID=\"JPEG_SM\">http://192.168.1.42:8096/Items/f137a2dd21bbc1b99aa5c0f6bf02a805/Images/Primary/0/82c951330ab3f44c25ff6fb2a8300b32/jpg/480/480/0/0</upnp:albumArtURI><upnp:icon>http://192.168.1.42:8096/Items/f137a2dd21bbc1b99aa5c0f6bf02a805/Images/Primary/0/82c951330ab3f44c25ff6fb2a8300b32/jpg/48/48/0/0</upnp:icon><res protocolInfo=\"http-get:*:image/jpeg:DLNA.ORG_PN=JPEG_LRG;DLNA.ORG_OP=00;DLNA.ORG_CI=0;DLNA.ORG_FLAGS=00D00000000000000000000000000000\" resolution=\"960x540\">http://192.168.1.42:8096/Items/f137a2dd21bbc1b99aa5c0f6bf02a805/Images/Primary/0/82c951330ab3f44c25ff6fb2a8300b32/jpg/4096/4096/0/0</res><res protocolInfo=\"http-get:*:image/jpeg:DLNA.ORG_PN=JPEG_MED;DLNA.ORG_OP=00;DLNA.ORG_CI=0;DLNA.ORG_FLAGS=00D00000000000000000000000000000\" resolution=\"960x540\">http://192.168.1.42:8096/Items/f137a2dd21bbc1b99aa5c0f6bf02a805/Images/Primary/0/82c951330ab3f44c25ff6fb2a8300b32/jpg/1024/768/0/0</res><res protocolInfo=\"http-get:*:image/jpeg:DLNA.ORG_PN=JPEG_SM;DLNA.ORG_OP=00;DLNA.ORG_CI=0;DLNA.ORG_FLAGS=00D00000000000000000000000000000\" resolution=\"640x360\">http://192.168.1.42:8096/Items/f137a2dd21bbc1b99aa5c0f6bf02a805/Images/Primary/0/82c951330ab3f44c25ff6fb2a8300b32/jpg/640/480/0/0</res><res protocolInfo=\"http-get:*:image/png:DLNA.ORG_PN=PNG_LRG;DLNA.ORG_OP=00;DLNA.ORG_CI=0;DLNA.ORG_FLAGS=00D00000000000000000000000000000\" resolution=\"960x540\">http://192.168.1.42:8096/Items/f137a2dd21bbc1b99aa5c0f6bf02a805/Images/Primary/0/82c951330ab3f44c25ff6fb2a8300b32/png/4096/4096/0/0</res><res protocolInfo=\"http-get:*:image/png:DLNA.ORG_PN=PNG_TN;DLNA.ORG_OP=00;DLNA.ORG_CI=0;DLNA.ORG_FLAGS=00D00000000000000000000000000000\" resolution=\"160x90\">http://192.168.1.42:8096/Items/f137a2dd21bbc1b99aa5c0f6bf02a805/Images/Primary/0/82c951330ab3f44c25ff6fb2a8300b32/png/160/160/0/0</res><res protocolInfo=\"http-get:*:image/jpeg:DLNA.ORG_PN=JPEG_TN;DLNA.ORG_OP=00;DLNA.ORG_CI=0;DLNA.ORG_FLAGS=00D00000000000000000000000000000\" resolution=\"160x90\">http://192.168.1.42:8096/Items/f137a2dd21bbc1b99aa5c0f6bf02a805/Images/Primary/0/82c951330ab3f44c25ff6fb2a8300b32/jpg/160/160/0/0</res></container>",
+  NULL
+};
+
+// Serviio, 3 objects
+static const char *const serviioObjects[] = {
+  "<container childCount=\"10\" id=\"A\" parentID=\"0\" restricted=\"1\" searchable=\"0\"><dc:title>Audio</dc:title><upnp:class>object.container</upnp:class></container>",
+  "<container childCount=\"5\" id=\"I\" parentID=\"0\" restricted=\"1\" searchable=\"0\"><dc:title>Image</dc:title><upnp:class>object.container</upnp:class></container>",
+  "<container childCount=\"7\" id=\"V\" parentID=\"0\" restricted=\"1\" searchable=\"0\"><dc:title>Video</dc:title><upnp:class>object.container</upnp:class></container>",
+  NULL
+};
+
+// UMS, 5 objects
+static const char *const umsObjects[] = {
+  "<item id=\"1589\" parentID=\"1567\" restricted=\"1\"><dc:title>Excuse me Mr.</dc:title><upnp:album>Car-CD 1</upnp:album><upnp:artist>Ben Harper</upnp:artist><dc:creator>Ben Harper</dc:creator><upnp:playbackCount>0</upnp:playbackCount><res xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\" protocolInfo=\"http-get:*:audio/mpeg:DLNA.ORG_PN=MP3;DLNA.ORG_OP=01\" bitrate=\"319700\" duration=\"0:04:54.817\" sampleFrequency=\"44100\" nrAudioChannels=\"2\" bitsPerSample=\"16\" size=\"11870222\">http://192.168.1.42:5001/get/1589/01+Ben+Harper-+Excuse+me+Mr.mp3</res><res size=\"21299\" resolution=\"300x300\" xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\" protocolInfo=\"http-get:*:image/jpeg:DLNA.ORG_PN=JPEG_RES_300_300;DLNA.ORG_FLAGS=00900000000000000000000000000000\">http://192.168.1.42:5001/get/1589/thumbnail0000JPEG_RES300x300_01+Ben+Harper-+Excuse+me+Mr.mp3.jpg</res><res size=\"21299\" resolution=\"300x300\" xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\" protocolInfo=\"http-get:*:image/jpeg:DLNA.ORG_PN=JPEG_SM;DLNA.ORG_FLAGS=00900000000000000000000000000000\">http://192.168.1.42:5001/get/1589/thumbnail0000JPEG_SM_01+Ben+Harper-+Excuse+me+Mr.mp3.jpg</res><res resolution=\"160x160\" xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\" protocolInfo=\"http-get:*:image/jpeg:DLNA.ORG_PN=JPEG_TN;DLNA.ORG_CI=1;DLNA.ORG_FLAGS=00900000000000000000000000000000\">http://192.168.1.42:5001/get/1589/thumbnail0000JPEG_TN_01+Ben+Harper-+Excuse+me+Mr.mp3.jpg</res><res resolution=\"300x300\" xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\" protocolInfo=\"http-get:*:image/png:DLNA.ORG_PN=PNG_LRG;DLNA.ORG_CI=1;DLNA.ORG_FLAGS=00900000000000000000000000000000\">http://192.168.1.42:5001/get/1589/thumbnail0000PNG_LRG_01+Ben+Harper-+Excuse+me+Mr.mp3.png</res><res resolution=\"160x160\" xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\" protocolInfo=\"http-get:*:image/png:DLNA.ORG_PN=PNG_TN;DLNA.ORG_CI=1;DLNA.ORG_FLAGS=00900000000000000000000000000000\">http://192.168.1.42:5001/get/1589/thumbnail0000PNG_TN_01+Ben+Harper-+Excuse+me+Mr.mp3.png</res><upnp:albumArtURI dlna:profileID=\"JPEG_SM\" xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\">http://192.168.1.42:5001/get/1589/thumbnail0000JPEG_SM_01+Ben+Harper-+Excuse+me+Mr.mp3.jpg</upnp:albumArtURI><upnp:albumArtURI dlna:profileID=\"JPEG_TN\" xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\">http://192.168.1.42:5001/get/1589/thumbnail0000JPEG_TN_01+Ben+Harper-+Excuse+me+Mr.mp3.jpg</upnp:albumArtURI><upnp:albumArtURI dlna:profileID=\"PNG_LRG\" xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\">http://192.168.1.42:5001/get/1589/thumbnail0000PNG_LRG_01+Ben+Harper-+Excuse+me+Mr.mp3.png</upnp:albumArtURI><upnp:albumArtURI dlna:profileID=\"PNG_TN\" xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\">http://192.168.1.42:5001/get/1589/thumbnail0000PNG_TN_01+Ben+Harper-+Excuse+me+Mr.mp3.png</upnp:albumArtURI><dc:date>2017-10-04T18:11:09</dc:date><upnp:class>object.item.audioItem.musicTrack</upnp:class></item>",
+  "<item id=\"1590\" parentID=\"1567\" restricted=\"1\"><dc:title>Sick And Tired</dc:title><upnp:album>Car-CD 1</upnp:album><upnp:artist>Anastacia</upnp:artist><dc:creator>Anastacia</dc:creator><upnp:playbackCount>0</upnp:playbackCount><res xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\" protocolInfo=\"http-get:*:audio/mpeg:DLNA.ORG_PN=MP3;DLNA.ORG_OP=01\" bitrate=\"320000\" duration=\"0:03:28.320\" sampleFrequency=\"48000\" nrAudioChannels=\"2\" bitsPerSample=\"16\" size=\"8348435\">http://192.168.1.42:5001/get/1590/02+Anastacia+-+Sick+And+Tired.mp3</res><res size=\"13831\" resolution=\"300x300\" xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\" protocolInfo=\"http-get:*:image/jpeg:DLNA.ORG_PN=JPEG_RES_300_300;DLNA.ORG_FLAGS=00900000000000000000000000000000\">http://192.168.1.42:5001/get/1590/thumbnail0000JPEG_RES300x300_02+Anastacia+-+Sick+And+Tired.mp3.jpg</res><res size=\"13831\" resolution=\"300x300\" xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\" protocolInfo=\"http-get:*:image/jpeg:DLNA.ORG_PN=JPEG_SM;DLNA.ORG_FLAGS=00900000000000000000000000000000\">http://192.168.1.42:5001/get/1590/thumbnail0000JPEG_SM_02+Anastacia+-+Sick+And+Tired.mp3.jpg</res><res resolution=\"160x160\" xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\" protocolInfo=\"http-get:*:image/jpeg:DLNA.ORG_PN=JPEG_TN;DLNA.ORG_CI=1;DLNA.ORG_FLAGS=00900000000000000000000000000000\">http://192.168.1.42:5001/get/1590/thumbnail0000JPEG_TN_02+Anastacia+-+Sick+And+Tired.mp3.jpg</res><res resolution=\"300x300\" xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\" protocolInfo=\"http-get:*:image/png:DLNA.ORG_PN=PNG_LRG;DLNA.ORG_CI=1;DLNA.ORG_FLAGS=00900000000000000000000000000000\">http://192.168.1.42:5001/get/1590/thumbnail0000PNG_LRG_02+Anastacia+-+Sick+And+Tired.mp3.png</res><res resolution=\"160x160\" xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\" protocolInfo=\"http-get:*:image/png:DLNA.ORG_PN=PNG_TN;DLNA.ORG_CI=1;DLNA.ORG_FLAGS=00900000000000000000000000000000\">http://192.168.1.42:5001/get/1590/thumbnail0000PNG_TN_02+Anastacia+-+Sick+And+Tired.mp3.png</res><upnp:albumArtURI dlna:profileID=\"JPEG_SM\" xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\">http://192.168.1.42:5001/get/1590/thumbnail0000JPEG_SM_02+Anastacia+-+Sick+And+Tired.mp3.jpg</upnp:albumArtURI><upnp:albumArtURI dlna:profileID=\"JPEG_TN\" xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\">http://192.168.1.42:5001/get/1590/thumbnail0000JPEG_TN_02+Anastacia+-+Sick+And+Tired.mp3.jpg</upnp:albumArtURI><upnp:albumArtURI dlna:profileID=\"PNG_LRG\" xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\">http://192.168.1.42:5001/get/1590/thumbnail0000PNG_LRG_02+Anastacia+-+Sick+And+Tired.mp3.png</upnp:albumArtURI><upnp:albumArtURI dlna:profileID=\"PNG_TN\" xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\">http://192.168.1.42:5001/get/1590/thumbnail0000PNG_TN_02+Anastacia+-+Sick+And+Tired.mp3.png</upnp:albumArtURI><dc:date>2021-02-04T16:54:46</dc:date><upnp:class>object.item.audioItem.musicTrack</upnp:class></item>",
+  "<item id=\"1593\" parentID=\"1567\" restricted=\"1\"><dc:title>Wicked Games</dc:title><upnp:album>Car-CD 2</upnp:album><upnp:artist>Chris Isaac</upnp:artist><dc:creator>Chris Isaac</dc:creator><upnp:playbackCount>0</upnp:playbackCount><res xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\" protocolInfo=\"http-get:*:audio/mpeg:DLNA.ORG_PN=MP3;DLNA.ORG_OP=01\" bitrate=\"128000\" duration=\"0:04:48.694\" sampleFrequency=\"44100\" nrAudioChannels=\"2\" bitsPerSample=\"16\" size=\"4644994\">http://192.168.1.42:5001/get/1593/03+Chris+Isaac+-+Wicked+Games.mp3</res><res size=\"13788\" resolution=\"300x300\" xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\" protocolInfo=\"http-get:*:image/jpeg:DLNA.ORG_PN=JPEG_RES_300_300;DLNA.ORG_FLAGS=00900000000000000000000000000000\">http://192.168.1.42:5001/get/1593/thumbnail0000JPEG_RES300x300_03+Chris+Isaac+-+Wicked+Games.mp3.jpg</res><res size=\"13788\" resolution=\"300x300\" xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\" protocolInfo=\"http-get:*:image/jpeg:DLNA.ORG_PN=JPEG_SM;DLNA.ORG_FLAGS=00900000000000000000000000000000\">http://192.168.1.42:5001/get/1593/thumbnail0000JPEG_SM_03+Chris+Isaac+-+Wicked+Games.mp3.jpg</res><res resolution=\"160x160\" xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\" protocolInfo=\"http-get:*:image/jpeg:DLNA.ORG_PN=JPEG_TN;DLNA.ORG_CI=1;DLNA.ORG_FLAGS=00900000000000000000000000000000\">http://192.168.1.42:5001/get/1593/thumbnail0000JPEG_TN_03+Chris+Isaac+-+Wicked+Games.mp3.jpg</res><res resolution=\"300x300\" xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\" protocolInfo=\"http-get:*:image/png:DLNA.ORG_PN=PNG_LRG;DLNA.ORG_CI=1;DLNA.ORG_FLAGS=00900000000000000000000000000000\">http://192.168.1.42:5001/get/1593/thumbnail0000PNG_LRG_03+Chris+Isaac+-+Wicked+Games.mp3.png</res><res resolution=\"160x160\" xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\" protocolInfo=\"http-get:*:image/png:DLNA.ORG_PN=PNG_TN;DLNA.ORG_CI=1;DLNA.ORG_FLAGS=00900000000000000000000000000000\">http://192.168.1.42:5001/get/1593/thumbnail0000PNG_TN_03+Chris+Isaac+-+Wicked+Games.mp3.png</res><upnp:albumArtURI dlna:profileID=\"JPEG_SM\" xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\">http://192.168.1.42:5001/get/1593/thumbnail0000JPEG_SM_03+Chris+Isaac+-+Wicked+Games.mp3.jpg</upnp:albumArtURI><upnp:albumArtURI dlna:profileID=\"JPEG_TN\" xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\">http://192.168.1.42:5001/get/1593/thumbnail0000JPEG_TN_03+Chris+Isaac+-+Wicked+Games.mp3.jpg</upnp:albumArtURI><upnp:albumArtURI dlna:profileID=\"PNG_LRG\" xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\">http://192.168.1.42:5001/get/1593/thumbnail0000PNG_LRG_03+Chris+Isaac+-+Wicked+Games.mp3.png</upnp:albumArtURI><upnp:albumArtURI dlna:profileID=\"PNG_TN\" xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\">http://192.168.1.42:5001/get/1593/thumbnail0000PNG_TN_03+Chris+Isaac+-+Wicked+Games.mp3.png</upnp:albumArtURI><dc:date>2021-02-04T17:04:12</dc:date><upnp:class>object.item.audioItem.musicTrack</upnp:class></item>",
+  "<container id=\"1585\" childCount=\"1\" parentID=\"1567\" restricted=\"1\"><dc:title>Car-CD1</dc:title><res xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\" protocolInfo=\"http-get:*:image/jpeg:DLNA.ORG_PN=JPEG_SM;DLNA.ORG_FLAGS=00900000000000000000000000000000\">http://192.168.1.42:5001/get/1585/thumbnail0000JPEG_SM_Car-CD1.jpg</res><res xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\" protocolInfo=\"http-get:*:image/jpeg:DLNA.ORG_PN=JPEG_TN;DLNA.ORG_FLAGS=00900000000000000000000000000000\">http://192.168.1.42:5001/get/1585/thumbnail0000JPEG_TN_Car-CD1.jpg</res><res xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\" protocolInfo=\"http-get:*:image/png:DLNA.ORG_PN=PNG_LRG;DLNA.ORG_FLAGS=00900000000000000000000000000000\">http://192.168.1.42:5001/get/1585/thumbnail0000PNG_LRG_Car-CD1.png</res><res xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\" protocolInfo=\"http-get:*:image/png:DLNA.ORG_PN=PNG_TN;DLNA.ORG_FLAGS=00900000000000000000000000000000\">http://192.168.1.42:5001/get/1585/thumbnail0000PNG_TN_Car-CD1.png</res><upnp:albumArtURI dlna:profileID=\"JPEG_SM\" xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\">http://192.168.1.42:5001/get/1585/thumbnail0000JPEG_SM_Car-CD1.jpg</upnp:albumArtURI><upnp:albumArtURI dlna:profileID=\"JPEG_TN\" xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\">http://192.168.1.42:5001/get/1585/thumbnail0000JPEG_TN_Car-CD1.jpg</upnp:albumArtURI><upnp:albumArtURI dlna:profileID=\"PNG_LRG\" xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\">http://192.168.1.42:5001/get/1585/thumbnail0000PNG_LRG_Car-CD1.png</upnp:albumArtURI><upnp:albumArtURI dlna:profileID=\"PNG_TN\" xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\">http://192.168.1.42:5001/get/1585/thumbnail0000PNG_TN_Car-CD1.png</upnp:albumArtURI><dc:date>2022-01-13T15:18:29</dc:date><upnp:class>object.container.storageFolder</upnp:class></container>",
+  "<container id=\"1586\" childCount=\"1\" parentID=\"1567\" restricted=\"1\"><dc:title>Deutsch Pop</dc:title><res xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\" protocolInfo=\"http-get:*:image/jpeg:DLNA.ORG_PN=JPEG_SM;DLNA.ORG_FLAGS=00900000000000000000000000000000\">http://192.168.1.42:5001/get/1586/thumbnail0000JPEG_SM_Deutsch+Pop.jpg</res><res xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\" protocolInfo=\"http-get:*:image/jpeg:DLNA.ORG_PN=JPEG_TN;DLNA.ORG_FLAGS=00900000000000000000000000000000\">http://192.168.1.42:5001/get/1586/thumbnail0000JPEG_TN_Deutsch+Pop.jpg</res><res xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\" protocolInfo=\"http-get:*:image/png:DLNA.ORG_PN=PNG_LRG;DLNA.ORG_FLAGS=00900000000000000000000000000000\">http://192.168.1.42:5001/get/1586/thumbnail0000PNG_LRG_Deutsch+Pop.png</res><res xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\" protocolInfo=\"http-get:*:image/png:DLNA.ORG_PN=PNG_TN;DLNA.ORG_FLAGS=00900000000000000000000000000000\">http://192.168.1.42:5001/get/1586/thumbnail0000PNG_TN_Deutsch+Pop.png</res><upnp:albumArtURI dlna:profileID=\"JPEG_SM\" xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\">http://192.168.1.42:5001/get/1586/thumbnail0000JPEG_SM_Deutsch+Pop.jpg</upnp:albumArtURI><upnp:albumArtURI dlna:profileID=\"JPEG_TN\" xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\">http://192.168.1.42:5001/get/1586/thumbnail0000JPEG_TN_Deutsch+Pop.jpg</upnp:albumArtURI><upnp:albumArtURI dlna:profileID=\"PNG_LRG\" xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\">http://192.168.1.42:5001/get/1586/thumbnail0000PNG_LRG_Deutsch+Pop.png</upnp:albumArtURI><upnp:albumArtURI dlna:profileID=\"PNG_TN\" xmlns:dlna=\"urn:schemas-dlna-org:metadata-1-0/\">http://192.168.1.42:5001/get/1586/thumbnail0000PNG_TN_Deutsch+Pop.png</upnp:albumArtURI><dc:date>2022-01-13T15:18:22</dc:date><upnp:class>object.container.storageFolder</upnp:class></container>",
+  NULL
+};
+
+// Twonky, 3 objects
+static const char *const twonkyObjects[] = {
+  "<container id=\"0$1\" parentID=\"0\" restricted=\"1\" childCount=\"11\" searchable=\"1\"><dc:title>Music</dc:title><pv:modificationTime>1642257790</pv:modificationTime><upnp:class>object.container</upnp:class></container>",
+  "<container id=\"0$2\" parentID=\"0\" restricted=\"1\" childCount=\"8\" searchable=\"1\"><dc:title>Photos</dc:title><pv:modificationTime>1642257791</pv:modificationTime><upnp:class>object.container</upnp:class></container>",
+  "<container id=\"0$3\" parentID=\"0\" restricted=\"1\" childCount=\"7\" searchable=\"1\"><dc:title>Videos</dc:title><pv:modificationTime>1642257849</pv:modificationTime><upnp:class>object.container</upnp:class></container>",
+  NULL
+};
+
+// Subsonic, 5 objects
+static const char *const subsonicObjects[] = {
+  "<item id=\"3\" parentID=\"1\" restricted=\"1\"><dc:title>Forever Young</dc:title><upnp:class>object.item.audioItem.musicTrack</upnp:class><upnp:album>Car-CD 3</upnp:album><upnp:artist>Alphaville</upnp:artist><upnp:originalTrackNumber/><upnp:albumArtURI>http://192.168.1.42:4040/coverArt.view?id=1&auth=687401351&size=300</upnp:albumArtURI><dc:description/><res duration=\"0:03:46.0\" protocolInfo=\"http-get:*:audio/mpeg:*\">http://192.168.1.42:4040/stream?id=3&auth=305343284&player=6</res></item>",
+  "<item id=\"4\" parentID=\"1\" restricted=\"1\"><dc:title>This Is The Life</dc:title><upnp:class>object.item.audioItem.musicTrack</upnp:class><upnp:album>Car-CD 2</upnp:album><upnp:artist>Amy Macdonald</upnp:artist><upnp:originalTrackNumber/><upnp:genre>Pop</upnp:genre><upnp:albumArtURI>http://192.168.1.42:4040/coverArt.view?id=1&auth=687401351&size=300</upnp:albumArtURI><dc:date>2007-01-01</dc:date><dc:description/><res duration=\"0:03:06.0\" protocolInfo=\"http-get:*:audio/mpeg:*\">http://192.168.1.42:4040/stream?id=4&auth=1914176139&player=6</res></item>",
+  "<item id=\"5\" parentID=\"1\" restricted=\"1\"><dc:title>Excuse me Mr.</dc:title><upnp:class>object.item.audioItem.musicTrack</upnp:class><upnp:album>Car-CD 1</upnp:album><upnp:artist>Ben Harper</upnp:artist><upnp:originalTrackNumber/><upnp:albumArtURI>http://192.168.1.42:4040/coverArt.view?id=1&auth=687401351&size=300</upnp:albumArtURI><dc:description/><res duration=\"0:04:54.0\" protocolInfo=\"http-get:*:audio/mpeg:*\">http://192.168.1.42:4040/stream?id=5&auth=1963081628&player=6</res></item>",
+  "<container childCount=\"8\" id=\"folder-72\" parentID=\"1\" restricted=\"1\" searchable=\"0\"><dc:title>Deutsch Pop</dc:title><upnp:class>object.container.album.musicAlbum</upnp:class><upnp:albumArtURI>http://192.168.1.42:4040/coverArt.view?id=72&auth=1979787348&size=300</upnp:albumArtURI><upnp:artist>Adel Tawil</upnp:artist><dc:description/></container>",
+  "<container childCount=\"4\" id=\"folder-68\" parentID=\"1\" restricted=\"1\" searchable=\"0\"><dc:title>Car-CD1</dc:title><upnp:class>object.container.album.musicAlbum</upnp:class><upnp:albumArtURI>http://192.168.1.42:4040/coverArt.view?id=68&auth=52828418&size=300</upnp:albumArtURI><upnp:artist>Ben Harper</upnp:artist><dc:description/></container>",
+  NULL
+};
+
+// Kodi, 3 objects
+static const char *const kodiObjects[] = {
+  "<container id=\"musicdb://\" parentID=\"0\" restricted=\"1\" searchable=\"0\"><dc:title>Music Library</dc:title><dc:creator>Unknown</dc:creator><dc:publisher>Unknown</dc:publisher><upnp:genre>Unknown</upnp:genre><upnp:episodeSeason>0</upnp:episodeSeason><xbmc:rating>0.0</xbmc:rating><xbmc:userrating>0</xbmc:userrating><upnp:class>object.container</upnp:class></container>",
+  "<container id=\"library://video/\" parentID=\"0\" restricted=\"1\" searchable=\"0\"><dc:title>Video Library</dc:title><dc:creator>Unknown</dc:creator><dc:publisher>Unknown</dc:publisher><upnp:genre>Unknown</upnp:genre><upnp:episodeSeason>0</upnp:episodeSeason><xbmc:rating>0.0</xbmc:rating><xbmc:userrating>0</xbmc:userrating><upnp:class>object.container</upnp:class></container>",
+  "<container id=\"musicdb://\" parentID=\"0\" restricted=\"1\" searchable=\"0\"><dc:title>Music Library</dc:title><dc:creator>Unknown</dc:creator><dc:publisher>Unknown</dc:publisher><upnp:genre>Unknown</upnp:genre><upnp:episodeSeason>0</upnp:episodeSeason><xbmc:rating>0.0</xbmc:rating><xbmc:userrating>0</xbmc:userrating><upnp:class>object.container</upnp:class></container>",
+  NULL
+};
+
+// MediaPlayer, 3 objects
+static const char *const mediaPlayerObjects[] = {
+  "<container id=\"3\" restricted=\"1\" parentID=\"0\" childCount=\"7\" searchable=\"1\"><dc:title>Bilder</dc:title><upnp:class name=\"object.container\">object.container</upnp:class><upnp:writeStatus>NOT_WRITABLE</upnp:writeStatus><upnp:searchClass includeDerived=\"0\">object.container.playlistContainer</upnp:searchClass><upnp:searchClass includeDerived=\"0\">object.item.imageItem.photo</upnp:searchClass><upnp:searchClass includeDerived=\"0\">object.container.album.photoAlbum</upnp:searchClass><upnp:searchClass includeDerived=\"0\">object.container</upnp:searchClass><upnp:searchClass includeDerived=\"0\">object.container.storageFolder</upnp:searchClass><upnp:searchClass includeDerived=\"0\">object.container.album.photoAlbum.dateTaken</upnp:searchClass><upnp:searchClass includeDerived=\"1\">object.container.album</upnp:searchClass><upnp:searchClass includeDerived=\"1\">object.item.imageItem</upnp:searchClass></container>",
+  "<container id=\"1\" restricted=\"1\" parentID=\"0\" childCount=\"10\" searchable=\"1\"><dc:title>Musik</dc:title><upnp:class name=\"object.container\">object.container</upnp:class><upnp:writeStatus>NOT_WRITABLE</upnp:writeStatus><upnp:searchClass includeDerived=\"1\">object.item.audioItem</upnp:searchClass><upnp:searchClass includeDerived=\"0\">object.container.playlistContainer</upnp:searchClass><upnp:searchClass includeDerived=\"0\">object.container</upnp:searchClass><upnp:searchClass includeDerived=\"1\">object.container.genre</upnp:searchClass><upnp:searchClass includeDerived=\"0\">object.container.storageFolder</upnp:searchClass><upnp:searchClass includeDerived=\"0\">object.container.genre.musicGenre</upnp:searchClass><upnp:searchClass includeDerived=\"0\">object.item.audioItem.musicTrack</upnp:searchClass><upnp:searchClass includeDerived=\"0\">object.container.album.musicAlbum</upnp:searchClass><upnp:searchClass includeDerived=\"0\">object.item.audioItem.audioBook</upnp:searchClass><upnp:searchClass includeDerived=\"1\">object.container.album</upnp:searchClass><upnp:searchClass includeDerived=\"0\">object.container.person.musicArtist</upnp:searchClass></container>",
+  "<container id=\"2\" restricted=\"1\" parentID=\"0\" childCount=\"8\" searchable=\"1\"><dc:title>Videos</dc:title><upnp:class name=\"object.container\">object.container</upnp:class><upnp:writeStatus>NOT_WRITABLE</upnp:writeStatus><upnp:searchClass includeDerived=\"0\">object.container.album.videoAlbum</upnp:searchClass><upnp:searchClass includeDerived=\"0\">object.item.videoItem.musicVideoClip</upnp:searchClass><upnp:searchClass includeDerived=\"0\">object.container</upnp:searchClass><upnp:searchClass includeDerived=\"0\">object.item.videoItem.videoBroadcast</upnp:searchClass><upnp:searchClass includeDerived=\"0\">object.container.person.movieActor</upnp:searchClass><upnp:searchClass includeDerived=\"1\">object.container.album</upnp:searchClass><upnp:searchClass includeDerived=\"0\">object.item.videoItem.movie</upnp:searchClass><upnp:searchClass includeDerived=\"1\">object.container.genre</upnp:searchClass><upnp:searchClass includeDerived=\"1\">object.item.videoItem</upnp:searchClass><upnp:searchClass includeDerived=\"0\">object.container.playlistContainer</upnp:searchClass><upnp:searchClass includeDerived=\"0\">object.container.genre.movieGenre</upnp:searchClass><upnp:searchClass includeDerived=\"0\">object.container.storageFolder</upnp:searchClass></container>",
+  NULL
+};
+
+static const benchFlavour_t flavours[] = {
+  { "Plex", "UPnP/1.0 DLNADOC/1.50 Platinum/1.0.5.13", "0", plexObjects },
+  { "Jellyfin", "Kestrel", "e9d5075a555c1cbc394eec4cef295274", jellyfinObjects },
+  { "Serviio", "Windows_10 UPnP/1.0 DLNADOC/1.50 Serviio/2.2.1", "0", serviioObjects },
+  { "UMS", "Windows_10-amd64-10.0, UPnP/1.0 DLNADOC/1.50, UMS/10.14.1", "1567", umsObjects },
+  { "Twonky", "Linux/2.x.x, UPnP/1.0, pvConnect UPnP SDK/1.0, TwonkyMedia UPnP SDK/1.1", "0", twonkyObjects },
+  { "Subsonic", "Windows10/10.0 UPnP/1.0 Cling/2.0", "1", subsonicObjects },
+  { "Kodi", "UPnP/1.0 DLNADOC/1.50 Kodi", "0", kodiObjects },
+  { "MediaPlayer", "Microsoft-Windows/10.0 UPnP/1.0 UPnP-Device-Host/1.0 Microsoft-HTTPAPI/2.0", "0", mediaPlayerObjects },
+};
+
+#endif
@@ -11,7 +11,9 @@
 
   If a directory contains more entries than that number, you have to browse
   that directory multiple times, each time with a higher starting index
-  (0, 100, 200,...). This sketch demonstrates how to do it.
+  (0, 100, 200,...). This sketch demonstrates how to do it with the aid of 
+  a browse cursor (browseBegin()/browseNext()), which keeps track of the
+  starting index and the total number of entries reported by the server.
     
   Last updated 2022-01-15, ThJ <yellobyte@bluewin.ch>
 */
@@ -105,9 +107,10 @@ void setup() {
   Serial.println();
 
   // start searching all servers for a big directory
-  soapObject_t     directory;
-  soapObjectVect_t directoryContent;
-  soapServer_t     srvInfo;
+  soapObject_t       directory;
+  soapObjectVect_t   directoryContent;
+  soapServer_t       srvInfo;
+  soapBrowseCursor_t cursor;
   int srvNum = 0,             // start with first server in list
       startingIndex;
 
@@ -116,18 +119,18 @@ void setup() {
     Serial.print("Please be patient, searching big directory on server: ");
     Serial.println(srvInfo.friendlyName);
     
-    startingIndex = 0;        // start browsing a directory with offset 0
     directory.id = "0";       // start with root ("0")
     directory.name = "root";  // only needed for printing in case of error
     
     if (findBigDirectory(&soap, srvNum, &directory)) {
-      // found big directory, now print entire content 
-      while (startingIndex < directory.size) {
+      // found big directory, now print entire content page by page
+      soap.browseBegin(&cursor, srvNum, directory.id.c_str());
+      while (!cursor.complete) {
+        startingIndex = cursor.startingIndex;
         Serial.print("------> Browse directory with starting index: ");
         Serial.println(startingIndex);
-        // browse directory with increasing starting index
-        if (!soap.browseServer(srvNum, directory.id.c_str(), 
-                               &directoryContent, startingIndex) ||
+        // cursor increases starting index with each call
+        if (!soap.browseNext(&cursor, &directoryContent) ||
             directoryContent.size() == 0) {
           // function returned error or directory is empty    
           Serial.print("Error browsing directory with name: ");
@@ -135,6 +138,10 @@ void setup() {
           break;
         }
         else {
+          if (startingIndex == 0) {
+            Serial.print("------> Total number of entries reported by server: ");
+            Serial.println(cursor.totalMatches);
+          }
           // show all entries in list
           for (int i = 0; i < directoryContent.size(); i++) {
             // print object count
@@ -160,8 +167,6 @@ void setup() {
               Serial.println(soap.getFileTypeName(directoryContent[i].fileType));
             }
           }
-          // increase index to get next chunk
-          startingIndex += directoryContent.size();
         }  
       }
       break;
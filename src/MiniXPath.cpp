@@ -5,6 +5,7 @@
   - extracting attributes
   - extracting whole sub trees if requested
   - using C++ strings
+  - scanning for multiple paths in a single pass (MiniXPathMulti)
 */
 
 #include "MiniXPath.h"
@@ -249,3 +250,191 @@ bool MiniXPath::elementPathMatch()
          level < pathSize &&
          matchCount == strlen(path[level]);
 }
+
+//
+// MiniXPathMulti
+//
+MiniXPathMulti::MiniXPathMulti()
+{
+  this->paths = NULL;
+  this->pathCount = 0;
+  this->enabled = 0;
+  reset();
+}
+
+void MiniXPathMulti::reset()
+{
+  state = XML_PARSER_UNINITIATED;
+  level = 0;
+  textLevel = 0;
+  nameLength = 0;
+  quote = 0;
+  emptyTag = false;
+  collectAttrib = false;
+  memset(matchMask, 0, sizeof(matchMask));
+  matchMask[0] = enabled & ((pathCount >= XPATH_MULTI_MAX_PATHS) ? 0xFFFFFFFF : ((uint32_t)1 << pathCount) - 1);
+}
+
+void MiniXPathMulti::setPaths(const xPathParser_t *paths, uint8_t num, uint32_t enabled)
+{
+  this->paths = paths;
+  this->enabled = enabled;
+  this->pathCount = (num > XPATH_MULTI_MAX_PATHS) ? XPATH_MULTI_MAX_PATHS : num;
+  reset();
+}
+
+// returns index of lowest path that ends exactly on given level
+int MiniXPathMulti::fullMatch(uint8_t lev)
+{
+  if (lev == 0 || lev > XPATH_MULTI_MAX_LEVEL) return XPATH_MULTI_NO_MATCH;
+  for (uint8_t i = 0; i < pathCount; i++) {
+    if ((matchMask[lev] & ((uint32_t)1 << i)) && paths[i].num == lev) return i;
+  }
+  return XPATH_MULTI_NO_MATCH;
+}
+
+// start tag name complete: narrow down the set of matching paths for the new level
+void MiniXPathMulti::openElement()
+{
+  uint32_t mask = 0;
+  const char *last = NULL;    // paths share their leading tag names (same string literal),
+  bool equal = false;         // so each distinct name gets compared only once
+
+  if (level < XPATH_MULTI_MAX_LEVEL && nameLength < sizeof(tagName)) {
+    tagName[nameLength] = 0;
+    for (uint8_t i = 0; i < pathCount; i++) {
+      if ((matchMask[level] & ((uint32_t)1 << i)) && paths[i].num > level) {
+        if (paths[i].tagNames[level] != last) {
+          last = paths[i].tagNames[level];
+          equal = (strcmp(tagName, last) == 0);
+        }
+        if (equal) mask |= (uint32_t)1 << i;
+      }
+    }
+  }
+  level++;
+  if (level <= XPATH_MULTI_MAX_LEVEL) matchMask[level] = mask;
+  collectAttrib = (fullMatch(level) != XPATH_MULTI_NO_MATCH);
+}
+
+// end tag complete: returns index of path that matches the closed element
+int MiniXPathMulti::closeElement(String *result)
+{
+  int ret = fullMatch(level);
+
+  if (ret != XPATH_MULTI_NO_MATCH) {
+    if (textLevel == level) {
+      result->trim();   // Remove leading/trailing whitespace
+    }
+    else {
+      *result = "";     // content of sub elements is not delivered
+    }
+  }
+  if (textLevel == level) textLevel = 0;
+  if (level > 0) level--;
+  state = (level > 0) ? XML_PARSER_ELEMENT_CONTENT : XML_PARSER_ROOT;
+
+  return ret;
+}
+
+int MiniXPathMulti::getValue(char charToParse, String *result, String *attrib, bool *start)
+{
+  int ret = XPATH_MULTI_NO_MATCH;
+
+  switch (state) {
+    case XML_PARSER_UNINITIATED:
+    case XML_PARSER_ROOT:
+    case XML_PARSER_ELEMENT_CONTENT:
+      if (charToParse == '<') {
+        state = XML_PARSER_START_TAG;
+        nameLength = 0;
+      }
+      else if (textLevel > 0 && textLevel == level) {
+        *result += charToParse;
+      }
+      break;
+    case XML_PARSER_START_TAG:
+      if (charToParse == '/') {
+        state = XML_PARSER_END_TAG;
+        break;
+      }
+      if (charToParse == '?' || charToParse == '!') {
+        state = XML_PARSER_COMMENT;   // prolog & comments are skipped
+        break;
+      }
+      state = XML_PARSER_START_TAG_NAME;
+      emptyTag = false;
+      // first character of tag name
+      // fall through
+    case XML_PARSER_START_TAG_NAME:
+      switch (charToParse) {
+        case ' ':
+        case '\t':
+        case '\r':
+        case '\n':
+        case '>':
+        case '/':
+          openElement();
+          if (collectAttrib) {
+            if (attrib != NULL) *attrib = "";
+            *result = "";
+          }
+          state = XML_PARSER_ATTRIBUTES;
+          goto ATTRIBUTES;
+        case ':':
+          nameLength = 0;    // skip namespace prefix
+          break;
+        default:
+          if (nameLength < sizeof(tagName)) tagName[nameLength++] = charToParse;
+          break;
+      }
+      break;
+    case XML_PARSER_ATTRIBUTES:
+ATTRIBUTES:
+      if (charToParse == '>') {
+        if (collectAttrib) {
+          textLevel = level;
+          ret = fullMatch(level);
+          if (start) *start = true;
+        }
+        state = XML_PARSER_ELEMENT_CONTENT;
+        if (emptyTag) {
+          ret = closeElement(result);
+          if (start) *start = false;
+        }
+        collectAttrib = false;
+        break;
+      }
+      if (charToParse == '/') {
+        emptyTag = true;
+        break;
+      }
+      if (charToParse == '"' || charToParse == '\'') {
+        quote = charToParse;
+        state = XML_PARSER_ATTRIBUTE_VALUE;
+      }
+      if (collectAttrib && attrib != NULL && (attrib->length() > 0 || charToParse > ' ')) {
+        *attrib += (charToParse == '\t' || charToParse == '\r' || charToParse == '\n') ? ' ' : charToParse;
+      }
+      break;
+    case XML_PARSER_ATTRIBUTE_VALUE:
+      if (charToParse == quote) state = XML_PARSER_ATTRIBUTES;
+      if (collectAttrib && attrib != NULL) {
+        *attrib += (charToParse == '\t' || charToParse == '\r' || charToParse == '\n') ? ' ' : charToParse;
+      }
+      break;
+    case XML_PARSER_END_TAG:
+      if (charToParse == '>') {
+        ret = closeElement(result);
+        if (start) *start = false;
+      }
+      break;
+    case XML_PARSER_COMMENT:
+      if (charToParse == '>') {
+        state = (level > 0) ? XML_PARSER_ELEMENT_CONTENT : XML_PARSER_ROOT;
+      }
+      break;
+  }
+
+  return ret;
+}
@@ -5,6 +5,7 @@
   - extracting attributes
   - extracting whole sub trees if requested
   - using C++ strings
+  - scanning for multiple paths in a single pass (MiniXPathMulti)
 */
 
 #ifndef MiniXPath_h
@@ -30,10 +31,16 @@
 
 #define XML_PROLOG "xml"
 
+// longest path (tag names) and deepest element level tracked by MiniXPathMulti, longer paths
+// don't compile. The library uses 7 at most, lower values save 4 bytes per path and level.
+#ifndef XPATH_MULTI_MAX_LEVEL
+#define XPATH_MULTI_MAX_LEVEL             10
+#endif
+
 struct xPathParser_t
 { 
   const uint8_t num; 
-  const char *tagNames[10];   // should be adjusted to fit highest level
+  const char *tagNames[XPATH_MULTI_MAX_LEVEL];
 };
 
 class MiniXPath {
@@ -60,4 +67,43 @@ class MiniXPath {
     bool elementPathMatch();
 };
 
+// MiniXPathMulti: all paths are tracked in a single pass over the XML stream
+#define XPATH_MULTI_MAX_PATHS             32  // limited by size of path bit mask
+#define XPATH_MULTI_TAG_NAME_SIZE         32  // longest tag name (without namespace prefix) we compare
+#define XPATH_MULTI_NO_MATCH              -1
+
+//
+// Tag names in paths are given without namespace prefix, e.g. "Envelope" matches
+// <s:Envelope>, <SOAP-ENV:Envelope> as well as <Envelope>.
+// getValue() returns the index of a path as soon as the start tag (start = true, attributes
+// available) or the end tag (start = false, element content available) of a matching element
+// has been parsed. Empty elements (<tag/>) only report their end.
+//
+class MiniXPathMulti {
+  public:
+    MiniXPathMulti();
+
+    void reset();
+    void setPaths(const xPathParser_t *paths, uint8_t num, uint32_t enabled = 0xFFFFFFFF);
+    int  getValue(char charToParse, String *result, String *attrib = NULL, bool *start = NULL);
+
+  private:
+    const xPathParser_t *paths;
+    uint8_t    pathCount;
+    uint32_t   enabled;       // bit mask of paths we scan for
+    uint8_t    state;
+    uint8_t    level;         // nr of currently open elements
+    uint8_t    textLevel;     // level of matched element whose content we collect, 0 = none
+    uint8_t    nameLength;
+    char       quote;         // quote character of current attribute value
+    bool       emptyTag;      // '/' detected inside start tag
+    bool       collectAttrib; // attributes of current start tag are requested
+    char       tagName[XPATH_MULTI_TAG_NAME_SIZE];
+    uint32_t   matchMask[XPATH_MULTI_MAX_LEVEL + 1];  // paths still matching on each level
+
+    void openElement();
+    int  fullMatch(uint8_t lev);
+    int  closeElement(String *result);
+};
+
 #endif
@@ -0,0 +1,423 @@
+/*
+  SoapArtCache is part of SoapESP32 library, see SoapArtCache.h
+*/
+
+#include "SoapArtCache.h"
+#include <algorithm>
+
+#define SOAP_ART_NAME_LENGTH      16          // file name: 2 x 8 hex digits
+#define SOAP_ART_TMP_SUFFIX       ".tmp"      // download in progress
+#define SOAP_ART_TMP_SUFFIX_TASK  ".p.tmp"    // download of prefetch task in progress
+
+#define claimCache()    xSemaphoreTake(m_lock, portMAX_DELAY)
+#define releaseCache()  xSemaphoreGive(m_lock)
+
+//
+// helper functions: URL hashes (FNV-1a & djb2)
+//
+static uint32_t soapArtHash(const char *str)
+{
+  uint32_t hash = 2166136261u;
+
+  while (*str) {
+    hash ^= (uint8_t)*str++;
+    hash *= 16777619u;
+  }
+
+  return hash;
+}
+
+static uint32_t soapArtCheck(const char *str)
+{
+  uint32_t hash = 5381;
+
+  while (*str) hash = hash * 33 + (uint8_t)*str++;
+
+  return hash;
+}
+
+//
+// constructor, cache directory lives on a file system (SD, LittleFS...)
+//
+SoapArtCache::SoapArtCache(fs::FS &fs, const char *dir, uint32_t budget)
+  : m_fs(fs), m_dir(dir), m_budget(budget), m_begun(false), m_used(0), m_useCount(0),
+    m_task(NULL), m_taskDone(NULL), m_taskRun(false), m_taskSoap(NULL)
+{
+  while (m_dir.endsWith("/")) m_dir.remove(m_dir.length() - 1);
+  memset(&m_pinned, 0, sizeof(m_pinned));
+  m_lock = xSemaphoreCreateMutex();
+}
+
+SoapArtCache::~SoapArtCache()
+{
+  prefetchStop();
+  if (m_taskDone) vSemaphoreDelete(m_taskDone);
+  if (m_lock) vSemaphoreDelete(m_lock);
+}
+
+//
+// read table of cached images from cache directory (called by all other functions),
+// images are considered used in order of directory listing
+//
+bool SoapArtCache::begin()
+{
+  std::vector<String> stale;
+
+  if (m_begun) return true;
+  if (!m_lock) return false;
+  if (!m_fs.exists(m_dir.c_str()) && !m_fs.mkdir(m_dir.c_str())) {
+    log_e("could not create cache directory %s", m_dir.c_str());
+    return false;
+  }
+  File dir = m_fs.open(m_dir.c_str());
+  if (!dir || !dir.isDirectory()) {
+    log_e("%s is not a directory", m_dir.c_str());
+    return false;
+  }
+
+  claimCache();
+  m_entries.clear();
+  m_used = 0;
+  while (File file = dir.openNextFile()) {
+    // older cores return the whole path
+    const char *name = strrchr(file.name(), '/');
+    name = name ? name + 1 : file.name();
+    soapArtEntry_t entry;
+    char end;
+
+    if (strlen(name) > SOAP_ART_NAME_LENGTH && strcmp(name + strlen(name) - 4, SOAP_ART_TMP_SUFFIX) == 0) {
+      stale.push_back(m_dir + "/" + name);   // interrupted download
+    }
+    else if (strlen(name) == SOAP_ART_NAME_LENGTH &&
+             sscanf(name, "%8x%8x%c", (unsigned *)&entry.hash, (unsigned *)&entry.check, &end) == 2) {
+      entry.size = file.size();
+      entry.lastUse = ++m_useCount;
+      m_entries.push_back(entry);
+      m_used += entry.size;
+    }
+    file.close();
+  }
+  dir.close();
+  for (auto &path : stale) m_fs.remove(path.c_str());
+  evict(0);   // budget might have been reduced
+  m_begun = true;
+  releaseCache();
+  log_i("%d cached images, %d bytes", m_entries.size(), m_used);
+
+  return true;
+}
+
+//
+// path of cached image, no download. The image whose path was returned last is never removed
+// to make room for others (e.g. by prefetch task while the image is being displayed)
+//
+bool SoapArtCache::lookup(const char *url, String *path)
+{
+  soapArtEntry_t entry;
+  int i;
+
+  if (!url || !*url || !begin()) return false;
+
+  key(url, &entry);
+  claimCache();
+  if ((i = find(&entry)) >= 0) {
+    m_entries[i].lastUse = ++m_useCount;
+    if (path) pin(&entry);
+  }
+  releaseCache();
+  if (i < 0) return false;
+  if (path) *path = fileName(&entry);
+
+  return true;
+}
+
+//
+// path of cached image, downloaded by soap if not cached yet
+//
+bool SoapArtCache::fetch(SoapESP32 *soap, const char *url, String *path)
+{
+  soapArtEntry_t entry;
+
+  if (lookup(url, path)) return true;
+  if (!soap || !url || !*url) return false;
+
+  key(url, &entry);
+  if (!download(soap, url, &entry, false)) return false;
+  if (path) {
+    claimCache();
+    pin(&entry);
+    releaseCache();
+    *path = fileName(&entry);
+  }
+
+  return true;
+}
+
+//
+// path of cached icon (default) or album art of object, the other one is used if missing
+//
+bool SoapArtCache::fetch(SoapESP32 *soap, const soapObject_t *object, String *path, artVariant_et variant)
+{
+  if (!object) return false;
+
+  const String *url = &object->iconUri, *other = &object->albumArtUri;
+  if (variant == artAlbumArt) std::swap(url, other);
+  if (url->length() == 0) url = other;
+
+  return fetch(soap, url->c_str(), path);
+}
+
+//
+// background download of the images of objects, e.g. while a track list is displayed: icons
+// (album art if missing) of all objects first, then album art if requested. A running prefetch
+// is stopped. soap must not be used otherwise until prefetch has finished, use a session.
+//
+bool SoapArtCache::prefetch(SoapESP32 *soap, const soapObjectVect_t *objects, bool albumArt)
+{
+  if (!soap || !objects || !begin()) return false;
+
+  prefetchStop();
+  m_queue.clear();
+  for (auto &object : *objects) queue(object.iconUri.length() ? object.iconUri : object.albumArtUri);
+  if (albumArt) {
+    for (auto &object : *objects) queue(object.albumArtUri);
+  }
+  if (m_queue.empty()) return true;   // nothing to do
+
+  if (!m_taskDone && !(m_taskDone = xSemaphoreCreateBinary())) return false;
+  m_taskSoap = soap;
+  m_taskRun = true;
+  if (xTaskCreate(prefetchTask, "soapArt", SOAP_ART_TASK_STACK, this, SOAP_ART_TASK_PRIO, &m_task) != pdPASS) {
+    log_e("could not start prefetch task");
+    m_task = NULL;
+    m_taskRun = false;
+    return false;
+  }
+  log_d("prefetch task started, %d URLs", m_queue.size());
+
+  return true;
+}
+
+bool SoapArtCache::prefetchBusy()
+{
+  return m_taskRun;
+}
+
+//
+// stop prefetch task, an image being downloaded is discarded
+//
+void SoapArtCache::prefetchStop()
+{
+  if (!m_task) return;
+
+  m_taskRun = false;
+  xSemaphoreTake(m_taskDone, portMAX_DELAY);
+  m_task = NULL;
+}
+
+//
+// bytes & number of cached images
+//
+uint32_t SoapArtCache::used()
+{
+  uint32_t used;
+
+  if (!begin()) return 0;
+  claimCache();
+  used = m_used;
+  releaseCache();
+
+  return used;
+}
+
+uint32_t SoapArtCache::count()
+{
+  uint32_t count;
+
+  if (!begin()) return 0;
+  claimCache();
+  count = m_entries.size();
+  releaseCache();
+
+  return count;
+}
+
+//
+// remove all cached images
+//
+void SoapArtCache::clear()
+{
+  prefetchStop();
+  if (!begin()) return;
+
+  claimCache();
+  for (auto &entry : m_entries) m_fs.remove(fileName(&entry).c_str());
+  m_entries.clear();
+  m_used = 0;
+  releaseCache();
+}
+
+//
+// helper functions: hashes of URL, path of cached image, table entry (-1: not cached)
+//
+void SoapArtCache::key(const char *url, soapArtEntry_t *entry)
+{
+  entry->hash = soapArtHash(url);
+  entry->check = soapArtCheck(url);
+  entry->size = 0;
+  entry->lastUse = 0;
+}
+
+String SoapArtCache::fileName(const soapArtEntry_t *entry, const char *suffix)
+{
+  char name[SOAP_ART_NAME_LENGTH + 1];
+
+  snprintf(name, sizeof(name), "%08x%08x", (unsigned)entry->hash, (unsigned)entry->check);
+  String path = m_dir + "/";
+  path += name;
+  path += suffix;
+
+  return path;
+}
+
+int SoapArtCache::find(const soapArtEntry_t *entry)
+{
+  for (size_t i = 0; i < m_entries.size(); i++) {
+    if (m_entries[i].hash == entry->hash && m_entries[i].check == entry->check) return i;
+  }
+
+  return -1;
+}
+
+void SoapArtCache::pin(const soapArtEntry_t *entry)
+{
+  m_pinned.hash = entry->hash;
+  m_pinned.check = entry->check;
+}
+
+//
+// helper function: remove least recently used images until size bytes fit into budget (cache claimed),
+// pinned image is kept even if that exceeds the budget
+//
+void SoapArtCache::evict(uint32_t size)
+{
+  int pinned = find(&m_pinned);
+
+  while (m_used + size > m_budget) {
+    int lru = -1;
+
+    for (int i = 0; i < (int)m_entries.size(); i++) {
+      if (i != pinned && (lru < 0 || m_entries[i].lastUse < m_entries[lru].lastUse)) lru = i;
+    }
+    if (lru < 0) break;   // nothing left to remove
+    log_d("removing cached image %s", fileName(&m_entries[lru]).c_str());
+    m_fs.remove(fileName(&m_entries[lru]).c_str());
+    m_used -= m_entries[lru].size;
+    m_entries[lru] = m_entries.back();
+    m_entries.pop_back();
+    if (pinned == (int)m_entries.size()) pinned = lru;   // moved
+  }
+}
+
+//
+// helper function: download image into temporary file, which gets renamed when complete
+//
+bool SoapArtCache::download(SoapESP32 *soap, const char *url, soapArtEntry_t *entry, bool task)
+{
+  uint64_t size;
+  uint32_t total = 0;
+  uint32_t maxSize = std::min((uint32_t)SOAP_ART_MAX_SIZE, m_budget);
+  int res = -1;
+  String tmp = fileName(entry, task ? SOAP_ART_TMP_SUFFIX_TASK : SOAP_ART_TMP_SUFFIX);
+
+  if (!soap->readStart(url, &size)) return false;
+  if (size > maxSize) {
+    log_w("image too big for cache: %llu bytes", size);
+    soap->readStop();
+    return false;
+  }
+
+  uint8_t *buffer = (uint8_t *)malloc(SOAP_ART_BUFFER_SIZE);
+  File file = m_fs.open(tmp.c_str(), FILE_WRITE);
+  if (!buffer || !file) {
+    log_e("%s", !buffer ? "not enough memory" : "could not create temporary file");
+  }
+  else {
+    while ((res = soap->read(buffer, SOAP_ART_BUFFER_SIZE)) > 0) {
+      total += res;
+      if (total > maxSize || (task && !m_taskRun) || file.write(buffer, res) != (size_t)res) {
+        res = -1;
+        break;
+      }
+    }
+  }
+  free(buffer);
+  soap->readStop();
+  if (file) file.close();
+  if (res < 0 || total == 0 || (size > 0 && total != size)) {
+    log_w("image not cached: %s", url);
+    m_fs.remove(tmp.c_str());
+    return false;
+  }
+
+  // image complete, make room & add it (unless added by other task meanwhile)
+  String path = fileName(entry);
+  bool renamed = false;
+  claimCache();
+  if (find(entry) < 0) {
+    evict(total);
+    if (m_fs.exists(path.c_str())) m_fs.remove(path.c_str());   // not in table
+    if ((renamed = m_fs.rename(tmp.c_str(), path.c_str()))) {
+      entry->size = total;
+      entry->lastUse = ++m_useCount;
+      m_entries.push_back(*entry);
+      m_used += total;
+    }
+    else {
+      log_e("could not rename %s", tmp.c_str());
+    }
+  }
+  else {
+    renamed = true;
+    m_fs.remove(tmp.c_str());
+  }
+  releaseCache();
+  if (!renamed) m_fs.remove(tmp.c_str());
+  log_d("%s: %u bytes, %s", url, total, path.c_str());
+
+  return renamed;
+}
+
+//
+// helper function: add URL to prefetch queue (once)
+//
+void SoapArtCache::queue(const String &url)
+{
+  if (url.length() == 0 || m_queue.size() >= SOAP_ART_PREFETCH_MAX) return;
+  if (std::find(m_queue.begin(), m_queue.end(), url) != m_queue.end()) return;
+
+  m_queue.push_back(url);
+}
+
+//
+// prefetch task
+//
+void SoapArtCache::prefetchTask(void *param)
+{
+  SoapArtCache *cache = (SoapArtCache *)param;
+  uint32_t loaded = 0;
+
+  for (size_t i = 0; i < cache->m_queue.size() && cache->m_taskRun; i++) {
+    const char *url = cache->m_queue[i].c_str();
+    soapArtEntry_t entry;
+
+    if (cache->lookup(url, NULL)) continue;   // cached already
+    cache->key(url, &entry);
+    if (cache->download(cache->m_taskSoap, url, &entry, true)) loaded++;
+  }
+  log_d("prefetch task finished, %d images downloaded", loaded);
+  cache->m_taskRun = false;
+
+  xSemaphoreGive(cache->m_taskDone);
+  vTaskDelete(NULL);
+}
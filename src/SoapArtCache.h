@@ -0,0 +1,80 @@
+/*
+  SoapArtCache is part of SoapESP32 library. It downloads album art & icon images of
+  media server objects into a directory of a file system (SD, LittleFS...) and keeps
+  them for reuse. Cached files are named after two hashes of the image URL, the
+  directory is kept within a byte budget by removing least recently used images.
+  A table of cached images is held in RAM (16 bytes per image). prefetch() downloads
+  the images of a list of objects in the background, icons first.
+*/
+
+#ifndef SoapArtCache_h
+#define SoapArtCache_h
+
+#include <FS.h>
+#include "SoapESP32.h"
+
+#define SOAP_ART_CACHE_DIR        "/soapart"          // leftover ".tmp" files are removed by begin()
+#ifndef SOAP_ART_CACHE_BUDGET
+#define SOAP_ART_CACHE_BUDGET     (1024 * 1024)       // bytes of all cached images
+#endif
+#define SOAP_ART_MAX_SIZE         (256 * 1024)        // bigger images are not cached
+#define SOAP_ART_BUFFER_SIZE      1460                // download buffer (heap)
+#define SOAP_ART_PREFETCH_MAX     64                  // max. different URLs queued by prefetch()
+#define SOAP_ART_TASK_STACK       6144
+#define SOAP_ART_TASK_PRIO        1
+
+// image to fetch, if the object has only one URL that one is used
+enum artVariant_et { artIcon = 0, artAlbumArt };
+
+// cached image
+struct soapArtEntry_t
+{
+  uint32_t hash;                // of URL (FNV-1a), first half of file name
+  uint32_t check;               // second hash (djb2), second half of file name
+  uint32_t size;
+  uint32_t lastUse;             // use counter, lowest gets removed first
+};
+
+class SoapArtCache {
+  public:
+    SoapArtCache(fs::FS &fs, const char *dir = SOAP_ART_CACHE_DIR, uint32_t budget = SOAP_ART_CACHE_BUDGET);
+    ~SoapArtCache();
+
+    bool     begin(void);
+    bool     lookup(const char *url, String *path);
+    bool     fetch(SoapESP32 *soap, const char *url, String *path);
+    bool     fetch(SoapESP32 *soap, const soapObject_t *object, String *path, artVariant_et variant = artIcon);
+    bool     prefetch(SoapESP32 *soap, const soapObjectVect_t *objects, bool albumArt = false);
+    bool     prefetchBusy(void);
+    void     prefetchStop(void);
+    uint32_t used(void);
+    uint32_t count(void);
+    void     clear(void);
+
+  private:
+    fs::FS            &m_fs;
+    String             m_dir;
+    uint32_t           m_budget;
+    bool               m_begun;
+    std::vector<soapArtEntry_t> m_entries;
+    uint32_t           m_used;          // bytes of cached images
+    uint32_t           m_useCount;
+    soapArtEntry_t     m_pinned;        // image whose path was returned last, not evicted
+    SemaphoreHandle_t  m_lock;          // guards entries, shared with prefetch task
+    TaskHandle_t       m_task;          // prefetch task
+    SemaphoreHandle_t  m_taskDone;      // given by prefetch task when finished
+    volatile bool      m_taskRun;       // cleared to stop prefetch task
+    SoapESP32         *m_taskSoap;
+    std::vector<String> m_queue;        // URLs to prefetch
+
+    void     key(const char *url, soapArtEntry_t *entry);
+    String   fileName(const soapArtEntry_t *entry, const char *suffix = "");
+    int      find(const soapArtEntry_t *entry);
+    void     pin(const soapArtEntry_t *entry);
+    void     evict(uint32_t size);
+    bool     download(SoapESP32 *soap, const char *url, soapArtEntry_t *entry, bool task);
+    void     queue(const String &url);
+    static void prefetchTask(void *param);
+};
+
+#endif
@@ -25,41 +25,127 @@
 
 #include "SoapESP32.h"
 #include "MiniXPath.h"
+#include <Preferences.h>
+#ifdef USE_ETHERNET
+#include <Dns.h>
+#endif
+
+// gzip compressed XML replies are inflated with the miniz decoder in ESP32 ROM
+#if __has_include("esp32/rom/miniz.h")
+#include "esp32/rom/miniz.h"
+#define SOAP_GZIP
+#elif __has_include("rom/miniz.h")
+#include "rom/miniz.h"
+#define SOAP_GZIP
+#endif
 
 #ifdef USE_ETHERNET
-// usage of Wiznet W5x00 Ethernet board/shield instead of builtin WiFi
-#define claimSPI()   if (m_SPIsem && *m_SPIsem) while (xSemaphoreTake(*m_SPIsem, 10) != pdTRUE)
-#define releaseSPI() if (m_SPIsem && *m_SPIsem) xSemaphoreGive(*m_SPIsem)
+// usage of Wiznet W5x00 Ethernet board/shield instead of builtin WiFi, time waited is counted in 
+// m_stats of instance soap (static task functions name it explicitly)
+#define soapClaimSPI(soap)   if ((soap)->m_SPIsem && *(soap)->m_SPIsem) (soap)->m_stats.spiWaitTime += soapTakeSPI(*(soap)->m_SPIsem)
+#define soapReleaseSPI(soap) if ((soap)->m_SPIsem && *(soap)->m_SPIsem) xSemaphoreGive(*(soap)->m_SPIsem)
 #else
 // usage of builtin WiFi
-#define claimSPI()
-#define releaseSPI() 
+#define soapClaimSPI(soap)
+#define soapReleaseSPI(soap)
+#endif
+#define claimSPI()   soapClaimSPI(this)
+#define releaseSPI() soapReleaseSPI(this)
+
+#ifdef USE_ETHERNET
+//
+// helper function: take SPI semaphore, returns time waited in us
+//
+static uint32_t soapTakeSPI(SemaphoreHandle_t sem)
+{
+  if (xSemaphoreTake(sem, 0) == pdTRUE) return 0;
+
+  uint32_t start = micros();
+  while (xSemaphoreTake(sem, 10) != pdTRUE);
+  return micros() - start;
+}
 #endif
 
-enum eXpath { xpFriendlyName = 0, xpServiceType, xpControlUrl, xpBrowseContainer, xpBrowseContainerAlt1, xpBrowseContainerAlt2,
-             xpBrowseItem, xpBrowseItemAlt1, xpBrowseItemAlt2, xpBrowseNumberReturned, xpBrowseNumberReturnedAlt1, xpBrowseNumberReturnedAlt2,
-             xpTitle, xpAlbum, xpArtist, xpClass, xpResource, xpAlbumArt, xpIcon };
+// server list gets updated by server monitor task (if running) & sessions
+#define soapClaimServerList(soap)   if ((soap)->m_serverLock) xSemaphoreTake((soap)->m_serverLock, portMAX_DELAY)
+#define soapReleaseServerList(soap) if ((soap)->m_serverLock) xSemaphoreGive((soap)->m_serverLock)
+#define claimServerList()   soapClaimServerList(this)
+#define releaseServerList() soapReleaseServerList(this)
 
-xPathParser_t xmlParserPaths[] = { 
+// device description paths, scanned in a single pass by MiniXPathMulti
+enum eXpath { xpFriendlyName = 0, xpService, xpServiceType, xpControlUrl, xpEventSubUrl };
+
+const xPathParser_t xmlParserPaths[] = { 
   { .num = 3, .tagNames = { "root", "device", "friendlyName" } },
+  { .num = 4, .tagNames = { "root", "device", "serviceList", "service" } },
   { .num = 5, .tagNames = { "root", "device", "serviceList", "service", "serviceType" } },
   { .num = 5, .tagNames = { "root", "device", "serviceList", "service", "controlURL" } },
-  { .num = 6, .tagNames = { "s:Envelope", "s:Body", "u:BrowseResponse", "Result", "DIDL-Lite", "container" } },
-  { .num = 6, .tagNames = { "SOAP-ENV:Envelope", "SOAP-ENV:Body", "m:BrowseResponse", "Result", "DIDL-Lite", "container" } },
-  { .num = 6, .tagNames = { "SOAP-ENV:Envelope", "SOAP-ENV:Body", "u:BrowseResponse", "Result", "DIDL-Lite", "container" } },
-  { .num = 6, .tagNames = { "s:Envelope", "s:Body", "u:BrowseResponse", "Result", "DIDL-Lite", "item" } },
-  { .num = 6, .tagNames = { "SOAP-ENV:Envelope", "SOAP-ENV:Body", "m:BrowseResponse", "Result", "DIDL-Lite", "item" } },
-  { .num = 6, .tagNames = { "SOAP-ENV:Envelope", "SOAP-ENV:Body", "u:BrowseResponse", "Result", "DIDL-Lite", "item" } },
-  { .num = 4, .tagNames = { "s:Envelope", "s:Body", "u:BrowseResponse", "NumberReturned" } },
-  { .num = 4, .tagNames = { "SOAP-ENV:Envelope", "SOAP-ENV:Body", "m:BrowseResponse", "NumberReturned" } },
-  { .num = 4, .tagNames = { "SOAP-ENV:Envelope", "SOAP-ENV:Body", "u:BrowseResponse", "NumberReturned" } },
-  { .num = 1, .tagNames = { "dc:title" } },
-  { .num = 1, .tagNames = { "upnp:album" } },
-  { .num = 1, .tagNames = { "upnp:artist" } },
-  { .num = 1, .tagNames = { "upnp:class" } },
-  { .num = 1, .tagNames = { "res" } },
-  { .num = 1, .tagNames = { "upnp:albumArtURI" } },
-  { .num = 1, .tagNames = { "upnp:icon" } }
+  { .num = 5, .tagNames = { "root", "device", "serviceList", "service", "eventSubURL" } }
+};
+
+// GetSystemUpdateID reply
+const xPathParser_t systemUpdateIdPath[] = {
+  { .num = 4, .tagNames = { "Envelope", "Body", "GetSystemUpdateIDResponse", "Id" } }
+};
+
+// GENA NOTIFY message: evented state variables we deliver
+enum eXpathEvent { xpeSystemUpdateId = 0, xpeContainerUpdateIds, xpeLastChange };
+
+const xPathParser_t eventParserPaths[] = {
+  { .num = 3, .tagNames = { "propertyset", "property", "SystemUpdateID" } },
+  { .num = 3, .tagNames = { "propertyset", "property", "ContainerUpdateIDs" } },
+  { .num = 3, .tagNames = { "propertyset", "property", "LastChange" } }
+};
+
+#ifndef SOAP_NO_DMR
+// renderer control replies
+enum eXpathPosition { xppTrack = 0, xppTrackDuration, xppTrackUri, xppRelTime };
+
+const xPathParser_t positionInfoPaths[] = {
+  { .num = 4, .tagNames = { "Envelope", "Body", "GetPositionInfoResponse", "Track" } },
+  { .num = 4, .tagNames = { "Envelope", "Body", "GetPositionInfoResponse", "TrackDuration" } },
+  { .num = 4, .tagNames = { "Envelope", "Body", "GetPositionInfoResponse", "TrackURI" } },
+  { .num = 4, .tagNames = { "Envelope", "Body", "GetPositionInfoResponse", "RelTime" } }
+};
+
+enum eXpathTransport { xptState = 0, xptStatus, xptSpeed };
+
+const xPathParser_t transportInfoPaths[] = {
+  { .num = 4, .tagNames = { "Envelope", "Body", "GetTransportInfoResponse", "CurrentTransportState" } },
+  { .num = 4, .tagNames = { "Envelope", "Body", "GetTransportInfoResponse", "CurrentTransportStatus" } },
+  { .num = 4, .tagNames = { "Envelope", "Body", "GetTransportInfoResponse", "CurrentSpeed" } }
+};
+#endif
+
+// browse reply paths, all scanned in a single pass by MiniXPathMulti. Tag names without namespace
+// prefix, so "s:"/"SOAP-ENV:" and "u:"/"m:" flavours of media servers are covered alike.
+enum eXpathBrowse { xpbContainer = 0, xpbContainerTitle, xpbItem, xpbItemTitle, xpbItemAlbum, xpbItemArtist, 
+                    xpbItemClass, xpbItemResource, xpbItemAlbumArt, xpbItemIcon, xpbNumberReturned, xpbTotalMatches,
+                    xpbUpdateId, xpbBrowseResponse };
+
+// browse & search reply paths (element name of response, e.g. "BrowseResponse"), order as in eXpathBrowse
+#define SOAP_RESULT_PATHS(response) \
+  { .num = 6, .tagNames = { "Envelope", "Body", response, "Result", "DIDL-Lite", "container" } },            \
+  { .num = 7, .tagNames = { "Envelope", "Body", response, "Result", "DIDL-Lite", "container", "title" } },   \
+  { .num = 6, .tagNames = { "Envelope", "Body", response, "Result", "DIDL-Lite", "item" } },                 \
+  { .num = 7, .tagNames = { "Envelope", "Body", response, "Result", "DIDL-Lite", "item", "title" } },        \
+  { .num = 7, .tagNames = { "Envelope", "Body", response, "Result", "DIDL-Lite", "item", "album" } },        \
+  { .num = 7, .tagNames = { "Envelope", "Body", response, "Result", "DIDL-Lite", "item", "artist" } },       \
+  { .num = 7, .tagNames = { "Envelope", "Body", response, "Result", "DIDL-Lite", "item", "class" } },        \
+  { .num = 7, .tagNames = { "Envelope", "Body", response, "Result", "DIDL-Lite", "item", "res" } },          \
+  { .num = 7, .tagNames = { "Envelope", "Body", response, "Result", "DIDL-Lite", "item", "albumArtURI" } },  \
+  { .num = 7, .tagNames = { "Envelope", "Body", response, "Result", "DIDL-Lite", "item", "icon" } },         \
+  { .num = 4, .tagNames = { "Envelope", "Body", response, "NumberReturned" } },                              \
+  { .num = 4, .tagNames = { "Envelope", "Body", response, "TotalMatches" } },                                \
+  { .num = 4, .tagNames = { "Envelope", "Body", response, "UpdateID" } },                                    \
+  { .num = 3, .tagNames = { "Envelope", "Body", response } }
+
+const xPathParser_t browseParserPaths[] = { SOAP_RESULT_PATHS("BrowseResponse") };
+const xPathParser_t searchParserPaths[] = { SOAP_RESULT_PATHS("SearchResponse") };
+
+const xPathParser_t searchCapsPath[] = {
+  { .num = 4, .tagNames = { "Envelope", "Body", "GetSearchCapabilitiesResponse", "SearchCaps" } },
+  { .num = 3, .tagNames = { "Envelope", "Body", "GetSearchCapabilitiesResponse" } }
 };
 
 const char *fileTypes[] = { "other", "audio", "picture", "video", "" };
@@ -93,12 +179,75 @@ char *strcasestr(const char *s, const char *what)
 //
 #ifdef USE_ETHERNET
 SoapESP32::SoapESP32(EthernetClient *client, EthernetUDP *udp, SemaphoreHandle_t *sem)
-  : m_client(client), m_udp(udp), m_SPIsem(sem), m_clientDataConOpen(false), m_clientDataAvailable(0)
+  : SoapESP32(client, udp, sem, NULL)
+{
+}
+
+//
+// session constructor: own client connection, server list & SPI semaphore shared with parent
+//
+SoapESP32::SoapESP32(SoapESP32 *parent, EthernetClient *client)
+  : SoapESP32(client, NULL, parent->m_SPIsem, parent)
+{
+}
+
+SoapESP32::SoapESP32(EthernetClient *client, EthernetUDP *udp, SemaphoreHandle_t *sem, SoapESP32 *parent)
+  : m_client(client), m_udp(udp), m_SPIsem(sem), m_clientDataConOpen(false), m_clientDataAvailable(0),
 #else
 SoapESP32::SoapESP32(WiFiClient *client, WiFiUDP *udp)
-  : m_client(client), m_udp(udp), m_clientDataConOpen(false), m_clientDataAvailable(0)
+  : SoapESP32(client, udp, NULL)
+{
+}
+
+//
+// session constructor: own client connection, server list shared with parent
+//
+SoapESP32::SoapESP32(SoapESP32 *parent, WiFiClient *client)
+  : SoapESP32(client, NULL, parent)
+{
+}
+
+SoapESP32::SoapESP32(WiFiClient *client, WiFiUDP *udp, SoapESP32 *parent)
+  : m_client(client), m_udp(udp), m_clientDataConOpen(false), m_clientDataAvailable(0),
 #endif
+    m_clientDataPosition(0), m_clientDataChunked(false), m_clientDataUnbounded(false), 
+    m_parent(parent), m_server(parent ? parent->m_server : m_serverList), 
+    m_rxBufferCount(0), m_rxBufferOffset(0), m_txCount(0), m_txFlushed(false), m_browseFields(SOAP_FIELD_ALL),
+    m_resourcePolicy(false), m_resourceMaxBitrate(0), m_resourceMaxSize(0), m_resourceMimeOnly(false),
+    m_browseNumberReturned(0), m_browseTotalMatches(0), m_browseStopped(false), m_lastServer(-1), m_browseUpdateId(0),
+    m_cacheBytes(0), m_cacheBudget(0), m_cacheEventsOverflow(false),
+    m_keepAlive(false), m_connReusable(false), m_connReused(false), m_connKeepAlive(false), m_connPort(0), 
+    m_httpNoLength(false), m_httpGzip(false), m_compression(parent ? parent->m_compression : false), m_inflate(NULL), m_httpTimeout(0),
+    m_deadline(0), m_seekMax(0), m_seekPort(0), m_serverLock(NULL), m_monitorTask(NULL), m_monitorDone(NULL),
+    m_monitorRun(false), m_readTask(NULL), m_readTaskDone(NULL), m_readTaskRun(false), m_readTaskState(readTaskIdle),
+    m_asyncTask(NULL), m_asyncTaskDone(NULL), m_asyncState(asyncIdle), m_asyncResult(NULL), m_asyncCursor(NULL), m_asyncSize(NULL),
+    m_eventTask(NULL), m_eventDone(NULL), m_eventRun(false), m_eventPort(0), m_eventCallback(NULL), m_eventUserData(NULL)
+{
+  // server list is protected by a lock, sessions use the one of their parent
+  m_serverLock = parent ? parent->m_serverLock : xSemaphoreCreateMutex();
+  resetStats();
+  if (parent && parent->m_resourcePolicy) {
+    // sessions select resources like their parent
+    m_resourcePolicy = true;
+    m_resourceMime = parent->m_resourceMime;
+    m_resourceMaxBitrate = parent->m_resourceMaxBitrate;
+    m_resourceMaxSize = parent->m_resourceMaxSize;
+    m_resourceMimeOnly = parent->m_resourceMimeOnly;
+  }
+}
+
+SoapESP32::~SoapESP32()
 {
+  asyncWait();
+  stopServerMonitor();
+  stopEventListener();
+  readTaskStop();
+  soapInflateEnd();
+  if (m_serverLock && !m_parent) vSemaphoreDelete(m_serverLock);
+  if (m_monitorDone) vSemaphoreDelete(m_monitorDone);
+  if (m_readTaskDone) vSemaphoreDelete(m_readTaskDone);
+  if (m_asyncTaskDone) vSemaphoreDelete(m_asyncTaskDone);
+  if (m_eventDone) vSemaphoreDelete(m_eventDone);
 }
 
 //
@@ -112,6 +261,10 @@ bool SoapESP32::wakeUpServer(const char *macAddress)
   int mac[6];
   char lower[20];
 
+  if (!m_udp) {
+    log_e("no UDP object, wake up not possible (session ?)");
+    return false;
+  }
   if (strlen(macAddress) > 10 && strlen(macAddress) < 18) {
     int i;
     for (i = 0; i < strlen(macAddress); i++) {
@@ -155,24 +308,230 @@ bool SoapESP32::wakeUpServer(const char *macAddress)
 }
 
 //
-// helper function, client timed read
+// wake up server srv in list (e.g. restored with restoreServerList(..., false) or added with
+// addServer()) and wait until its ContentDirectory answers. Server gets probed with a small
+// SOAP request (GetSystemUpdateID) every SOAP_WAKE_UP_PROBE_PERIOD ms, WOL packets are repeated
+// every SOAP_WAKE_UP_RESEND ms. Returns false if server did not answer within timeout (ms)
 //
-int SoapESP32::soapClientTimedRead()
+bool SoapESP32::wakeUpServer(const char *macAddress, uint8_t srv, uint32_t timeout)
+{
+  soapServer_t server;
+  uint32_t id, start = millis(), sent;
+
+  if (!getServerInfo(srv, &server)) {
+    log_e("invalid server number: %d", srv);
+    return false;
+  }
+  if (!wakeUpServer(macAddress)) return false;
+  sent = millis();
+
+  while (true) {
+    uint32_t probe = millis();
+    if (probe - start >= timeout) break;
+    uint32_t left = timeout - (probe - start);
+
+    // single short connection attempt, request goes over that connection and must not run past timeout
+    bool ok = soapProbeServer(server.ip, server.port, min(left, (uint32_t)SOAP_WAKE_UP_PROBE_PERIOD), true);
+    if (ok) {
+      m_deadline = start + timeout;
+      if (m_deadline == 0) m_deadline = 1;   // 0 means no deadline
+      ok = soapGetSystemUpdateId(&server, &id);
+      m_deadline = 0;
+    }
+    if (ok) {
+      log_i("server %s:%d answered after %d ms", server.ip.toString().c_str(), server.port, millis() - start);
+      return true;
+    }
+    if (millis() - start >= timeout) break;
+    if (millis() - sent >= SOAP_WAKE_UP_RESEND) {
+      wakeUpServer(macAddress);
+      sent = millis();
+    }
+    uint32_t elapsed = millis() - probe;
+    left = timeout - (millis() - start);
+    if (elapsed < SOAP_WAKE_UP_PROBE_PERIOD) delay(min((uint32_t)SOAP_WAKE_UP_PROBE_PERIOD - elapsed, left));
+  }
+  log_w("server %s:%d did not answer within %d ms", server.ip.toString().c_str(), server.port, timeout);
+
+  return false;
+}
+
+//
+// helper function, refill receive buffer with a single bulk read (one SPI claim only)
+//
+bool SoapESP32::soapClientFillBuffer()
 {
-  int c;
+  int res;
   unsigned long startMillis = millis();
+  uint32_t timeout = soapTimeout(SERVER_READ_TIMEOUT);
 
+  m_rxBufferCount = m_rxBufferOffset = 0;
   do {
     claimSPI();
-    c = m_client->read();
+    res = m_client->read(m_rxBuffer, sizeof(m_rxBuffer));
     releaseSPI();
-    if(c >= 0) {
-      return c;
+    if (res > 0) {
+      m_rxBufferCount = (size_t)res;
+      m_stats.bytesReceived += res;
+      return true;
     }
   } 
-  while (millis() - startMillis < SERVER_READ_TIMEOUT);
+  while (millis() - startMillis < timeout);
+
+  return false;  // read timeout
+}
+
+//
+// helper function, client timed read (served from receive buffer)
+//
+int SoapESP32::soapClientTimedRead()
+{
+  if (m_rxBufferOffset >= m_rxBufferCount && !soapClientFillBuffer()) {
+    return -1;   // read timeout
+  }
+
+  return m_rxBuffer[m_rxBufferOffset++];
+}
+
+//
+// helper function, number of bytes ready for reading (buffered or still with client)
+//
+int SoapESP32::soapClientAvailable()
+{
+  int av = m_rxBufferCount - m_rxBufferOffset;
+
+  if (av == 0) {
+    claimSPI();
+    av = m_client->available();
+    releaseSPI();
+  }
+
+  return av;
+}
+
+//
+// helper function, replaces client.readBytesUntil() and reads from receive buffer
+// returns length without terminator
+//
+size_t SoapESP32::soapClientReadBytesUntil(char terminator, char *buffer, size_t length)
+{
+  size_t len = 0;
+
+  while (len < length) {
+    int c = soapClientTimedRead();
+    if (c < 0 || c == terminator) break;
+    buffer[len++] = (char)c;
+  }
+
+  return len;
+}
+
+//
+// helper function: limit timeout to time left until deadline (if set)
+//
+uint32_t SoapESP32::soapTimeout(uint32_t timeout)
+{
+  if (m_deadline) {
+    int32_t left = (int32_t)(m_deadline - millis());
+    if (left <= 0) return 0;
+    if ((uint32_t)left < timeout) return (uint32_t)left;
+  }
+  return timeout;
+}
+
+//
+// helper function, close client connection
+//
+void SoapESP32::soapClientStop()
+{
+  claimSPI();
+  m_client->stop();
+  releaseSPI();
+  m_connReusable = false;
+  soapInflateEnd();
+}
+
+//
+// enable/disable connection reuse (HTTP keep-alive) for requests to the same server ip & port
+//
+void SoapESP32::setKeepAlive(bool keepAlive)
+{
+  m_keepAlive = keepAlive;
+  if (!keepAlive && m_connReusable) soapClientStop();
+}
+
+//
+// enable/disable gzip compressed Browse/Search replies & device descriptions, file downloads
+// are always requested uncompressed. Returns false if no gzip decoder is available
+//
+bool SoapESP32::setCompression(bool gzip)
+{
+#ifdef SOAP_GZIP
+  m_compression = gzip;
+  return true;
+#else
+  m_compression = false;
+  if (gzip) log_w("gzip decoder (ROM miniz) not available, compression stays off");
+  return !gzip;
+#endif
+}
+
+//
+// select among all <res> of an item instead of taking the first one: preferred MIME types (comma 
+// separated, in order of preference, e.g. "audio/mpeg,audio/*"), max. bitrate (unit as reported by
+// server) & max. size (0: no limit). mimeOnly: resources of other types are never selected.
+// setResourcePolicy(NULL) goes back to first <res>. Cached browse results get dropped
+//
+void SoapESP32::setResourcePolicy(const char *mimeTypes, int maxBitrate, uint64_t maxSize, bool mimeOnly)
+{
+  m_resourceMime = mimeTypes ? mimeTypes : "";
+  m_resourceMime.replace(" ", "");
+  m_resourceMaxBitrate = maxBitrate;
+  m_resourceMaxSize = maxSize;
+  m_resourceMimeOnly = mimeOnly;
+  m_resourcePolicy = m_resourceMime.length() || maxBitrate || maxSize;
+  invalidateBrowseCache();
+}
 
-  return -1;     // read timeout
+//
+// request statistics: last (or current) request and accumulated over all requests incl. last one
+//
+void SoapESP32::getStats(soapStats_t *last, soapStats_t *total)
+{
+  if (last) *last = m_stats;
+  if (total) {
+    *total = m_statsTotal;
+    total->requests += m_stats.requests;
+    total->connectTime += m_stats.connectTime;
+    total->firstByteTime += m_stats.firstByteTime;
+    total->headerTime += m_stats.headerTime;
+    total->parseTime += m_stats.parseTime;
+    total->bytesReceived += m_stats.bytesReceived;
+    total->chunks += m_stats.chunks;
+    total->objectsEmitted += m_stats.objectsEmitted;
+    total->objectsDropped += m_stats.objectsDropped;
+    total->spiWaitTime += m_stats.spiWaitTime;
+  }
+}
+
+void SoapESP32::resetStats()
+{
+  memset(&m_stats, 0, sizeof(m_stats));
+  memset(&m_statsTotal, 0, sizeof(m_statsTotal));
+}
+
+//
+// helper function: new request, statistics of last one are added to accumulated statistics
+//
+void SoapESP32::soapStatsBegin()
+{
+  uint32_t spiWaitTime = m_stats.spiWaitTime;
+
+  m_stats.spiWaitTime = 0;              // SPI wait in between requests is counted for new one
+  getStats(NULL, &m_statsTotal);
+  memset(&m_stats, 0, sizeof(m_stats));
+  m_stats.requests = 1;
+  m_stats.spiWaitTime = spiWaitTime;
 }
 
 //
@@ -254,17 +613,73 @@ const char* SoapESP32::serviceSchema(serviceClass_et serviceClass) {
 }
 
 //
-// SSDP/UDP search for media servers in local network
+// helper function: scan SSDP packet (M-SEARCH reply or NOTIFY) announcing a server of requested class
+// ip, port, location & uuid are stored in srv (byebye packets only provide uuid)
 //
-bool SoapESP32::soapSSDPquery(soapServerVect_t *result, serviceClass_et serviceClass, int msWait)
+ssdpPacket_et SoapESP32::soapScanSSDPpacket(char *packet, serviceClass_et serviceClass, soapServer_t *srv)
 {
-  int i, port;
-  size_t len;
+  int port;
   IPAddress ip;
-  char tmpBuffer[SSDP_TMP_BUFFER_SIZE],
+  char *p, format[30],
        location[SSDP_LOCATION_BUF_SIZE] = "",
        address[20];
 
+  *srv = soapServer_t();
+
+  // unique device name ("USN: uuid:xxxx::urn:...")
+  if ((p = strcasestr(packet, SSDP_USN)) != NULL) {
+    p += strlen(SSDP_USN);
+    int len = strcspn(p, ":\r\n");
+    if (len >= SSDP_UUID_BUF_SIZE) len = SSDP_UUID_BUF_SIZE - 1;
+    srv->uuid = String(p).substring(0, len);
+  }
+
+  // NOTIFY packets sent out by media servers when leaving the network
+  if (strstr(packet, SSDP_NOTIFICATION) && strcasestr(packet, ssdpNT(serviceClass)) && 
+      strcasestr(packet, SSDP_NOTIFICATION_SUB_TYPE_BYEBYE)) {
+    return (srv->uuid.length() > 0) ? ssdpByebye : ssdpIgnored;
+  }
+
+  if (!(  // M-SEARCH reply packets
+          (strstr(packet,HTTP_HEADER_200_OK) &&
+           ((p = strcasestr(packet,SSDP_LOCATION)) != NULL) && strcasestr(packet,ssdpST(serviceClass))
+          ) ||
+            // NOTIFY packets sent out regularly by media servers
+          (strstr(packet,SSDP_NOTIFICATION) &&
+           ((p = strcasestr(packet,SSDP_LOCATION)) != NULL) &&
+           strcasestr(packet,ssdpNT(serviceClass)) && strcasestr(packet,SSDP_NOTIFICATION_SUB_TYPE)
+          )
+       )) {
+    return ssdpIgnored;
+  }
+
+  strtok(p, "\r\n");
+  snprintf(format, sizeof(format), "http://%%[0-9.]:%%d/%%%ds", SSDP_LOCATION_BUF_SIZE - 1);
+  if (sscanf(p + 10, format, address, &port, location) < 2) return ssdpIgnored;
+  if (!ip.fromString(address)) return ssdpIgnored;
+
+  // scanning of ip address & port successful, missing location string possible (e.g. D-Link NAS DNS-320L)
+  log_d("scanned ip=%s, port=%d, location=\"%s\", uuid=\"%s\"", ip.toString().c_str(), port, location, srv->uuid.c_str());
+  if (!strlen(location)) log_d("empty location string!");
+
+  srv->ip = ip;
+  srv->port = (uint16_t)port;
+  srv->location = location;
+
+  return ssdpAlive;
+}
+
+//
+// SSDP/UDP search for media servers in local network
+// query ends early when limits set with setSeekLimit() are reached
+//
+bool SoapESP32::soapSSDPquery(soapServerVect_t *result, serviceClass_et serviceClass, int msWait)
+{
+  int i;
+  size_t len;
+  char tmpBuffer[SSDP_TMP_BUFFER_SIZE];
+  soapServer_t srv;
+
   // send SSDP multicast packets (parameter: nr of repeats)
   if (!soapUDPmulticast(serviceClass, 1)) return false;
 
@@ -272,55 +687,45 @@ bool SoapESP32::soapSSDPquery(soapServerVect_t *result, serviceClass_et serviceC
   uint32_t start = millis();
   do
   {
-    delay(25);
     claimSPI();
     len = m_udp->parsePacket();
     releaseSPI();
-    if (len) {
-      char *p;
-      
-      // we received SSDP packet of size len
-      log_d("received SSDP packet within %d ms: packet size: %d", millis() - start, len);
-      memset(tmpBuffer, 0, SSDP_TMP_BUFFER_SIZE);      // clear buffer
-      if ( len >= SSDP_TMP_BUFFER_SIZE) len = SSDP_TMP_BUFFER_SIZE -1;
-      claimSPI();
-      m_udp->read(tmpBuffer, len);                     // read packet into the buffer
-      releaseSPI();
-      log_v("SSDP packet content:\n%s", tmpBuffer);
+    if (!len) {
+      delay(SSDP_POLL_INTERVAL);   // nothing received, packets already waiting are read without delay
+      continue;
+    }  
 
-      // scan SSDP packet
-      if (  // M-SEARCH reply packets
-          (strstr(tmpBuffer,HTTP_HEADER_200_OK) &&
-           ((p = strcasestr(tmpBuffer,SSDP_LOCATION)) != NULL) && strcasestr(tmpBuffer,ssdpST(serviceClass))
-          ) ||
-            // NOTIFY packets sent out regularly by media servers (we ignore ssdp:byebye's)
-          (strstr(tmpBuffer,SSDP_NOTIFICATION) &&
-           ((p = strcasestr(tmpBuffer,SSDP_LOCATION)) != NULL) &&
-           strcasestr(tmpBuffer,ssdpNT(serviceClass)) && strcasestr(tmpBuffer,SSDP_NOTIFICATION_SUB_TYPE)
-          )
-         ) {  
-        char format[30];
-
-        strtok(p, "\r\n");
-        snprintf(format, sizeof(format), "http://%%[0-9.]:%%d/%%%ds", SSDP_LOCATION_BUF_SIZE - 1);
-        if (sscanf(p + 10, format, address, &port, location) < 2) continue;
-        if (!ip.fromString(address)) continue;
-
-        // scanning of ip address & port successful, missing location string possible (e.g. D-Link NAS DNS-320L)
-        log_d("scanned ip=%s, port=%d, location=\"%s\"", ip.toString().c_str(), port, location);
-        if (!strlen(location)) log_d("empty location string!");
-
-        // avoid multiple entries of same server (ip & port are identical) but accept multiple media servers
-        // running under the same ip and using different ports
-        for (i = 0; i < result->size(); i++) {
-          if (result->operator[](i).ip == ip && result->operator[](i).port == port) break;               
-        }
-        if (i < result->size()) continue;
+    // we received SSDP packet of size len
+    log_d("received SSDP packet within %d ms: packet size: %d", millis() - start, len);
+    memset(tmpBuffer, 0, SSDP_TMP_BUFFER_SIZE);      // clear buffer
+    if ( len >= SSDP_TMP_BUFFER_SIZE) len = SSDP_TMP_BUFFER_SIZE -1;
+    claimSPI();
+    m_udp->read(tmpBuffer, len);                     // read packet into the buffer
+    releaseSPI();
+    log_v("SSDP packet content:\n%s", tmpBuffer);
 
-        // new server found: add it to list
-        soapServer_t srv = {.ip = ip, .port = (uint16_t)port, .location = location};
-        result->push_back(srv);
-      }
+    // scan SSDP packet (we ignore ssdp:byebye's)
+    if (soapScanSSDPpacket(tmpBuffer, serviceClass, &srv) != ssdpAlive) continue;
+
+    // avoid multiple entries of same server (ip & port are identical) but accept multiple media servers
+    // running under the same ip and using different ports
+    for (i = 0; i < result->size(); i++) {
+      if (result->operator[](i).ip == srv.ip && result->operator[](i).port == srv.port) break;               
+    }
+    if (i < result->size()) continue;
+
+    // new server found: add it to list
+    result->push_back(srv);
+
+    // early exit: enough servers found or expected server has answered
+    if (m_seekMax && result->size() >= m_seekMax) {
+      log_d("%d servers found after %d ms, ending query", result->size(), millis() - start);
+      break;
+    }
+    if ((m_seekPort && srv.ip == m_seekIp && srv.port == m_seekPort) || 
+        (m_seekUuid.length() && srv.uuid.equalsIgnoreCase(m_seekUuid))) {
+      log_d("expected server found after %d ms, ending query", millis() - start);
+      break;
     }
   }
   while ((millis() - start) < msWait);
@@ -332,22 +737,39 @@ bool SoapESP32::soapSSDPquery(soapServerVect_t *result, serviceClass_et serviceC
   return true;
 }
 
+//
+// end SSDP query as soon as maxServers have answered (0: no limit) or when the server with given 
+// ip & port (port 0: not used) or uuid (NULL: not used) has answered
+//
+void SoapESP32::setSeekLimit(uint8_t maxServers, IPAddress ip, uint16_t port, const char *uuid)
+{
+  m_seekMax = maxServers;
+  m_seekIp = ip;
+  m_seekPort = port;
+  m_seekUuid = uuid ? uuid : "";
+}
+
 //
 // read & evaluate HTTP header
 //
 bool SoapESP32::soapReadHttpHeader(uint64_t *contentLength, bool *chunked)
 {
   size_t len;
-  bool ok = false;
+  bool ok = false, end = false;
   char *p, tmpBuffer[TMP_BUFFER_SIZE_200];
+  uint32_t start = millis();
 
-  // first line contains status code
-  claimSPI();
-  len = m_client->readBytesUntil('\n', tmpBuffer, sizeof(tmpBuffer) - 1);   // returns length without terminator '\n'
-  releaseSPI();
+  m_httpNoLength = m_httpGzip = false;
+  soapInflateEnd();
+
+  // first line contains status code: 200 or 206 (reply to range request)
+  len = soapClientReadBytesUntil('\n', tmpBuffer, sizeof(tmpBuffer) - 1);   // returns length without terminator '\n'
   tmpBuffer[len] = 0;
-  if (!strstr(tmpBuffer, HTTP_HEADER_200_OK)) {
+  m_httpStatus = 0;
+  if (sscanf(tmpBuffer, "HTTP/%*d.%*d %d", &m_httpStatus) != 1 || 
+      (m_httpStatus != HTTP_STATUS_OK && m_httpStatus != HTTP_STATUS_PARTIAL_CONTENT)) {
     log_e("header line: %s", tmpBuffer);
+    m_stats.headerTime = millis() - start;
     return false;
   }
   else {
@@ -359,17 +781,46 @@ bool SoapESP32::soapReadHttpHeader(uint64_t *contentLength, bool *chunked)
   }
   *contentLength = 0;
   if (chunked) *chunked = false;
+  m_connKeepAlive = true;            // HTTP/1.1 default, unless server says otherwise
+  m_xmlChunkFinal = false;
+  m_contentRangeStart = m_contentRangeTotal = 0;
+  m_httpSid = "";
+  m_httpTimeout = 0;
   while (true) {
-    claimSPI();
-    int av = m_client->available();
-    releaseSPI();
-    if (!av) break;
-    claimSPI();
-    len = m_client->readBytesUntil('\n', tmpBuffer, sizeof(tmpBuffer) - 1);
-    releaseSPI();
+    if (!soapClientAvailable()) break;
+    len = soapClientReadBytesUntil('\n', tmpBuffer, sizeof(tmpBuffer) - 1);
     tmpBuffer[len] = 0;
     log_v("header line: %s", tmpBuffer);
-    if (len == 1) break;      // End of header: finishing line contains only "\r\n"
+    if (len == 1) {           // End of header: finishing line contains only "\r\n"
+      end = true;
+      break;
+    }
+    if (strncasecmp(tmpBuffer, HEADER_CONNECTION, sizeof(HEADER_CONNECTION) - 1) == 0 && 
+        strncasecmp(tmpBuffer + sizeof(HEADER_CONNECTION) - 1, "close", 5) == 0) {
+      m_connKeepAlive = false;
+      continue;
+    }
+    if (strncasecmp(tmpBuffer, HEADER_SID, sizeof(HEADER_SID) - 1) == 0) {
+      // GENA subscription reply: "SID: uuid:..."
+      m_httpSid = tmpBuffer + sizeof(HEADER_SID) - 1;
+      m_httpSid.trim();
+      continue;
+    }
+    if (strncasecmp(tmpBuffer, HEADER_TIMEOUT, sizeof(HEADER_TIMEOUT) - 1) == 0) {
+      // "TIMEOUT: Second-1800", "Second-infinite" gives 0
+      m_httpTimeout = strtoul(tmpBuffer + sizeof(HEADER_TIMEOUT) - 1, NULL, 10);
+      continue;
+    }
+    if ((p = strcasestr(tmpBuffer, HEADER_CONTENT_RANGE)) != NULL) {
+      // "Content-Range: bytes 1000-1999/5000", total size might be "*"
+      uint64_t rangeEnd;
+      sscanf(p + strlen(HEADER_CONTENT_RANGE), "%llu-%llu/%llu", &m_contentRangeStart, &rangeEnd, &m_contentRangeTotal);
+      continue;
+    }
+    if (strcasestr(tmpBuffer, HEADER_CONTENT_ENCODING_GZIP)) {
+      m_httpGzip = true;
+      continue;
+    }
     if (!ok) {
       if ((p = strcasestr(tmpBuffer,HEADER_CONTENT_LENGTH)) != NULL) {
         if (sscanf(p+strlen(HEADER_CONTENT_LENGTH),"%llu", contentLength) == 1) {
@@ -386,6 +837,7 @@ bool SoapESP32::soapReadHttpHeader(uint64_t *contentLength, bool *chunked)
   }
   if (ok) {
     m_xmlReplaceState = xmlPassthrough;
+    m_xmlContentLeft = *contentLength;
     if (chunked && *chunked) {
       log_d("HTTP-Header ok, trailing content is chunked, no size announced"); 
     }
@@ -393,1069 +845,4757 @@ bool SoapESP32::soapReadHttpHeader(uint64_t *contentLength, bool *chunked)
       log_d("HTTP-Header ok, trailing content is not chunked, announced size: %llu", *contentLength); 
     }
   }
+  else if (end) {
+    // neither size nor chunks announced: content ends when server closes connection
+    m_httpNoLength = true;
+    log_d("HTTP-Header ok, no size announced");
+  }
+  m_stats.headerTime = millis() - start;
 
   return ok;
 }
 
 //
-// read XML data, de-chunk if needed & replace predefined XML entities that spoil MiniXPath
+// helper function, chunked content: read line with size of next chunk if needed
+// returns 0 (chunk data follows) or error code: -2/-3 invalid size line, -4 final chunk
 //
-const replaceWith_t replaceWith[] = { {"&lt;", '<'},
-                                      {"&gt;", '>'},
-                                      {"&quot;", '"'},
-                                      {"&amp;amp;", '&'},
-                                      {"&amp;apos;", '\''},
-                                      {"&amp;quot;", '\''} }; 
-
-int SoapESP32::soapReadXML(bool chunked, bool replace)
+int SoapESP32::soapChunkBegin()
 {
-  bool match;
-  int i, c = -10;
+  char tmpBuffer[10];
 
-  if (!replace || (replace && (m_xmlReplaceState == xmlPassthrough))) {
-GET_MORE:    
-    if (!chunked) {
-      // data is not chunked
-      if ((c = soapClientTimedRead()) < 0) {
-        // timeout or connection closed
-        return -1;
-      }
-    }
-    else {
-      // de-chunk XML data   
-      if (m_xmlChunkCount <= 0) {
-        char tmpBuffer[10];
-      
-        // next line contains chunk size
-        claimSPI();
-        int len = m_client->readBytesUntil('\n', tmpBuffer, sizeof(tmpBuffer) - 1);
-        releaseSPI();
-        if (len < 2) {
-          return -2;   // we expect at least 1 digit chunk size + '\r'
-        }
-        tmpBuffer[len-1] = 0;     // replace '\r' with '\0'
-        if (sscanf(tmpBuffer, "%x", &m_xmlChunkCount) != 1) {
-          return -3;
-        }
-        log_d("announced chunk size: 0x%x, %d", m_xmlChunkCount, m_xmlChunkCount);
-        if (m_xmlChunkCount <= 0) {
-          return -4;  // not necessarily an error...final chunk size can be 0
-        }
-      }
-      if ((c = soapClientTimedRead()) < 0) {
-        return -5;
-      }
+  if (m_xmlChunkFinal) return -4;
+  if (m_xmlChunkCount > 0) return 0;
 
-      // check for end of chunk
-      if (--m_xmlChunkCount == 0) {
-        // skip "\r\n" trailing each chunk
-        if (soapClientTimedRead() < 0 || soapClientTimedRead() < 0) {
-          return -6;   
-        }
-      }
-    }
+  // next line contains chunk size
+  int len = soapClientReadBytesUntil('\n', tmpBuffer, sizeof(tmpBuffer) - 1);
+  if (len < 2) {
+    return -2;   // we expect at least 1 digit chunk size + '\r'
   }
-
-  // replace predefined XML entities ("&lt;" becomes "<", etc.)
-  if (replace) {
-    if (m_xmlReplaceState == xmlPassthrough) {
-      if (c == '&') {
-        memset(m_xmlReplaceBuffer, 0, sizeof(m_xmlReplaceBuffer));
-        m_xmlReplaceBuffer[0] = '&';
-        m_xmlReplaceState = xmlAmpDetected;
-        m_xmlReplaceOffset = 1;
-        goto GET_MORE;
-      }
-    }
-    else if (m_xmlReplaceState == xmlAmpDetected) {
-      m_xmlReplaceBuffer[m_xmlReplaceOffset++] = c;
-      // run through all predefined sequences and see if we still match
-      for (match = false, i = 0; i < sizeof(replaceWith)/sizeof(replaceWith_t) && !match; i++) {
-        if (strncmp(m_xmlReplaceBuffer, replaceWith[i].replace, m_xmlReplaceOffset) == 0) {
-          match = true;
-          break;
-        }
-      }
-      if (!match) {
-        // single '&' or sequence we don't replace
-        c = '&';
-        m_xmlReplaceState = xmlTakeFromBuffer;  
-        m_xmlReplaceOffset = 1;
-      }
-      else {  // match
-        if (m_xmlReplaceOffset < strlen(replaceWith[i].replace)) {
-          goto GET_MORE;
-        }
-        else {
-          // found full sequence to be replaced
-          c = replaceWith[i].with;  
-          m_xmlReplaceState = xmlPassthrough;
-        }
-      }
-    }
-    else {  
-      // xmlTakeFromBuffer
-      c = m_xmlReplaceBuffer[m_xmlReplaceOffset++];
-      if (m_xmlReplaceBuffer[m_xmlReplaceOffset] == '\0') {
-        m_xmlReplaceState = xmlPassthrough;
-      }
-    }
+  tmpBuffer[len-1] = 0;     // replace '\r' with '\0'
+  if (sscanf(tmpBuffer, "%x", &m_xmlChunkCount) != 1) {
+    return -3;
   }
-  // TEST
-  //Serial.printf("%c", (char)c);
-  return c;
+  log_d("announced chunk size: 0x%x, %d", m_xmlChunkCount, m_xmlChunkCount);
+  if (m_xmlChunkCount <= 0) {
+    m_xmlChunkFinal = true;
+    return -4;  // not necessarily an error...final chunk size can be 0
+  }
+  m_stats.chunks++;
+
+  return 0;
 }
 
 //
-// searching local network for media servers that offer media content
-// returns number of servers found
+// helper function, chunked content: count bytes of current chunk have been consumed
+// returns 0 or -6 if "\r\n" trailing each chunk is missing
 //
-uint8_t SoapESP32::seekServer(serviceClass_et serviceClass)
+int SoapESP32::soapChunkConsumed(size_t count)
 {
-  soapServerVect_t rcvd;
+  m_xmlChunkCount -= count;
+  if (m_xmlChunkCount == 0 && (soapClientTimedRead() < 0 || soapClientTimedRead() < 0)) {
+    return -6;   
+  }
 
-  // delete old server list
-  m_server.clear();
+  return 0;
+}
 
-  log_i("SSDP search for %s media servers started", serviceClassName(serviceClass));
-  soapSSDPquery(&rcvd, serviceClass);
+//
+// helper function: make next bytes of reply content available in receive buffer (de-chunked, no copy)
+// returns number of contiguous bytes at *data (at least 1) or error code of soapReadXML()
+//
+int SoapESP32::soapBodyPeek(bool chunked, const uint8_t **data)
+{
+  int ret;
+  size_t len;
 
-  log_i("SSDP query discovered %d %s servers", rcvd.size(), serviceClassName(serviceClass));
-  if (rcvd.size() == 0) return 0;   // return if none detected
+  if (chunked) {
+    if ((ret = soapChunkBegin()) < 0) return ret;
+  }
+  else if (m_xmlContentLeft == 0) {
+    return -1;   // end of content
+  }
+  if (m_rxBufferOffset >= m_rxBufferCount && !soapClientFillBuffer()) {
+    return chunked ? -5 : -1;   // timeout or connection closed
+  }
+  len = m_rxBufferCount - m_rxBufferOffset;
+  if (chunked) {
+    if (len > (size_t)m_xmlChunkCount) len = m_xmlChunkCount;
+  }
+  else if (len > m_xmlContentLeft) {
+    len = (size_t)m_xmlContentLeft;
+  }
+  *data = m_rxBuffer + m_rxBufferOffset;
 
-  if (serviceClass==DMS) { log_i("checking all discovered servers for service ContentDirectory"); }
-  if (serviceClass==DMR) { log_i("checking all discovered servers for service AVTransport"); }
-
-  int j = 0;
-  uint64_t contentSize;
-  bool chunked, gotFriendlyName, gotServiceType;
-  String result((char *)0);
-  MiniXPath xPath;
-  soapServer_t srv;
+  return (int)len;
+}
 
-  // examine all media servers that answered our SSDP multicast enquiry
-  while (j < rcvd.size()) {
+//
+// helper function: count bytes of reply content returned by soapBodyPeek() have been consumed
+//
+int SoapESP32::soapBodySkip(bool chunked, size_t count)
+{
+  m_rxBufferOffset += count;
+  if (chunked) return soapChunkConsumed(count);
+  m_xmlContentLeft -= count;
 
-    // try to establish connection to server and send GET request
-    if (!soapGet(rcvd[j].ip, rcvd[j].port, rcvd[j].location.c_str())) goto end;
-    log_i("connected successfully to server %s:%d", rcvd[j].ip.toString().c_str(), rcvd[j].port);
+  return 0;
+}
 
-    // ok, connection established
-    srv = { .ip = rcvd[j].ip, .port = rcvd[j].port, .location = rcvd[j].location, .friendlyName = "" };
-    gotFriendlyName = false;
-    gotServiceType = false;
+//
+// helper function: read next byte of reply content (de-chunked, not inflated)
+//
+int SoapESP32::soapBodyRead(bool chunked)
+{
+  const uint8_t *data;
+  int c, ret;
 
-    // reading HTTP header
-    if (!soapReadHttpHeader(&contentSize, &chunked)) {
-      goto end_stop_error;
-    }
-    if (!chunked && contentSize == 0) {  
-      log_w("announced XML size: 0, we can stop here"); 
-      goto end_stop_error;
-    }  
+  if ((ret = soapBodyPeek(chunked, &data)) < 0) return ret;
+  c = *data;
+  if ((ret = soapBodySkip(chunked, 1)) < 0) return ret;
 
-    // scan XML block for description: friendly name, service type "ContentDirectory"/"AVTransport" & associated control URL
-    xPath.reset();
-    xPath.setPath(xmlParserPaths[xpFriendlyName].tagNames, xmlParserPaths[xpFriendlyName].num);
-    while (true) {
-      int ret = soapReadXML(chunked);
-      if (ret < 0) {
-        log_w("soapReadXML() returned: %d", ret); 
-        goto end_stop_error;
-      }       
-
-      if (!gotFriendlyName) {
-        if (xPath.getValue((char)ret, &result)) {
-          srv.friendlyName = (result.length() > 0) ? result : "Server name not provided";
-          log_d("scanned friendly name: %s", srv.friendlyName.c_str());
-          gotFriendlyName = true;
-          // we got friendly name and now set xPath for service type which comes next
-          xPath.setPath(xmlParserPaths[xpServiceType].tagNames, xmlParserPaths[xpServiceType].num);
-          continue;
-        }  
-      }
-      else if (!gotServiceType) {
-        if (xPath.getValue((char)ret, &result)) {
-          log_d("found service: %s", result.c_str());
-          if (strstr(result.c_str(), serviceSchema(serviceClass))) {
-            log_d("server offers service: %s", serviceSchema(serviceClass));
-            gotServiceType = true;
-            // We got service type and now set xPath for control url (follows in same <service> block)
-            xPath.setPath(xmlParserPaths[xpControlUrl].tagNames, xmlParserPaths[xpControlUrl].num);
-            continue;
-          }
-        }
-      }
-      else if (xPath.getValue((char)ret, &result)) {
-        // we finally got all infos we need
-        if (srv.location.endsWith("/")) srv.controlURL = srv.location;  // location string becomes first part of controlURL 
-        srv.controlURL += result;
-        if (srv.controlURL.startsWith("http://")) {
-          // remove "http://ip:port/" from begin of string
-          srv.controlURL.replace("http://", "");        
-          srv.controlURL = srv.controlURL.substring(srv.controlURL.indexOf("/") + 1); 
-        }
-        log_d("assigned controlURL: %s", srv.controlURL.c_str());
-        log_i("ok, this server delivers required service");
-        m_server.push_back(srv);  // add server to server list
-        goto end_stop;
-      }
-    }
-end_stop_error:
-    log_i("this Server does not deliver required content: %s", serviceSchema(serviceClass));
-end_stop:
-    claimSPI();
-    m_client->stop();
-    releaseSPI();
-end:
-    j++;
-  }
-  return m_server.size();
+  return c;
 }
 
 //
-// add a server manually to server list 
+// gzip decoder: inflated data goes into dictionary (history window) and is delivered from there
 //
-bool SoapESP32::addServer(IPAddress ip, uint16_t port, const char *controlURL, const char *name)
+#define GZIP_FLAG_FHCRC     0x02
+#define GZIP_FLAG_FEXTRA    0x04
+#define GZIP_FLAG_FNAME     0x08
+#define GZIP_FLAG_FCOMMENT  0x10
+
+#ifdef SOAP_GZIP
+struct soapInflate_t
 {
-  soapServer_t srv;
-  int i;
-  
-  // just some basic checks
-  if (!ip || !port || 
-      !name || strlen(name) == 0 ||
-      !controlURL || strlen(controlURL) == 0) {
-    log_e("at least on parameter is invalid");
-    return false;
-  }
+  tinfl_decompressor decomp;
+  uint8_t  dict[TINFL_LZ_DICT_SIZE];
+  size_t   dictOffset;                 // write position of decoder
+  size_t   readOffset;                 // next inflated byte to deliver
+  size_t   readEnd;
+  bool     moreOutput;                 // decoder has inflated data left without needing new input
+  bool     done;                       // end of compressed data
+};
+#else
+struct soapInflate_t
+{
+};
+#endif
 
-  // refuse entry in list when ip & port are identical
-  for (i = 0; i < m_server.size(); i++) {
-    if (m_server.operator[](i).ip == ip && m_server.operator[](i).port == port) break;               
+//
+// helper function: make next bytes of gzip compressed content available inflated (no copy)
+// returns number of contiguous bytes at *data (at least 1), -1 at end of compressed data, 
+// -7 invalid gzip data, -8 out of memory or error code of soapBodyPeek()
+//
+int SoapESP32::soapInflatePeek(bool chunked, const uint8_t **data)
+{
+#ifdef SOAP_GZIP
+  int c, i, ret;
+
+  if (!m_inflate) {
+    // skip gzip header: magic, method, flags, time, extra flags, os & optional fields
+    uint8_t header[10];
+    for (i = 0; i < sizeof(header); i++) {
+      if ((c = soapBodyRead(chunked)) < 0) return c;
+      header[i] = c;
+    }
+    if (header[0] != 0x1f || header[1] != 0x8b || header[2] != 8) {
+      log_e("content is not gzip compressed");
+      return -7;
+    }
+    if (header[3] & GZIP_FLAG_FEXTRA) {
+      int lo = soapBodyRead(chunked), hi = soapBodyRead(chunked);
+      if (lo < 0 || hi < 0) return -7;
+      for (i = lo + (hi << 8); i > 0; i--) {
+        if ((c = soapBodyRead(chunked)) < 0) return c;
+      }
+    }
+    if (header[3] & GZIP_FLAG_FNAME) {
+      while ((c = soapBodyRead(chunked)) > 0);
+      if (c < 0) return c;
+    }
+    if (header[3] & GZIP_FLAG_FCOMMENT) {
+      while ((c = soapBodyRead(chunked)) > 0);
+      if (c < 0) return c;
+    }
+    if (header[3] & GZIP_FLAG_FHCRC) {
+      if (soapBodyRead(chunked) < 0 || (c = soapBodyRead(chunked)) < 0) return -7;
+    }
+    if ((m_inflate = (soapInflate_t *)malloc(sizeof(soapInflate_t))) == NULL) {
+      log_e("not enough memory for gzip decoder");
+      return -8;
+    }
+    tinfl_init(&m_inflate->decomp);
+    m_inflate->dictOffset = m_inflate->readOffset = m_inflate->readEnd = 0;
+    m_inflate->moreOutput = m_inflate->done = false;
   }
-  if (i < m_server.size()) return false;
 
-  srv.ip = ip;  
-  srv.port = port;
-  srv.controlURL = controlURL;
-  srv.friendlyName = name;
+  while (m_inflate->readOffset >= m_inflate->readEnd) {
+    const uint8_t *in = NULL;
+    size_t inSize = 0, outSize = TINFL_LZ_DICT_SIZE - m_inflate->dictOffset;
 
-  // add server to list
-  m_server.push_back(srv);
+    if (m_inflate->done) return -1;    // end of XML, gzip trailer (CRC & size) gets skipped by soapDrainResponse()
+    if (!m_inflate->moreOutput) {
+      if ((ret = soapBodyPeek(chunked, &in)) < 0) return ret;
+      inSize = ret;
+    }
+    tinfl_status status = tinfl_decompress(&m_inflate->decomp, in, &inSize, m_inflate->dict, 
+                                           m_inflate->dict + m_inflate->dictOffset, &outSize, 
+                                           TINFL_FLAG_HAS_MORE_INPUT);
+    if (inSize > 0 && (ret = soapBodySkip(chunked, inSize)) < 0) return ret;
+    if (status < TINFL_STATUS_DONE) {
+      log_e("gzip data corrupt, decoder status: %d", status);
+      return -7;
+    }
+    m_inflate->readOffset = m_inflate->dictOffset;
+    m_inflate->readEnd = m_inflate->dictOffset + outSize;
+    m_inflate->dictOffset = (m_inflate->dictOffset + outSize) & (TINFL_LZ_DICT_SIZE - 1);
+    m_inflate->moreOutput = (status == TINFL_STATUS_HAS_MORE_OUTPUT);
+    m_inflate->done = (status == TINFL_STATUS_DONE);
+  }
 
-  return true;
+  *data = m_inflate->dict + m_inflate->readOffset;
+
+  return (int)(m_inflate->readEnd - m_inflate->readOffset);
+#else
+  log_e("gzip compressed content, no decoder available");
+  return -7;
+#endif
 }
 
 //
-// erase all entries in server list
+// helper function: release gzip decoder at end of reply
 //
-void SoapESP32::clearServerList()
+void SoapESP32::soapInflateEnd()
 {
-  m_server.clear();
+  m_httpGzip = false;
+  if (m_inflate) {
+    free(m_inflate);
+    m_inflate = NULL;
+  }
 }
 
 //
-// helper function: scan for certain attribute
+// helper function: next bytes of XML content (de-chunked & inflated), see soapBodyPeek()
 //
-bool SoapESP32::soapScanAttribute(const String *attributes, String *result, const char *what)
+int SoapESP32::soapXmlPeek(bool chunked, const uint8_t **data)
 {
-  int begin, end;
+  return m_httpGzip ? soapInflatePeek(chunked, data) : soapBodyPeek(chunked, data);
+}
 
-  if ((begin = attributes->indexOf(what)) >= 0 &&
-      (end = attributes->indexOf("\"", begin + strlen(what) + 1)) >= begin + strlen(what) + 1) {
-    *result = attributes->substring(begin + strlen(what) + 1, end);
-    if (result->length() > 0) return true;
+//
+// helper function: count bytes returned by soapXmlPeek() have been consumed
+//
+int SoapESP32::soapXmlSkip(bool chunked, size_t count)
+{
+#ifdef SOAP_GZIP
+  if (m_httpGzip) {
+    m_inflate->readOffset += count;
+    return 0;
   }
+#endif
+  return soapBodySkip(chunked, count);
+}
 
-  *result = "";   // empty for next call
-  log_d("attribute: \"%s\" missing.", what);
+//
+// helper function: collect name of XML entity following '&' (up to and including ';') from buffered 
+// content, stops in front of a char that can't be part of it. Returns length or error code (< 0)
+//
+int SoapESP32::soapXmlToken(bool chunked, char *token, size_t size)
+{
+  const uint8_t *data;
+  size_t n = 0;
+  int len, i, ret;
+
+  while (n < size) {
+    if ((len = soapXmlPeek(chunked, &data)) < 0) return n ? n : len;
+    for (i = 0; i < len && n < size; i++) {
+      char c = data[i];
+      if (c != ';' && c != '#' && !isalnum((uint8_t)c)) break;
+      token[n++] = c;
+      if (c == ';') {
+        i++;
+        break;
+      }
+    }
+    if ((ret = soapXmlSkip(chunked, i)) < 0) return ret;
+    if (i < len || token[n - 1] == ';') break;
+  }
 
-  return false;
+  return n;
 }
 
 //
-// scan <container> content in SOAP answer
+// helper function: value (unicode code point) of XML entity name like "lt;", "#233;" or "#x2019;"
+// returns -1 if incomplete or unknown
 //
-bool SoapESP32::soapScanContainer(const String *parentId, 
-                                  const String *attributes, 
-                                  const String *container, 
-                                  soapObjectVect_t *browseResult)
+static int32_t soapXmlEntityValue(const char *token, size_t len)
 {
-  int i = 0;
-  soapObject_t info;
-  String str((char *)0);
+  if (len < 3 || token[--len] != ';') return -1;
+
+  if (token[0] == '#') {
+    // numeric character reference, decimal or hex
+    uint32_t value = 0, base = 10;
+    size_t i = 1;
+    if (token[1] == 'x' || token[1] == 'X') {
+      base = 16;
+      i = 2;
+    }
+    if (i >= len) return -1;
+    for (; i < len; i++) {
+      char c = token[i];
+      uint32_t digit = (c >= '0' && c <= '9') ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : 
+                       (c >= 'A' && c <= 'F') ? c - 'A' + 10 : 16;
+      if (digit >= base || (value = value * base + digit) > 0x10FFFF) return -1;
+    }
+    if (value == 0 || (value >= 0xD800 && value <= 0xDFFF)) return -1;   // no valid character
+    return value;
+  }
 
-  log_d("function entered, parent id: %s", parentId->c_str());
+  // predefined entities
+  switch (token[0]) {
+    case 'a':
+      if (len == 3 && token[1] == 'm' && token[2] == 'p') return '&';
+      if (len == 4 && memcmp(token, "apos", 4) == 0) return '\'';
+      break;
+    case 'g':
+      if (len == 2 && token[1] == 't') return '>';
+      break;
+    case 'l':
+      if (len == 2 && token[1] == 't') return '<';
+      break;
+    case 'q':
+      if (len == 4 && memcmp(token, "quot", 4) == 0) return '"';
+      break;
+  }
 
-  // scan container id
-  if (!soapScanAttribute(attributes, &str, DIDL_ATTR_ID)) return false;           // container id is a must
-  log_d("%s\"%s\"", DIDL_ATTR_ID, str.c_str());
-  info.id = str;
+  return -1;
+}
 
-  // scan parent id
-  if (!soapScanAttribute(attributes, &str, DIDL_ATTR_PARENT_ID)) return false;    // parent id is a must
-  if (!strcasestr(str.c_str(), parentId->c_str())) {
-#ifdef PARENT_ID_MUST_MATCH
-    log_e("scanned parent id \"%s\" != requested parent id \"%s\"", str.c_str(), parentId->c_str());
-    return false;
-#else
-    log_w("scanned parent id \"%s\" != requested parent id \"%s\"", str.c_str(), parentId->c_str());
-#endif  
+//
+// helper function: UTF-8 encoding of unicode code point, returns length
+//
+static size_t soapUtf8(uint32_t value, char *out)
+{
+  if (value < 0x80) {
+    out[0] = value;
+    return 1;
   }
-  info.parentId = *parentId;  
-  info.size = 0;
-  info.sizeMissing = false;
-
-  // scan child count...not always provided (e.g. Kodi)
-  if (!soapScanAttribute(attributes, &str, DIDL_ATTR_CHILD_COUNT)) { 
-    info.sizeMissing = true;
+  if (value < 0x800) {
+    out[0] = 0xC0 | (value >> 6);
+    out[1] = 0x80 | (value & 0x3F);
+    return 2;
   }
-  else {
-    log_d("%s\"%s\"", DIDL_ATTR_CHILD_COUNT, str.c_str());
-    if ((info.size = (int)str.toInt()) == 0) {
-      log_i("container \"%s\" child count=0", info.id.c_str());
-    }
+  if (value < 0x10000) {
+    out[0] = 0xE0 | (value >> 12);
+    out[1] = 0x80 | ((value >> 6) & 0x3F);
+    out[2] = 0x80 | (value & 0x3F);
+    return 3;
   }
+  out[0] = 0xF0 | (value >> 18);
+  out[1] = 0x80 | ((value >> 12) & 0x3F);
+  out[2] = 0x80 | ((value >> 6) & 0x3F);
+  out[3] = 0x80 | (value & 0x3F);
+  return 4;
+}
 
-  // scan searchable flag...not always provided (e.g. UMS)
-  if (!soapScanAttribute(attributes, &str, DIDL_ATTR_SEARCHABLE)) {
-    log_w("attribute \"%s\" is missing, we set it true", DIDL_ATTR_SEARCHABLE);
-    info.searchable = true;
-  }  
-  else {
-    log_d("%s\"%s\"", DIDL_ATTR_SEARCHABLE, str.c_str());
-    info.searchable = (1 == (int)str.toInt()) ? true : false;
-    if (!info.searchable) {
-      log_i("\"%s\" attribute searchable=0", info.id.c_str());
+//
+// read XML data, de-chunk (& inflate) if needed & replace XML entities that spoil MiniXPath.
+// The DIDL-Lite result is escaped twice: "&lt;" becomes '<', "&amp;amp;" becomes '&' and 
+// "&amp;#233;" or "&#233;" become UTF-8 sequences. DIDL entities "&lt;"/"&gt;" stay as they 
+// are and a quote ("&amp;quot;") becomes '\'', so that attribute values stay intact
+//
+#define XML_ENTITY_MAX  10    // longest entity name we replace ("#x10FFFF;")
+
+int SoapESP32::soapReadXML(bool chunked, bool replace)
+{
+  const uint8_t *data;
+  char token[XML_ENTITY_MAX];
+  int32_t value;
+  int c, len;
+
+  if (replace && m_xmlReplaceState == xmlTakeFromBuffer) {
+    // rest of a sequence we don't replace or of an UTF-8 sequence
+    c = (uint8_t)m_xmlReplaceBuffer[m_xmlReplaceOffset++];
+    if (m_xmlReplaceBuffer[m_xmlReplaceOffset] == '\0') {
+      m_xmlReplaceState = xmlPassthrough;
     }
+    return c;
   }
 
-  // scan container name
-  MiniXPath xPath;
-  xPath.setPath(xmlParserPaths[xpTitle].tagNames, xmlParserPaths[xpTitle].num);
-  while (i < container->length()) {
-    if (xPath.getValue((char)container->operator[](i), &str)) {
-      if (str.length() == 0) return false;    // valid title is a must
-      info.name = str;
-      log_d("title=\"%s\"", str.c_str());
-      break;
+  // next byte of content (de-chunked & inflated if needed)
+  if ((len = soapXmlPeek(chunked, &data)) < 0) return len;
+  c = *data;
+  if ((len = soapXmlSkip(chunked, 1)) < 0) return len;
+  if (!replace || c != '&') return c;
+
+  // XML entity of SOAP message
+  if ((len = soapXmlToken(chunked, token, sizeof(token))) < 0) return len;
+  value = soapXmlEntityValue(token, len);
+  if (value == '&') {
+    // "&amp;": '&' of DIDL-Lite text, might start a DIDL entity
+    char *p = m_xmlReplaceBuffer + 1;
+    if ((len = soapXmlToken(chunked, p, XML_ENTITY_MAX)) < 0) len = 0;
+    value = soapXmlEntityValue(p, len);
+    if (value == '<' || value == '>') value = -1;
+    else if (value == '"') value = '\'';
+    if (value < 0) {
+      // single '&' or sequence we don't replace
+      m_xmlReplaceBuffer[0] = '&';
+      m_xmlReplaceBuffer[len + 1] = '\0';
+      len++;
     }
-    i++;
   }
+  else if (value < 0) {
+    // sequence we don't replace
+    m_xmlReplaceBuffer[0] = '&';
+    memcpy(m_xmlReplaceBuffer + 1, token, len);
+    m_xmlReplaceBuffer[len + 1] = '\0';
+    len++;
+  }
+  if (value >= 0) {
+    if (value < 0x80) return value;
+    len = soapUtf8(value, m_xmlReplaceBuffer);
+    m_xmlReplaceBuffer[len] = '\0';
+  }
+  if (len == 1) return (uint8_t)m_xmlReplaceBuffer[0];
+  m_xmlReplaceState = xmlTakeFromBuffer;
+  m_xmlReplaceOffset = 1;
 
-  // add valid container to result list
-  info.isDirectory = true;
-  browseResult->push_back(info);
-  log_i("folder \"%s\" (id: \"%s\", childCount: %llu) added to list", info.name.c_str(), info.id.c_str(), info.size);
-
-  return true; 
+  return (uint8_t)m_xmlReplaceBuffer[0];
 }
 
 //
-// scan <item> content in SOAP answer
+// read & discard rest of server reply (up to end of content or after final chunk)
 //
-bool SoapESP32::soapScanItem(const String *parentId, 
-                             const String *attributes, 
-                             const String *item, 
-                             soapObjectVect_t *browseResult)
+bool SoapESP32::soapDrainResponse(bool chunked)
 {
-  soapObject_t info;
-  int i = 0, port;
-  char address[20];
-  IPAddress ip;
-  String str((char *)0);
+  char tmpBuffer[TMP_BUFFER_SIZE_200];
+  const uint8_t *data;
+  int len;
 
-  log_d("function entered, parent id: %s", parentId->c_str());
+  // skip rest of content or remaining chunks (raw, compressed content isn't inflated)
+  while ((len = soapBodyPeek(chunked, &data)) > 0) {
+    if (soapBodySkip(chunked, len) < 0) return false;
+  }
+  if (!chunked) return len == -1 && m_xmlContentLeft == 0;
+  if (!m_xmlChunkFinal) return false;
 
-  // scan item id
-  if (!soapScanAttribute(attributes, &str, DIDL_ATTR_ID)) return false;         // id is a must
-  log_d("%s\"%s\"", DIDL_ATTR_ID, str.c_str());
-  info.id = str; 
+  // skip optional trailer, an empty line marks the end
+  while (true) {
+    size_t len = soapClientReadBytesUntil('\n', tmpBuffer, sizeof(tmpBuffer) - 1);
+    if (len == 0) return false;
+    if (len == 1) return true;
+  }
+}
 
-  // scan parent id
-  if (!soapScanAttribute(attributes, &str, DIDL_ATTR_PARENT_ID)) return false;  // parent id is a must
-  if (!strcasestr(str.c_str(), parentId->c_str())) {
-#ifdef PARENT_ID_MUST_MATCH
-    log_e("scanned parent id \"%s\" != requested parent id \"%s\"", str.c_str(), parentId->c_str());
-    return false;
-#else
-    log_w("scanned parent id \"%s\" != requested parent id \"%s\"", str.c_str(), parentId->c_str());
-#endif
+//
+// finish reading a server reply: keep connection for the next request (keep-alive) 
+// or close it. Parameter complete indicates reply has been read without error
+//
+void SoapESP32::soapFinishResponse(bool chunked, bool complete)
+{
+  soapInflateEnd();
+  if (m_keepAlive && m_connKeepAlive && complete && soapDrainResponse(chunked) && 
+      m_rxBufferOffset >= m_rxBufferCount) {
+    // reply complete and nothing read beyond it (would belong to no request)
+    m_connReusable = true;
+    log_d("connection to server kept open");
+    return;
   }
+  soapClientStop();
+}
 
-  info.parentId = *parentId; 
-  info.fileType = fileTypeOther;
-  info.album = "";
-  info.artist = "";
-  info.bitrate = 0;
-  info.sampleFrequency = 0;
-  info.size = 0;
-  info.sizeMissing = false;
-  info.albumArtUri = "";
-  info.iconUri = "";
-
-  // scan for uri, size, album (sometimes dir name when picture file) and title, artist (when audio file)
-  MiniXPath xPathTitle, xPathAlbum, xPathArtist, xPathClass, xPathRes, xPathAlbumArt, xPathIcon;
-  String strAttr((char *)0);
-  bool gotTitle = false, gotAlbum = false, gotArtist = false, gotClass = false, gotRes = false, gotAlbumArt = false, gotIcon = false;
-
-  xPathTitle.setPath(xmlParserPaths[xpTitle].tagNames, xmlParserPaths[xpTitle].num);
-  xPathAlbum.setPath(xmlParserPaths[xpAlbum].tagNames, xmlParserPaths[xpAlbum].num);
-  xPathArtist.setPath(xmlParserPaths[xpArtist].tagNames, xmlParserPaths[xpArtist].num);
-  xPathClass.setPath(xmlParserPaths[xpClass].tagNames, xmlParserPaths[xpClass].num);
-  xPathRes.setPath(xmlParserPaths[xpResource].tagNames, xmlParserPaths[xpResource].num);
-  xPathAlbumArt.setPath(xmlParserPaths[xpAlbumArt].tagNames, xmlParserPaths[xpAlbumArt].num);
-  xPathIcon.setPath(xmlParserPaths[xpIcon].tagNames, xmlParserPaths[xpIcon].num);
-  while (i < item->length()) {
-    if (!gotTitle && xPathTitle.getValue((char)item->operator[](i), &str)) {
-      if (str.length() == 0) return false;    // title is a must 
-      info.name = str;
-      log_d("title=\"%s\"", str.c_str());
-      gotTitle = true;
-    }
-    if (!gotAlbum && xPathAlbum.getValue((char)item->operator[](i), &str)) {
-      info.album = str;                       // missing album not a showstopper
-      log_d("album=\"%s\"", str.c_str());;
-      gotAlbum = true;
-    }
-    if (!gotArtist && xPathArtist.getValue((char)item->operator[](i), &str)) {
-      info.artist = str;                      // missing artist not a showstopper
-      log_d("artist=\"%s\"", str.c_str());
-      gotArtist = true;
-    }
-    if (!gotAlbumArt && xPathAlbumArt.getValue((char)item->operator[](i), &str)) {
-      info.albumArtUri = str;                      // missing album art not a showstopper
-      log_d("albumArtUri=\"%s\"", str.c_str());
-      gotAlbumArt = true;
-    }
-    if (!gotIcon && xPathIcon.getValue((char)item->operator[](i), &str)) {
-      info.iconUri = str;                      // missing icon not a showstopper
-      log_d("iconUri=\"%s\"", str.c_str());
-      gotIcon = true;
-    }
-    if (!gotClass && xPathClass.getValue((char)item->operator[](i), &str)) {
-      log_d("class=\"%s\"", str.c_str());
-      if (str.indexOf("audioItem") >= 0) 
-        info.fileType = fileTypeAudio;
-      else if (str.indexOf("imageItem") >= 0) 
-        info.fileType = fileTypeImage;
-      else if (str.indexOf("videoItem")) 
-        info.fileType = fileTypeVideo;
-      else 
-        info.fileType = fileTypeOther;
-      gotClass = true;
-    }
-    if (!gotRes && xPathRes.getValue((char)item->operator[](i), &str, &strAttr)) {
-      log_v("str=\"%s\"", str.c_str());
-      if (str.startsWith("http://")) {
-        // scan for download ip & port
-        if (sscanf(str.c_str(), "http://%[0-9.]:%d/", address, &port) != 2) return false;
-        info.downloadPort = (uint16_t)port;
-        if (!ip.fromString(address)) return false;
-        info.downloadIp = ip;
-        // now remove "http://ip:port/" from begin of string
-        str.replace("http://", "");        
-        info.uri = str.substring(str.indexOf("/") + 1); 
-      }
-      else {
-        info.uri = str;
-      }
-      if (info.uri.length() == 0) { 
-        log_w("empty URI");
-        return false;   // valid URI is a must     
-      }
-      log_d("uri=\"%s\"", info.uri.c_str());
+//
+// searching local network for media servers that offer media content
+// parameter workers > 1: fetch device descriptions concurrently (FreeRTOS tasks with own client)
+// returns number of servers found
+//
+uint8_t SoapESP32::seekServer(serviceClass_et serviceClass, uint8_t workers)
+{
+  soapServerVect_t rcvd, found;
+  soapServer_t srv;
 
-      // scan item size
-      if (!soapScanAttribute(&strAttr, &str, DIDL_ATTR_SIZE)) {
-        // indicates missing attribute "size" (e.g. Kodi audio files, Fritzbox/Serviio stream items)
-        info.sizeMissing = true;
-      } 
-      else {
-        info.size = strtoull(str.c_str(), NULL, 10);
-        log_d("size=%llu", info.size);
-      }
-#if !defined(SHOW_EMPTY_FILES)
-      if (info.size == 0 && !info.sizeMissing) {        
-        log_w("reported size=0, item ignored"); 
-        return false;
-      }
-#endif        
+  if (!m_udp) {
+    log_e("no UDP object, seeking servers not possible (session ?)");
+    return getServerCount();
+  }
 
-      // scan bitrate (often provided when audio file)
-      if (soapScanAttribute(&strAttr, &str, DIDL_ATTR_BITRATE)) {
-        info.bitrate = (size_t)str.toInt();
-        if (info.bitrate == 0) {
-          log_w("bitrate=0 !"); 
-        }              
-        else { 
-          log_d("bitrate=%d", info.bitrate);
-        }  
-      }  
-
-      // scan sample frequency (often provided when audio file)
-      if (soapScanAttribute(&strAttr, &str, DIDL_ATTR_SAMPLEFREQU)) {
-        info.sampleFrequency = (size_t)str.toInt();
-        if (info.sampleFrequency == 0) {
-          log_w("sampleFrequency=0");   
-        }            
-        else { 
-          log_d("sampleFrequency=%d", info.sampleFrequency);
-        }  
-      }  
+  log_i("SSDP search for %s media servers started", serviceClassName(serviceClass));
+  soapSSDPquery(&rcvd, serviceClass);
 
-      gotRes = true;
-    }
-    i++;
+  log_i("SSDP query discovered %d %s servers", rcvd.size(), serviceClassName(serviceClass));
+  if (rcvd.size() == 0) {
+    // return if none detected, known servers are kept as offline
+    soapMergeServerList(&found);
+    return 0;      
   }
 
-  if (!gotTitle || !gotRes) {
-    log_i("title or ressource info missing, file not added to list");
-    return false;   // title & ressource info is a must
-  }  
+  if (serviceClass==DMS) { log_i("checking all discovered servers for service ContentDirectory"); }
+  if (serviceClass==DMR) { log_i("checking all discovered servers for service AVTransport"); }
 
-  // add valid file to result list
-  info.isDirectory = false;
-  browseResult->push_back(info);
+  if (workers > SOAP_DISCOVERY_MAX_WORKERS) workers = SOAP_DISCOVERY_MAX_WORKERS;
+  if (workers > rcvd.size()) workers = rcvd.size();
+  if (workers <= 1 || !soapSeekParallel(&rcvd, &found, serviceClass, workers)) {
+    // examine all media servers that answered our SSDP multicast enquiry, one after another
+    for (int j = 0; j < rcvd.size(); j++) {
+      if (soapFetchDescription(&rcvd[j], serviceClass, &srv)) {
+        found.push_back(srv);  
+      }
+    }
+  }
 
-  log_i("\"%s\" (id: \"%s\", size: %llu, sizeMissing: %s, type: %s) added to list", 
-        info.name.c_str(), info.id.c_str(), info.size, info.sizeMissing ? "true" : "false", getFileTypeName(info.fileType));
+  soapMergeServerList(&found);
 
-  return true;
+  return found.size();
 }
 
 //
-// browse a SOAP container object (directory) on a media server for content 
+// helper function: merge servers found by a scan into server list. Servers are matched by ip:port
+// and keep their index, replica group & health. New ones get appended, missing ones marked offline
 //
-bool SoapESP32::browseServer(const uint8_t srv,              // server number in list
-                             const char *objectId,           // directory to browse, "0" represents root according to spec
-                             soapObjectVect_t *browseResult, // where to store browse results (directory content)
-                             // optional parameter
-                             const uint32_t startingIndex,   // offset into directory content list
-                             const uint16_t maxCount)        // limits number of objects in result list
+void SoapESP32::soapMergeServerList(soapServerVect_t *found)
 {
-  if (srv >= m_server.size()) {
-    log_e("invalid server number: %d", srv);
-    return false;
+  claimServerList();
+  for (size_t i = 0; i < m_server.size(); i++) m_server[i].online = false;
+  for (size_t j = 0; j < found->size(); j++) {
+    size_t i;
+    for (i = 0; i < m_server.size(); i++) {
+      if (m_server[i].ip == (*found)[j].ip && m_server[i].port == (*found)[j].port) break;
+    }
+    if (i == m_server.size()) {
+      m_server.push_back((*found)[j]);
+      continue;
+    }
+    soapServer_t *srv = &m_server[i];
+    srv->location = (*found)[j].location;
+    srv->friendlyName = (*found)[j].friendlyName;
+    srv->controlURL = (*found)[j].controlURL;
+    srv->uuid = (*found)[j].uuid;
+    srv->eventSubURL = (*found)[j].eventSubURL;
+    srv->renderingControlURL = (*found)[j].renderingControlURL;
+    srv->online = true;
   }
-  log_i("new search on server: \"%s\", objectId: \"%s\"", m_server[srv].friendlyName.c_str(), objectId);
+  releaseServerList();
+}
 
-  if (startingIndex != SOAP_DEFAULT_BROWSE_STARTING_INDEX) 
-    log_d("special browse parameter \"startingIndex\": %d", startingIndex);
-  if (maxCount != SOAP_DEFAULT_BROWSE_MAX_COUNT) 
-    log_d("special browse parameter \"maxCount\": %d", maxCount);
+//
+// helper function: service URL (control/event) relative to server, without "http://ip:port/"
+//
+static String soapServiceUrl(const String &location, const String &url)
+{
+  String str((char *)0);
 
-  // send SOAP browse request
-  if (!soapBrowsePost(m_server[srv].ip, m_server[srv].port, m_server[srv].controlURL.c_str(), objectId,
-                startingIndex, maxCount)) {
-    return false;
-  }  
-  log_i("connected successfully to server %s:%d", m_server[srv].ip.toString().c_str(), m_server[srv].port);
+  if (location.endsWith("/")) str = location;  // location string becomes first part of URL 
+  str += url;
+  if (str.startsWith("http://")) {
+    // remove "http://ip:port/" from begin of string
+    str.replace("http://", "");        
+    str = str.substring(str.indexOf("/") + 1); 
+  }
 
-  // evaluate SOAP answer
+  return str;
+}
+
+//
+// helper function: read device description of a discovered server and check if it offers 
+// the required service. Reading is given up after SOAP_DISCOVERY_DEADLINE ms
+//
+bool SoapESP32::soapFetchDescription(const soapServer_t *rcvd, serviceClass_et serviceClass, soapServer_t *srv)
+{
   uint64_t contentSize;
-  bool chunked = false;
-  int count = 0, countContainer = 0, countItem = 0;
-  MiniXPath xPathContainer, xPathContainerAlt1, xPathContainerAlt2,
-            xPathItem, xPathItemAlt1, xPathItemAlt2,
-            xPathNumberReturned, xPathNumberReturnedAlt1, xPathNumberReturnedAlt2;
-  String str((char *)0), strAttribute((char *)0);
+  bool chunked, start, gotService = false, ret = false;
+  String result((char *)0), type((char *)0), control((char *)0), event((char *)0);
+  MiniXPathMulti xPath;
+
+  m_deadline = millis() + SOAP_DISCOVERY_DEADLINE; 
+  if (m_deadline == 0) m_deadline = 1;   // 0 means no deadline
+
+  // try to establish connection to server and send GET request
+  if (!soapGet(rcvd->ip, rcvd->port, rcvd->location.c_str(), 0, 0, m_compression)) goto end;
+  log_i("connected successfully to server %s:%d", rcvd->ip.toString().c_str(), rcvd->port);
+
+  // ok, connection established
+  *srv = { .ip = rcvd->ip, .port = rcvd->port, .location = rcvd->location, .friendlyName = "Server name not provided" };
 
   // reading HTTP header
   if (!soapReadHttpHeader(&contentSize, &chunked)) {
-    log_e("HTTP Header not ok or reply status not 200");
-    claimSPI();
-    m_client->stop();
-    releaseSPI();
-    return false;
+    goto end_stop_error;
   }
   if (!chunked && contentSize == 0) {  
-    log_e("announced XML size: 0 !"); 
-    return false;
-  } 
-  log_i("scan answer from media server:"); 
-
-  // time to clean result list
-  browseResult->clear();
+    log_w("announced XML size: 0, we can stop here"); 
+    goto end_stop_error;
+  }  
 
-  // HTTP header ok, now scan XML/SOAP reply
-  String objId = objectId;  
-  xPathContainer.setPath(xmlParserPaths[xpBrowseContainer].tagNames, xmlParserPaths[xpBrowseContainer].num);
-  xPathContainerAlt1.setPath(xmlParserPaths[xpBrowseContainerAlt1].tagNames, xmlParserPaths[xpBrowseContainerAlt1].num);
-  xPathContainerAlt2.setPath(xmlParserPaths[xpBrowseContainerAlt2].tagNames, xmlParserPaths[xpBrowseContainerAlt2].num);
-  xPathItem.setPath(xmlParserPaths[xpBrowseItem].tagNames, xmlParserPaths[xpBrowseItem].num);
-  xPathItemAlt1.setPath(xmlParserPaths[xpBrowseItemAlt1].tagNames, xmlParserPaths[xpBrowseItemAlt1].num);
-  xPathItemAlt2.setPath(xmlParserPaths[xpBrowseItemAlt2].tagNames, xmlParserPaths[xpBrowseItemAlt2].num);
-  xPathNumberReturned.setPath(xmlParserPaths[xpBrowseNumberReturned].tagNames, xmlParserPaths[xpBrowseNumberReturned].num);
-  xPathNumberReturnedAlt1.setPath(xmlParserPaths[xpBrowseNumberReturnedAlt1].tagNames, xmlParserPaths[xpBrowseNumberReturnedAlt1].num);
-  xPathNumberReturnedAlt2.setPath(xmlParserPaths[xpBrowseNumberReturnedAlt2].tagNames, xmlParserPaths[xpBrowseNumberReturnedAlt2].num);
+  // scan XML block for description: friendly name & <service> blocks with service type 
+  // "ContentDirectory"/"AVTransport" (renderer: also "RenderingControl"), control & event URL
+  xPath.setPaths(xmlParserPaths, sizeof(xmlParserPaths) / sizeof(xPathParser_t));
   while (true) {
-    int ret = soapReadXML(chunked, true);  // de-chunk data stream and replace XML-entities (if found)
-    if (ret < 0) {
-      log_e("soapReadXML() returned: %d", ret); 
-      goto end_stop;
-    }  
-    // TEST
+    int c = soapReadXML(chunked);
+    if (c < 0) {
+      if (gotService) goto end_stop;    // end of description
+      log_w("soapReadXML() returned: %d", c); 
+      goto end_stop_error;
+    }       
+
+    int path = xPath.getValue((char)c, &result, NULL, &start);
+    switch (path) {
+      case xpFriendlyName:
+        if (result.length() > 0) srv->friendlyName = result;
+        log_d("scanned friendly name: %s", srv->friendlyName.c_str());
+        break;
+
+      case xpService:
+        if (start) {
+          type = control = event = "";
+          break;
+        }
+        // end of <service> block
+        log_d("found service: %s", type.c_str());
+        if (!gotService && strstr(type.c_str(), serviceSchema(serviceClass)) && control.length()) {
+          srv->controlURL = soapServiceUrl(srv->location, control);
+          if (event.length()) srv->eventSubURL = soapServiceUrl(srv->location, event);
+          log_d("assigned controlURL: %s, eventSubURL: %s", srv->controlURL.c_str(), srv->eventSubURL.c_str());
+          log_i("ok, this server delivers required service");
+          srv->uuid = rcvd->uuid;
+          ret = gotService = true;
+        }
+        else if (serviceClass == DMR && strstr(type.c_str(), UPNP_URN_SCHEMA_RENDERING_CONTROL) && control.length()) {
+          srv->renderingControlURL = soapServiceUrl(srv->location, control);
+          log_d("assigned renderingControlURL: %s", srv->renderingControlURL.c_str());
+        }
+        // media servers: nothing else needed, renderers: wait for rendering control too
+        if (gotService && (serviceClass != DMR || srv->renderingControlURL.length())) goto end_stop;
+        break;
+
+      case xpServiceType:
+        if (!start) type = result;
+        break;
+
+      case xpControlUrl:
+        if (!start) control = result;
+        break;
+
+      case xpEventSubUrl:
+        if (!start) event = result;
+        break;
+    }
+  }
+
+end_stop_error:
+  log_i("this Server does not deliver required content: %s", serviceSchema(serviceClass));
+end_stop:
+  soapClientStop();
+end:
+  m_deadline = 0;
+  return ret;
+}
+
+//
+// parallel discovery: shared job description & per worker task parameters
+//
+typedef struct {
+  soapServerVect_t *rcvd;                   // servers that answered SSDP query
+  soapServer_t     *result;                 // one result slot per server
+  bool             *found;                  // server offers required service
+  serviceClass_et   serviceClass;
+  size_t            next;                   // next server to be examined
+  SemaphoreHandle_t lock;                   // protects next
+  SemaphoreHandle_t done;                   // given by each worker task when finished
+} soapDiscoveryJob_t;
+
+typedef struct {
+  soapDiscoveryJob_t *job;
+  SoapESP32          *soap;                 // worker instance with own client
+} soapDiscoveryWorker_t;
+
+//
+// discovery worker task: fetch descriptions until no server is left
+//
+void SoapESP32::soapDiscoveryTask(void *param)
+{
+  soapDiscoveryWorker_t *worker = (soapDiscoveryWorker_t *)param;
+  soapDiscoveryJob_t *job = worker->job;
+
+  while (true) {
+    xSemaphoreTake(job->lock, portMAX_DELAY);
+    size_t j = job->next++;
+    xSemaphoreGive(job->lock);
+    if (j >= job->rcvd->size()) break;
+    job->found[j] = worker->soap->soapFetchDescription(&job->rcvd->operator[](j), job->serviceClass, &job->result[j]);
+  }
+
+  xSemaphoreGive(job->done);
+  vTaskDelete(NULL);
+}
+
+//
+// helper function: fetch device descriptions using several worker tasks, each with own client.
+// Results are added to list found in order of SSDP replies
+// returns false if no worker task could be started
+//
+bool SoapESP32::soapSeekParallel(soapServerVect_t *rcvd, soapServerVect_t *found, serviceClass_et serviceClass, uint8_t workers)
+{
+#ifdef USE_ETHERNET
+  EthernetClient client[SOAP_DISCOVERY_MAX_WORKERS];
+#else
+  WiFiClient client[SOAP_DISCOVERY_MAX_WORKERS];
+#endif
+  soapDiscoveryWorker_t worker[SOAP_DISCOVERY_MAX_WORKERS];
+  soapServerVect_t result(rcvd->size());
+  bool *ok = new bool[rcvd->size()]();
+  soapDiscoveryJob_t job = { .rcvd = rcvd, .result = result.data(), .found = ok, .serviceClass = serviceClass, 
+                             .next = 0, .lock = xSemaphoreCreateMutex(), .done = xSemaphoreCreateCounting(workers, 0) };
+  int started = 0;
+
+  if (job.lock && job.done) {
+    for (int i = 0; i < workers; i++) {
+#ifdef USE_ETHERNET
+      worker[started].soap = new SoapESP32(&client[i], NULL, m_SPIsem);
+#else
+      worker[started].soap = new SoapESP32(&client[i]);
+#endif
+      worker[started].soap->m_compression = m_compression;
+      worker[started].job = &job;
+      if (xTaskCreate(soapDiscoveryTask, "soapDiscovery", SOAP_DISCOVERY_TASK_STACK, &worker[started], 
+                      SOAP_DISCOVERY_TASK_PRIO, NULL) != pdPASS) {
+        log_w("could not start discovery task %d", i);
+        delete worker[started].soap;
+        break;
+      }
+      started++;
+    }
+    log_i("fetching server descriptions with %d worker tasks", started);
+
+    // wait for all workers to finish (each server takes SOAP_DISCOVERY_DEADLINE ms max.)
+    for (int i = 0; i < started; i++) xSemaphoreTake(job.done, portMAX_DELAY);
+    for (int i = 0; i < started; i++) delete worker[i].soap;
+  }
+
+  if (started > 0) {
+    for (int j = 0; j < rcvd->size(); j++) {
+      if (ok[j]) found->push_back(result[j]);
+    }
+  }
+
+  if (job.lock) vSemaphoreDelete(job.lock);
+  if (job.done) vSemaphoreDelete(job.done);
+  delete[] ok;
+
+  return started > 0;
+}
+
+//
+// start background task keeping server list up to date: servers announcing themselves 
+// with NOTIFY ssdp:alive are added, servers leaving with ssdp:byebye are marked offline
+// (entries stay in list, so server numbers don't change)
+//
+bool SoapESP32::startServerMonitor(serviceClass_et serviceClass)
+{
+  if (m_monitorTask) return true;   // already running
+
+  if (!m_serverLock) return false;
+  if (!m_monitorDone && !(m_monitorDone = xSemaphoreCreateBinary())) return false;
+
+  m_monitorClass = serviceClass;
+  m_monitorRun = true;
+  if (xTaskCreate(soapMonitorTask, "soapMonitor", SOAP_MONITOR_TASK_STACK, this, 
+                  SOAP_MONITOR_TASK_PRIO, &m_monitorTask) != pdPASS) {
+    log_e("could not start server monitor task");
+    m_monitorTask = NULL;
+    m_monitorRun = false;
+    return false;
+  }
+  log_i("server monitor for %s media servers started", serviceClassName(serviceClass));
+
+  return true;
+}
+
+//
+// stop server monitor task (waits until task has finished)
+//
+void SoapESP32::stopServerMonitor()
+{
+  if (!m_monitorTask) return;
+
+  m_monitorRun = false;
+  xSemaphoreTake(m_monitorDone, portMAX_DELAY);
+  m_monitorTask = NULL;
+  log_i("server monitor stopped");
+}
+
+//
+// server monitor task: listens to SSDP multicast NOTIFY packets, uses own UDP, client & 
+// SoapESP32 instance for reading device descriptions of new servers
+//
+void SoapESP32::soapMonitorTask(void *param)
+{
+  SoapESP32 *soap = (SoapESP32 *)param;
+
+  // inner scope: destructors (worker's mutex, client, udp) run before task gets deleted
+  {
+    char tmpBuffer[SSDP_TMP_BUFFER_SIZE];
+    soapServer_t srv, info;
+    size_t len;
+    bool known;
+    int i;
+#ifdef USE_ETHERNET
+    EthernetUDP udp;
+    EthernetClient client;
+    SoapESP32 worker(&client, NULL, soap->m_SPIsem);
+#else
+    WiFiUDP udp;
+    WiFiClient client;
+    SoapESP32 worker(&client);
+#endif
+
+    worker.m_compression = soap->m_compression;
+    soapClaimSPI(&worker);
+    uint8_t ret = udp.beginMulticast(IPAddress(SSDP_MULTICAST_IP), SSDP_MULTICAST_PORT);
+    soapReleaseSPI(&worker);
+    if (!ret) log_e("could not listen to SSDP multicast packets");
+
+    while (ret && soap->m_monitorRun) {
+      soapClaimSPI(&worker);
+      len = udp.parsePacket();
+      soapReleaseSPI(&worker);
+      if (!len) {
+        delay(SSDP_MONITOR_POLL_INTERVAL);
+        continue;
+      }
+      memset(tmpBuffer, 0, SSDP_TMP_BUFFER_SIZE);
+      if (len >= SSDP_TMP_BUFFER_SIZE) len = SSDP_TMP_BUFFER_SIZE - 1;
+      soapClaimSPI(&worker);
+      udp.read(tmpBuffer, len);
+      soapReleaseSPI(&worker);
+
+      switch (worker.soapScanSSDPpacket(tmpBuffer, soap->m_monitorClass, &srv)) {
+        case ssdpAlive:
+          // ignore servers already in list, those that left before are back online
+          soapClaimServerList(soap);
+          for (i = 0; i < soap->m_server.size(); i++) {
+            if (soap->m_server[i].ip == srv.ip && soap->m_server[i].port == srv.port) break;
+          }
+          known = (i < soap->m_server.size());
+          if (known && !soap->m_server[i].online) {
+            soap->m_server[i].online = true;
+            log_i("server \"%s\" back online", soap->m_server[i].friendlyName.c_str());
+          }
+          soapReleaseServerList(soap);
+          if (known || !worker.soapFetchDescription(&srv, soap->m_monitorClass, &info)) break;
+
+          soapClaimServerList(soap);
+          for (i = 0; i < soap->m_server.size(); i++) {
+            if (soap->m_server[i].ip == info.ip && soap->m_server[i].port == info.port) break;
+          }
+          if (i == soap->m_server.size()) {
+            soap->m_server.push_back(info);
+            log_i("server \"%s\" (%s:%d) added to list", info.friendlyName.c_str(), info.ip.toString().c_str(), info.port);
+          }
+          soapReleaseServerList(soap);
+          break;
+
+        case ssdpByebye:
+          soapClaimServerList(soap);
+          for (i = 0; i < soap->m_server.size(); i++) {
+            if (soap->m_server[i].online && soap->m_server[i].uuid.equalsIgnoreCase(srv.uuid)) {
+              log_i("server \"%s\" left, marked offline", soap->m_server[i].friendlyName.c_str());
+              soap->m_server[i].online = false;
+              break;
+            }
+          }
+          soapReleaseServerList(soap);
+          break;
+
+        default:
+          break;
+      }
+    }
+
+    soapClaimSPI(&worker);
+    udp.stop();
+    soapReleaseSPI(&worker);
+  }
+
+  xSemaphoreGive(soap->m_monitorDone);
+  vTaskDelete(NULL);
+}
+
+//
+// add a server manually to server list 
+//
+bool SoapESP32::addServer(IPAddress ip, uint16_t port, const char *controlURL, const char *name, const char *eventSubURL)
+{
+  soapServer_t srv;
+  int i;
+  
+  // just some basic checks
+  if (!ip || !port || 
+      !name || strlen(name) == 0 ||
+      !controlURL || strlen(controlURL) == 0) {
+    log_e("at least on parameter is invalid");
+    return false;
+  }
+
+  srv.ip = ip;  
+  srv.port = port;
+  srv.controlURL = controlURL;
+  srv.friendlyName = name;
+  if (eventSubURL) srv.eventSubURL = eventSubURL;
+
+  // refuse entry in list when ip & port are identical
+  claimServerList();
+  for (i = 0; i < m_server.size(); i++) {
+    if (m_server.operator[](i).ip == ip && m_server.operator[](i).port == port) break;               
+  }
+  bool ret = (i == m_server.size());
+  if (ret) m_server.push_back(srv);  // add server to list
+  releaseServerList();
+
+  return ret;
+}
+
+//
+// erase all entries in server list
+//
+void SoapESP32::clearServerList()
+{
+  claimServerList();
+  m_server.clear();
+  releaseServerList();
+}
+
+//
+// save server list to NVS (Preferences), so it can be restored after reboot without SSDP query
+//
+bool SoapESP32::saveServerList(const char *nvsNamespace, serviceClass_et serviceClass)
+{
+  Preferences prefs;
+  char key[16];
+
+  if (!prefs.begin(nvsNamespace, false)) {
+    log_e("could not open NVS namespace \"%s\"", nvsNamespace);
+    return false;
+  }
+  prefs.clear();
+
+  claimServerList();
+  uint8_t count = m_server.size();
+  for (int i = 0; i < count; i++) {
+    snprintf(key, sizeof(key), SOAP_NVS_KEY_IP, i);
+    prefs.putULong(key, (uint32_t)m_server[i].ip);
+    snprintf(key, sizeof(key), SOAP_NVS_KEY_PORT, i);
+    prefs.putUShort(key, m_server[i].port);
+    snprintf(key, sizeof(key), SOAP_NVS_KEY_LOCATION, i);
+    prefs.putString(key, m_server[i].location);
+    snprintf(key, sizeof(key), SOAP_NVS_KEY_NAME, i);
+    prefs.putString(key, m_server[i].friendlyName);
+    snprintf(key, sizeof(key), SOAP_NVS_KEY_CONTROL_URL, i);
+    prefs.putString(key, m_server[i].controlURL);
+    snprintf(key, sizeof(key), SOAP_NVS_KEY_UUID, i);
+    prefs.putString(key, m_server[i].uuid);
+    snprintf(key, sizeof(key), SOAP_NVS_KEY_EVENT_URL, i);
+    prefs.putString(key, m_server[i].eventSubURL);
+    snprintf(key, sizeof(key), SOAP_NVS_KEY_RENDERING_URL, i);
+    prefs.putString(key, m_server[i].renderingControlURL);
+  }
+  releaseServerList();
+
+  prefs.putUChar(SOAP_NVS_KEY_CLASS, (uint8_t)serviceClass);
+  prefs.putUChar(SOAP_NVS_KEY_COUNT, count);   // written last, marks a complete list
+  prefs.end();
+  log_i("%d servers saved to NVS", count);
+
+  return true;
+}
+
+//
+// restore server list saved with saveServerList(), parameter probe: drop servers that 
+// don't accept a connection. Returns number of servers in list
+//
+uint8_t SoapESP32::restoreServerList(const char *nvsNamespace, serviceClass_et serviceClass, bool probe)
+{
+  return soapRestoreServerList(nvsNamespace, serviceClass, probe, SERVER_CONNECT_TIMEOUT, NULL);
+}
+
+//
+// helper function: restore server list, timeout: of probe per server, dropped: receives number of 
+// servers that didn't accept a connection
+//
+uint8_t SoapESP32::soapRestoreServerList(const char *nvsNamespace, serviceClass_et serviceClass, bool probe, 
+                                         uint32_t timeout, uint8_t *dropped)
+{
+  Preferences prefs;
+  soapServerVect_t restored;
+  soapServer_t srv;
+  char key[16];
+
+  if (dropped) *dropped = 0;
+  if (!prefs.begin(nvsNamespace, true)) {
+    log_i("no server list saved in NVS");
+    return 0;
+  }
+  uint8_t count = prefs.getUChar(SOAP_NVS_KEY_COUNT, 0);
+  if (prefs.getUChar(SOAP_NVS_KEY_CLASS, 0xFF) != (uint8_t)serviceClass) count = 0;
+
+  for (int i = 0; i < count; i++) {
+    snprintf(key, sizeof(key), SOAP_NVS_KEY_IP, i);
+    srv.ip = IPAddress(prefs.getULong(key, 0));
+    snprintf(key, sizeof(key), SOAP_NVS_KEY_PORT, i);
+    srv.port = prefs.getUShort(key, 0);
+    snprintf(key, sizeof(key), SOAP_NVS_KEY_LOCATION, i);
+    srv.location = prefs.getString(key);
+    snprintf(key, sizeof(key), SOAP_NVS_KEY_NAME, i);
+    srv.friendlyName = prefs.getString(key);
+    snprintf(key, sizeof(key), SOAP_NVS_KEY_CONTROL_URL, i);
+    srv.controlURL = prefs.getString(key);
+    snprintf(key, sizeof(key), SOAP_NVS_KEY_UUID, i);
+    srv.uuid = prefs.getString(key);
+    snprintf(key, sizeof(key), SOAP_NVS_KEY_EVENT_URL, i);
+    srv.eventSubURL = prefs.getString(key);
+    snprintf(key, sizeof(key), SOAP_NVS_KEY_RENDERING_URL, i);
+    srv.renderingControlURL = prefs.getString(key);
+
+    if (!srv.ip || !srv.port || srv.controlURL.length() == 0) continue;
+    if (probe && !soapProbeServer(srv.ip, srv.port, timeout)) {
+      log_i("cached server \"%s\" (%s:%d) not reachable", srv.friendlyName.c_str(), srv.ip.toString().c_str(), srv.port);
+      if (dropped) (*dropped)++;
+      continue;
+    }
+    restored.push_back(srv);
+  }
+  prefs.end();
+
+  claimServerList();
+  m_server = restored;
+  count = m_server.size();
+  releaseServerList();
+  log_i("%d servers restored from NVS", count);
+
+  return count;
+}
+
+//
+// warm start: use server list saved in NVS if all its servers are still reachable (short probe each). 
+// Otherwise seek servers as well, found ones get merged into restored list and the result is saved
+//
+uint8_t SoapESP32::seekServerCached(serviceClass_et serviceClass, uint8_t workers, const char *nvsNamespace)
+{
+  uint8_t dropped;
+  uint8_t count = soapRestoreServerList(nvsNamespace, serviceClass, true, SOAP_NVS_PROBE_TIMEOUT, &dropped);
+
+  if (count == 0 || dropped > 0) {
+    seekServer(serviceClass, workers);
+    count = getServerCount();
+    if (count > 0) saveServerList(nvsNamespace, serviceClass);
+  }
+
+  return count;
+}
+
+//
+// helper function: check if server accepts a connection (single attempt), keep: connection 
+// stays open and gets used by next request to this server
+//
+bool SoapESP32::soapProbeServer(const IPAddress ip, const uint16_t port, uint32_t timeout, bool keep)
+{
+  readStop();
+  if (m_connReusable) soapClientStop();
+
+  int ret = soapClientConnect(ip, port, timeout);
+  if (ret && keep) {
+    m_connReusable = true;
+    m_connIp = ip;
+    m_connPort = port;
+  }
+  else {
+    soapClientStop();
+  }
+
+  return ret;
+}
+
+//
+// helper function: look up ip address of a host name (DNS)
+//
+bool SoapESP32::soapResolveHost(const char *host, IPAddress *ip)
+{
+#ifdef USE_ETHERNET
+  DNSClient dns;
+
+  claimSPI();
+  dns.begin(Ethernet.dnsServerIP());
+  int ret = dns.getHostByName(host, *ip);
+  releaseSPI();
+
+  return ret == 1;
+#else
+  return WiFi.hostByName(host, *ip) == 1;
+#endif
+}
+
+//
+// helper function: scan for certain attribute
+//
+bool SoapESP32::soapScanAttribute(const String *attributes, String *result, const char *what)
+{
+  int begin, end;
+
+  if ((begin = attributes->indexOf(what)) >= 0 &&
+      (end = attributes->indexOf("\"", begin + strlen(what) + 1)) >= begin + strlen(what) + 1) {
+    *result = attributes->substring(begin + strlen(what) + 1, end);
+    if (result->length() > 0) return true;
+  }
+
+  *result = "";   // empty for next call
+  log_d("attribute: \"%s\" missing.", what);
+
+  return false;
+}
+
+//
+// helper function: build browse filter string from requested object fields
+// (dc:title, upnp:class, @id & @parentID are always delivered by servers)
+//
+const struct { uint16_t field; const char *property; } browseFilter[] = { 
+  { SOAP_FIELD_RES | SOAP_FIELD_RESOURCES, "res" },
+  { SOAP_FIELD_SIZE,             "res@size" },
+  { SOAP_FIELD_BITRATE,          "res@bitrate" },
+  { SOAP_FIELD_SAMPLE_FREQUENCY, "res@sampleFrequency" },
+  { SOAP_FIELD_ALBUM,            "upnp:album" },
+  { SOAP_FIELD_ARTIST,           "upnp:artist" },
+  { SOAP_FIELD_ALBUM_ART_URI,    "upnp:albumArtURI" },
+  { SOAP_FIELD_ICON_URI,         "upnp:icon" },
+  { SOAP_FIELD_CHILD_COUNT,      "@childCount" },
+  { SOAP_FIELD_SEARCHABLE,       "@searchable" } };
+
+void SoapESP32::soapBuildFilter(const uint16_t fields, char *filter, size_t size)
+{
+  if ((fields & SOAP_FIELD_ALL) == SOAP_FIELD_ALL) {
+    snprintf(filter, size, "%s", SOAP_DEFAULT_BROWSE_FILTER);
+    return;
+  }
+  
+  // comma separated list of properties, e.g. "res,res@size,@childCount"
+  *filter = 0;
+  for (int i = 0; i < sizeof(browseFilter) / sizeof(browseFilter[0]); i++) {
+    if (fields & browseFilter[i].field) {
+      if (*filter) strncat(filter, ",", size - strlen(filter) - 1);
+      strncat(filter, browseFilter[i].property, size - strlen(filter) - 1);
+    }
+  }
+  log_d("browse filter: \"%s\"", filter);
+}
+
+//
+// helper function: parser paths needed for requested object fields
+//
+static uint32_t soapBrowsePathMask(const uint16_t fields)
+{
+  uint32_t mask = 0xFFFFFFFF;
+
+  if (!(fields & SOAP_FIELD_CLASS))         mask &= ~((uint32_t)1 << xpbItemClass);
+  if (!(fields & SOAP_FIELD_ALBUM))         mask &= ~((uint32_t)1 << xpbItemAlbum);
+  if (!(fields & SOAP_FIELD_ARTIST))        mask &= ~((uint32_t)1 << xpbItemArtist);
+  if (!(fields & SOAP_FIELD_ALBUM_ART_URI)) mask &= ~((uint32_t)1 << xpbItemAlbumArt);
+  if (!(fields & SOAP_FIELD_ICON_URI))      mask &= ~((uint32_t)1 << xpbItemIcon);
+  if (!(fields & (SOAP_FIELD_RES | SOAP_FIELD_RESOURCES))) mask &= ~((uint32_t)1 << xpbItemResource);
+
+  return mask;
+}
+
+//
+// scan <container> attributes in SOAP answer
+//
+bool SoapESP32::soapScanContainer(const String *parentId, 
+                                  const String *attributes, 
+                                  soapObject_t *info)
+{
+  String str((char *)0);
+
+  log_d("function entered, parent id: %s", parentId ? parentId->c_str() : "(search)");
+  *info = soapObject_t();
+
+  // scan container id
+  if (!soapScanAttribute(attributes, &str, DIDL_ATTR_ID)) return false;           // container id is a must
+  log_d("%s\"%s\"", DIDL_ATTR_ID, str.c_str());
+  info->id = str;
+
+  // scan parent id, search results come from different directories
+  if (!soapScanAttribute(attributes, &str, DIDL_ATTR_PARENT_ID)) return false;    // parent id is a must
+  if (parentId && !strcasestr(str.c_str(), parentId->c_str())) {
+#ifdef PARENT_ID_MUST_MATCH
+    log_e("scanned parent id \"%s\" != requested parent id \"%s\"", str.c_str(), parentId->c_str());
+    return false;
+#else
+    log_w("scanned parent id \"%s\" != requested parent id \"%s\"", str.c_str(), parentId->c_str());
+#endif  
+  }
+  info->parentId = parentId ? *parentId : str;  
+  info->isDirectory = true;
+
+  // scan child count...not always provided (e.g. Kodi)
+  if (!(m_browseFields & SOAP_FIELD_CHILD_COUNT) || !soapScanAttribute(attributes, &str, DIDL_ATTR_CHILD_COUNT)) { 
+    info->sizeMissing = true;
+  }
+  else {
+    log_d("%s\"%s\"", DIDL_ATTR_CHILD_COUNT, str.c_str());
+    if ((info->size = (int)str.toInt()) == 0) {
+      log_i("container \"%s\" child count=0", info->id.c_str());
+    }
+  }
+
+  // scan searchable flag...not always provided (e.g. UMS)
+  if (!(m_browseFields & SOAP_FIELD_SEARCHABLE)) {
+    info->searchable = true;
+  }
+  else if (!soapScanAttribute(attributes, &str, DIDL_ATTR_SEARCHABLE)) {
+    log_w("attribute \"%s\" is missing, we set it true", DIDL_ATTR_SEARCHABLE);
+    info->searchable = true;
+  }  
+  else {
+    log_d("%s\"%s\"", DIDL_ATTR_SEARCHABLE, str.c_str());
+    info->searchable = (1 == (int)str.toInt()) ? true : false;
+    if (!info->searchable) {
+      log_i("\"%s\" attribute searchable=0", info->id.c_str());
+    }
+  }
+
+  return true; 
+}
+
+//
+// scan <item> attributes in SOAP answer
+//
+bool SoapESP32::soapScanItem(const String *parentId, 
+                             const String *attributes, 
+                             soapObject_t *info)
+{
+  String str((char *)0);
+
+  log_d("function entered, parent id: %s", parentId ? parentId->c_str() : "(search)");
+  *info = soapObject_t();
+
+  // scan item id
+  if (!soapScanAttribute(attributes, &str, DIDL_ATTR_ID)) return false;         // id is a must
+  log_d("%s\"%s\"", DIDL_ATTR_ID, str.c_str());
+  info->id = str; 
+
+  // scan parent id, search results come from different directories
+  if (!soapScanAttribute(attributes, &str, DIDL_ATTR_PARENT_ID)) return false;  // parent id is a must
+  if (parentId && !strcasestr(str.c_str(), parentId->c_str())) {
+#ifdef PARENT_ID_MUST_MATCH
+    log_e("scanned parent id \"%s\" != requested parent id \"%s\"", str.c_str(), parentId->c_str());
+    return false;
+#else
+    log_w("scanned parent id \"%s\" != requested parent id \"%s\"", str.c_str(), parentId->c_str());
+#endif
+  }
+
+  info->parentId = parentId ? *parentId : str; 
+  info->isDirectory = false;
+  info->fileType = fileTypeOther;
+  info->sizeMissing = !(m_browseFields & SOAP_FIELD_SIZE);   // size not requested
+
+  return true;
+}
+
+//
+// scan <res> content (uri) & attributes in SOAP answer
+//
+bool SoapESP32::soapScanResource(const String *attributes, String *res, soapResource_t *resource)
+{
+  int port;
+  char address[20];
+  IPAddress ip;
+  String str((char *)0);
+
+  *resource = soapResource_t();
+  log_v("res=\"%s\"", res->c_str());
+  if (!(m_browseFields & SOAP_FIELD_URI)) {
+    // uri not requested
+  }
+  else if (res->startsWith("http://")) {
+    // scan for download ip & port
+    if (sscanf(res->c_str(), "http://%[0-9.]:%d/", address, &port) != 2) return false;
+    resource->downloadPort = (uint16_t)port;
+    if (!ip.fromString(address)) return false;
+    resource->downloadIp = ip;
+    // now remove "http://ip:port/" from begin of string
+    res->replace("http://", "");        
+    resource->uri = res->substring(res->indexOf("/") + 1); 
+  }
+  else {
+    resource->uri = *res;
+  }
+  if ((m_browseFields & SOAP_FIELD_URI) && resource->uri.length() == 0) { 
+    log_w("empty URI");
+    return false;   // valid URI is a must     
+  }
+  log_d("uri=\"%s\"", resource->uri.c_str());
+
+  // scan item size
+  if (!(m_browseFields & SOAP_FIELD_SIZE) || !soapScanAttribute(attributes, &str, DIDL_ATTR_SIZE)) {
+    // indicates missing attribute "size" (e.g. Kodi audio files, Fritzbox/Serviio stream items)
+    resource->sizeMissing = true;
+  } 
+  else {
+    resource->size = strtoull(str.c_str(), NULL, 10);
+    log_d("size=%llu", resource->size);
+  }
+#if !defined(SHOW_EMPTY_FILES)
+  if (resource->size == 0 && !resource->sizeMissing) {        
+    log_w("reported size=0, item ignored"); 
+    return false;
+  }
+#endif        
+
+  // scan bitrate (often provided when audio file)
+  if ((m_browseFields & SOAP_FIELD_BITRATE) && soapScanAttribute(attributes, &str, DIDL_ATTR_BITRATE)) {
+    resource->bitrate = (size_t)str.toInt();
+    if (resource->bitrate == 0) {
+      log_w("bitrate=0 !"); 
+    }              
+    else { 
+      log_d("bitrate=%d", resource->bitrate);
+    }  
+  }  
+
+  // scan sample frequency (often provided when audio file)
+  if ((m_browseFields & SOAP_FIELD_SAMPLE_FREQUENCY) && soapScanAttribute(attributes, &str, DIDL_ATTR_SAMPLEFREQU)) {
+    resource->sampleFrequency = (size_t)str.toInt();
+    if (resource->sampleFrequency == 0) {
+      log_w("sampleFrequency=0");   
+    }            
+    else { 
+      log_d("sampleFrequency=%d", resource->sampleFrequency);
+    }  
+  }  
+
+  // protocol info only needed when selecting among all <res> of item
+  if ((m_resourcePolicy || (m_browseFields & SOAP_FIELD_RESOURCES)) && 
+      soapScanAttribute(attributes, &str, DIDL_ATTR_PROTOCOL_INFO)) {
+    resource->protocolInfo = str;
+    log_d("protocolInfo=\"%s\"", str.c_str());
+  }
+
+  return true;
+}
+
+//
+// helper function: hand over scanned resource to object
+//
+static void soapUseResource(const soapResource_t *resource, soapObject_t *info)
+{
+  info->uri = resource->uri;
+  info->downloadIp = resource->downloadIp;
+  info->downloadPort = resource->downloadPort;
+  info->size = resource->size;
+  info->sizeMissing = resource->sizeMissing;
+  info->bitrate = resource->bitrate;
+  info->sampleFrequency = resource->sampleFrequency;
+}
+
+//
+// helper function: resource within limits of policy (unknown bitrate/size counts as within)
+//
+bool SoapESP32::soapResourceFits(const soapResource_t *resource)
+{
+  if (m_resourceMaxBitrate && resource->bitrate > m_resourceMaxBitrate) return false;
+  if (m_resourceMaxSize && !resource->sizeMissing && resource->size > m_resourceMaxSize) return false;
+
+  return true;
+}
+
+//
+// helper function: rank of resource's MIME type (third field of protocolInfo) in list of preferred 
+// types, entries like "audio/*" match all subtypes. Other types rank behind all listed ones. 
+// Resources of another kind than item (e.g. cover image of an audio item) get SOAP_RESOURCE_OTHER_KIND
+// added, so "audio/mpeg,image/jpeg" suits audio & image items. Returns -1 if resource must not be selected
+//
+#define SOAP_RESOURCE_OTHER_KIND 1000
+
+int SoapESP32::soapResourceRank(const soapResource_t *resource, eFileType fileType)
+{
+  static const char *kinds[] = { NULL, "audio/", "image/", "video/" };
+  const char *mime = resource->protocolInfo.c_str(), *end;
+  int rank = 0, kind = 0;
+
+  for (int i = 0; i < 2 && mime; i++) {
+    if ((mime = strchr(mime, ':'))) mime++;
+  }
+  if (!mime) mime = "";
+  if (!(end = strchr(mime, ':'))) end = mime + strlen(mime);
+  if (fileType != fileTypeOther && strncasecmp(mime, kinds[fileType], strlen(kinds[fileType])) != 0) {
+    kind = SOAP_RESOURCE_OTHER_KIND;
+  }
+
+  // preferred MIME types
+  for (const char *p = m_resourceMime.c_str(); *p; rank++) {
+    const char *q = strchr(p, ',');
+    size_t len = q ? q - p : strlen(p);
+
+    if ((len == end - mime && strncasecmp(p, mime, len) == 0) ||
+        (len > 2 && p[len - 1] == '*' && p[len - 2] == '/' && len - 1 <= end - mime && strncasecmp(p, mime, len - 1) == 0)) {
+      return rank + kind;
+    }
+    p += q ? len + 1 : len;
+  }
+  if (m_resourceMimeOnly && m_resourceMime.length()) return -1;
+
+  return rank + kind;
+}
+
+//
+// helper function: select best of all <res> of item for uri, size, bitrate... of object
+// order: kind of item (audio, image, video), within limits, preferred MIME type, first one. 
+// If no resource is within limits, the one with lowest bitrate (or size) is taken
+//
+void SoapESP32::soapSelectResource(soapObject_t *info)
+{
+  int best = -1, bestRank = 0, bestLevel = 0;
+
+  for (int i = 0; i < info->resources.size(); i++) {
+    const soapResource_t *res = &info->resources[i];
+    int rank = soapResourceRank(res, info->fileType);
+    bool fits = soapResourceFits(res);
+    int level = (rank >= SOAP_RESOURCE_OTHER_KIND ? 2 : 0) + (fits ? 0 : 1);
+
+    if (rank < 0) continue;
+    if (best >= 0) {
+      const soapResource_t *b = &info->resources[best];
+
+      if (level > bestLevel || (level == bestLevel && rank > bestRank)) continue;
+      if (level == bestLevel && rank == bestRank) {
+        // both within limits: first one. Otherwise the cheaper one
+        if (fits) continue;
+        if (res->bitrate && b->bitrate) {
+          if (res->bitrate >= b->bitrate) continue;
+        }
+        else if (res->sizeMissing || b->sizeMissing || res->size >= b->size) continue;
+      }
+    }
+    best = i;
+    bestRank = rank;
+    bestLevel = level;
+  }
+  if (best >= 0) {
+    soapUseResource(&info->resources[best], info);
+    log_d("resource %d of %d selected: \"%s\"", best + 1, info->resources.size(), info->resources[best].protocolInfo.c_str());
+  }
+  if (!(m_browseFields & SOAP_FIELD_RESOURCES)) soapResourceVect_t().swap(info->resources);   // list not requested
+}
+
+//
+// scan content of a single child element of <container> or <item>
+// returns false if object has become invalid
+//
+bool SoapESP32::soapScanObjectField(const int path, String *value, const String *attributes, soapObject_t *info)
+{
+  switch (path) {
+    case xpbContainerTitle:
+    case xpbItemTitle:
+      if (value->length() == 0) return false;    // valid title is a must 
+      info->name = *value;
+      log_d("title=\"%s\"", value->c_str());
+      break;
+    case xpbItemAlbum:
+      info->album = *value;                      // missing album not a showstopper
+      log_d("album=\"%s\"", value->c_str());
+      break;
+    case xpbItemArtist:
+      info->artist = *value;                     // missing artist not a showstopper
+      log_d("artist=\"%s\"", value->c_str());
+      break;
+    case xpbItemAlbumArt:
+      info->albumArtUri = *value;                // missing album art not a showstopper
+      log_d("albumArtUri=\"%s\"", value->c_str());
+      break;
+    case xpbItemIcon:
+      info->iconUri = *value;                    // missing icon not a showstopper
+      log_d("iconUri=\"%s\"", value->c_str());
+      break;
+    case xpbItemClass:
+      log_d("class=\"%s\"", value->c_str());
+      if (value->indexOf("audioItem") >= 0) 
+        info->fileType = fileTypeAudio;
+      else if (value->indexOf("imageItem") >= 0) 
+        info->fileType = fileTypeImage;
+      else if (value->indexOf("videoItem") >= 0) 
+        info->fileType = fileTypeVideo;
+      else 
+        info->fileType = fileTypeOther;
+      break;
+    case xpbItemResource:
+      {
+        soapResource_t resource;
+
+        if (m_resourcePolicy || (m_browseFields & SOAP_FIELD_RESOURCES)) {
+          // all <res> are collected, invalid ones get skipped. Selection follows when item is complete
+          if (soapScanResource(attributes, value, &resource)) info->resources.push_back(resource);
+          break;
+        }
+        // only first <res> counts
+        if (!soapScanResource(attributes, value, &resource)) return false;
+        soapUseResource(&resource, info);
+      }
+      break;
+  }
+
+  return true;
+}
+
+//
+// helper function, browse callback collecting all objects in a result list
+//
+static bool soapAddToList(const soapObject_t *object, void *userData)
+{
+  ((soapObjectVect_t *)userData)->push_back(*object);
+  return true;
+}
+
+//
+// helper function, browse callback collecting compact objects in a result list
+//
+static bool soapAddToCompactList(const soapObject_t *object, void *userData)
+{
+  soapObjectCompact_t compact = { .isDirectory = object->isDirectory, .size = object->size, .sizeMissing = object->sizeMissing,
+                                  .fileType = object->fileType, .id = object->id, .name = object->name, .uri = object->uri,
+                                  .downloadIp = object->downloadIp, .downloadPort = object->downloadPort };
+  ((soapObjectCompactVect_t *)userData)->push_back(compact);
+  return true;
+}
+
+//
+// helper function, browse callback collecting objects in an arena based result list
+//
+static bool soapAddToArena(const soapObject_t *object, void *userData)
+{
+  return ((SoapObjectArena *)userData)->add(object);
+}
+
+//
+// browse a SOAP container object (directory) on a media server for content 
+//
+bool SoapESP32::browseServer(const uint8_t srv,              // server number in list
+                             const char *objectId,           // directory to browse, "0" represents root according to spec
+                             soapObjectVect_t *browseResult, // where to store browse results (directory content)
+                             // optional parameter
+                             const uint32_t startingIndex,   // offset into directory content list
+                             const uint16_t maxCount,        // limits number of objects in result list
+                             const uint16_t fields)          // object fields to request & scan (SOAP_FIELD_...)
+{
+  // time to clean result list
+  browseResult->clear();
+
+  return browseServer(srv, objectId, soapAddToList, browseResult, startingIndex, maxCount, fields);
+}
+
+//
+// browse a SOAP container object (directory) on a media server for content, 
+// result list keeps only part of object info (soapObjectCompact_t)
+//
+bool SoapESP32::browseServer(const uint8_t srv,                     // server number in list
+                             const char *objectId,                  // directory to browse, "0" represents root according to spec
+                             soapObjectCompactVect_t *browseResult, // where to store browse results (directory content)
+                             // optional parameter
+                             const uint32_t startingIndex,          // offset into directory content list
+                             const uint16_t maxCount,               // limits number of objects in result list
+                             const uint16_t fields)                 // object fields to request & scan (SOAP_FIELD_...)
+{
+  // time to clean result list
+  browseResult->clear();
+
+  return browseServer(srv, objectId, soapAddToCompactList, browseResult, startingIndex, maxCount, fields);
+}
+
+//
+// browse a SOAP container object (directory) on a media server for content, result list 
+// keeps all strings in one arena (SoapObjectArena), memory for a full page is reserved up front
+//
+bool SoapESP32::browseServer(const uint8_t srv,                // server number in list
+                             const char *objectId,             // directory to browse, "0" represents root according to spec
+                             SoapObjectArena *browseResult,    // where to store browse results (directory content)
+                             // optional parameter
+                             const uint32_t startingIndex,     // offset into directory content list
+                             const uint16_t maxCount,          // limits number of objects in result list
+                             const uint16_t fields)            // object fields to request & scan (SOAP_FIELD_...)
+{
+  // time to clean result list, maxCount 0 (all) reserves a default sized page 
+  size_t count = (maxCount > 0 && maxCount < SOAP_DEFAULT_BROWSE_MAX_COUNT) ? maxCount : SOAP_DEFAULT_BROWSE_MAX_COUNT;
+  browseResult->clear();
+  browseResult->reserve(count, count * SOAP_ARENA_BYTES_PER_OBJECT);
+
+  // add() failing on memory shortage stops browsing, result is incomplete
+  bool ret = browseServer(srv, objectId, soapAddToArena, browseResult, startingIndex, maxCount, fields);
+  browseResult->shrink();
+
+  return ret && !browseResult->outOfMemory();
+}
+
+//
+// browse a SOAP container object (directory) on a media server for content, each
+// object found is handed over to callback function immediately instead of being stored
+//
+bool SoapESP32::browseServer(const uint8_t srv,              // server number in list
+                             const char *objectId,           // directory to browse, "0" represents root according to spec
+                             soapBrowseCallback_t callback,  // called for each object found, returns false to stop browsing
+                             void *userData,                 // handed over to callback function
+                             // optional parameter
+                             const uint32_t startingIndex,   // offset into directory content list
+                             const uint16_t maxCount,        // limits number of objects, 0 means all (UPnP spec)
+                             const uint16_t fields)          // object fields to request & scan (SOAP_FIELD_...)
+{
+  return soapBrowse(srv, objectId, NULL, NULL, callback, userData, startingIndex, maxCount, fields);
+}
+
+//
+// helper function: send browse request (criteria NULL) or search request and hand over
+// each object of the reply to callback function
+//
+bool SoapESP32::soapBrowse(const uint8_t srv, 
+                           const char *objectId,           // directory to browse or container to search in
+                           const char *criteria,           // search criteria, NULL when browsing
+                           const char *sortCriteria, 
+                           soapBrowseCallback_t callback, 
+                           void *userData, 
+                           const uint32_t startingIndex, 
+                           const uint16_t maxCount,
+                           const uint16_t fields)
+{
+  char filter[SOAP_BROWSE_FILTER_BUF_SIZE];
+  soapServer_t server;
+  bool search = (criteria != NULL);
+
+  if (!callback) return false;
+  if (!getServerInfo(srv, &server)) {
+    log_e("invalid server number: %d", srv);
+    return false;
+  }
+  if (search) {
+    log_i("new search on server: \"%s\", containerId: \"%s\", criteria: %s", server.friendlyName.c_str(), objectId, criteria);
+  }
+  else {
+    log_i("new search on server: \"%s\", objectId: \"%s\"", server.friendlyName.c_str(), objectId);
+  }
+
+  if (startingIndex != SOAP_DEFAULT_BROWSE_STARTING_INDEX) 
+    log_d("special browse parameter \"startingIndex\": %d", startingIndex);
+  if (maxCount != SOAP_DEFAULT_BROWSE_MAX_COUNT) 
+    log_d("special browse parameter \"maxCount\": %d", maxCount);
+
+  // evaluate SOAP answer
+  uint64_t contentSize;
+  bool chunked = false, start, objectValid = false;
+  int count = 0, countContainer = 0, countItem = 0, countDropped = 0;
+  uint32_t gotField = 0;       // only first occurrence of a field counts
+  bool complete = false;       // reply received up to </BrowseResponse> with all announced objects
+  soapObject_t info;
+  soapCacheEntry_t entry;      // collects objects for directory cache
+  bool collect = m_cacheBudget && !search;
+  MiniXPathMulti xPath;
+  String str((char *)0), strAttribute((char *)0);
+  uint32_t parseStart;
+  bool resources = m_resourcePolicy || (fields & SOAP_FIELD_RESOURCES);   // all <res> of an item count
+  uint32_t tried = 0;          // replicas that failed
+  int target;
+
+  // replicas: request goes to fastest healthy server of the group, the next one takes over if a 
+  // server can't be reached, doesn't answer or is busy. Single servers get one attempt.
+  soapBuildFilter(fields, filter, sizeof(filter));
+  m_browseNumberReturned = 0;
+  m_browseTotalMatches = 0;
+  m_browseStopped = false;
+  m_browseUpdateId = 0;
+  while (true) {
+    if ((target = soapSelectServer(srv, tried)) < 0) return false;
+    if (target != srv) {
+      if (!getServerInfo(target, &server)) return false;
+      log_i("request routed to replica %d: \"%s\"", target, server.friendlyName.c_str());
+    }
+    m_lastServer = target;
+
+    // serve request from directory cache if possible
+    if (!search && m_cacheBudget && soapCacheLookup(&server, objectId, startingIndex, maxCount, fields, callback, userData)) {
+      return true;
+    }
+
+    // send SOAP browse/search request, filter limits reply to the requested fields
+    if (soapBrowsePost(server.ip, server.port, server.controlURL.c_str(), objectId,
+                  startingIndex, maxCount, filter, criteria, sortCriteria)) {
+      log_i("connected successfully to server %s:%d", server.ip.toString().c_str(), server.port);
+
+      // reading HTTP header
+      if (soapReadHttpHeader(&contentSize, &chunked)) break;
+      log_e("HTTP Header not ok or reply status not 200");
+      soapClientStop();
+      if (m_httpStatus != 0 && m_httpStatus != HTTP_STATUS_SERVICE_UNAVAILABLE) {
+        // server is alive and refused request (e.g. invalid object id), replicas would do the same
+        soapServerHealth(&server, true, 0);
+        return false;
+      }
+    }
+    soapServerHealth(&server, false, 0);
+    if (target >= 32) return false;   // beyond replica bit mask
+    tried |= (uint32_t)1 << target;
+  }
+  soapServerHealth(&server, true, m_stats.connectTime + m_stats.firstByteTime + m_stats.headerTime);
+
+  if (!chunked && contentSize == 0) {  
+    log_e("announced XML size: 0 !"); 
+    return false;
+  } 
+  log_i("scan answer from media server:"); 
+  parseStart = millis();
+
+  // HTTP header ok, now scan XML/SOAP reply in a single pass
+  String objId = objectId;  
+  m_browseFields = fields;
+  if (search) {
+    xPath.setPaths(searchParserPaths, sizeof(searchParserPaths) / sizeof(xPathParser_t), soapBrowsePathMask(fields));
+  }
+  else {
+    xPath.setPaths(browseParserPaths, sizeof(browseParserPaths) / sizeof(xPathParser_t), soapBrowsePathMask(fields));
+  }
+  while (true) {
+    int ret = soapReadXML(chunked, true);  // de-chunk data stream and replace XML-entities (if found)
+    if (ret < 0) {
+      log_e("soapReadXML() returned: %d", ret); 
+      goto end_stop;
+    }  
+    // TEST
     //Serial.print((char)ret);
     //
-    // only one will return a result
-    if (xPathContainer.getValue((char)ret, &str, &strAttribute, true) ||
-        xPathContainerAlt1.getValue((char)ret, &str, &strAttribute, true) ||
-        xPathContainerAlt2.getValue((char)ret, &str, &strAttribute, true)) {
-      log_v("container attribute (length=%d): %s", strAttribute.length(), strAttribute.c_str());
-      log_v("container (length=%d): %s", str.length(), str.c_str());
-      if (soapScanContainer(&objId, &strAttribute, &str, browseResult))
+    int path = xPath.getValue((char)ret, &str, &strAttribute, &start);
+    if (path == XPATH_MULTI_NO_MATCH) continue;
+
+    if (path == xpbNumberReturned) {
+      count = str.toInt();
+      log_d("announced number of folders and/or files: %d", count);
+      continue;
+    }
+    if (path == xpbTotalMatches) {
+      m_browseTotalMatches = strtoul(str.c_str(), NULL, 10);
+      log_d("announced total number of folders and/or files in directory: %d", m_browseTotalMatches);
+      continue;
+    }
+    if (path == xpbUpdateId) {
+      m_browseUpdateId = strtoul(str.c_str(), NULL, 10);
+      continue;
+    }
+    if (path == xpbBrowseResponse) {
+      if (start) continue;
+      break;  // end of browse reply, so we can break here
+    }
+    if (path == xpbContainer || path == xpbItem) {
+      if (start) {
+        // start tag: scan attributes of new object
+        log_v("%s attribute (length=%d): %s", path == xpbItem ? "item" : "container", strAttribute.length(), strAttribute.c_str());
+        const String *parentId = search ? NULL : &objId;
+        objectValid = (path == xpbItem) ? soapScanItem(parentId, &strAttribute, &info) : soapScanContainer(parentId, &strAttribute, &info);
+        gotField = 0;
+        continue;
+      }
+      // end tag: object complete
+      if (!objectValid) {
+        m_stats.objectsDropped++;
+        countDropped++;
+        continue;
+      }
+      objectValid = false;
+      if (path == xpbItem && resources) soapSelectResource(&info);
+      if (path == xpbContainer) {
         countContainer++;
-        // TEST
-        delay(1); // resets task switcher watchdog, just in case it's needed
-    }
-    if (xPathItem.getValue((char)ret, &str, &strAttribute, true) ||
-        xPathItemAlt1.getValue((char)ret, &str, &strAttribute, true) ||
-        xPathItemAlt2.getValue((char)ret, &str, &strAttribute, true)) {
-      log_v("item attribute (length=%d): %s", strAttribute.length(), strAttribute.c_str());
-      log_v("item (length=%d): %s", str.length(), str.c_str());
-      if (soapScanItem(&objId, &strAttribute, &str, browseResult))
+        log_i("folder \"%s\" (id: \"%s\", childCount: %llu) found", info.name.c_str(), info.id.c_str(), info.size);
+        if (collect) collect = soapCacheCollect(&entry, &info);
+        if (!callback(&info, userData)) goto end_callback;
+      }
+      else if (info.name.length() == 0 || ((fields & SOAP_FIELD_URI) && info.uri.length() == 0)) {
+        log_i("title or ressource info missing, file not added to list");
+        m_stats.objectsDropped++;
+        countDropped++;
+      }
+      else {
         countItem++;
-        // TEST
-        delay(1); // resets task switcher watchdog, just in case it's needed
+        log_i("\"%s\" (id: \"%s\", size: %llu, sizeMissing: %s, type: %s) found", 
+              info.name.c_str(), info.id.c_str(), info.size, info.sizeMissing ? "true" : "false", getFileTypeName(info.fileType));
+        if (collect) collect = soapCacheCollect(&entry, &info);
+        if (!callback(&info, userData)) goto end_callback;
+      }
+      if ((countContainer + countItem) % SOAP_BROWSE_YIELD_OBJECTS == 0) {
+        // let other tasks run now and then (resets task watchdog), not counted as parse time
+        uint32_t yieldStart = millis();
+        delay(1);
+        parseStart += millis() - yieldStart;
+      }
+      continue;
+    }
+    // end tag of a container/item field
+    if (start || !objectValid || (gotField & ((uint32_t)1 << path))) continue;
+    if (path != xpbItemResource || !resources) gotField |= (uint32_t)1 << path;
+    objectValid = soapScanObjectField(path, &str, &strAttribute, &info);
+  }
+
+  m_browseNumberReturned = (count > countContainer + countItem) ? count : countContainer + countItem;
+  if (count == 0) {
+    log_i("XML scanned, no elements announced");
+  }
+  else if (count > countContainer + countItem + countDropped) {
+    // reply truncated by server
+    log_e("XML scanned, elements announced: %d > received: %d", count, countContainer + countItem + countDropped);
+    goto end_stop;
+  }
+  else if (count != (countContainer + countItem)) {
+    log_w("XML scanned, elements announced: %d != found: %d", count, countContainer + countItem);
+  }
+  soapFinishResponse(chunked, true);
+  complete = true;
+
+  // complete result goes into directory cache
+  if (collect) {
+    entry.ip = server.ip;
+    entry.port = server.port;
+    entry.objectId = objectId;
+    entry.startingIndex = startingIndex;
+    entry.maxCount = maxCount;
+    entry.fields = fields;
+    entry.updateId = m_browseUpdateId;
+    entry.numberReturned = m_browseNumberReturned;
+    entry.totalMatches = m_browseTotalMatches;
+    soapCacheInsert(&entry);
+  }
+  goto end;
+
+end_callback:
+  log_i("browsing stopped by callback function");
+  m_browseStopped = true;
+  complete = true;
+
+end_stop:
+  soapClientStop();
+end:
+  log_i("found %d folders and %d files", countContainer, countItem);
+  m_stats.parseTime = millis() - parseStart;
+  m_stats.objectsEmitted += countContainer + countItem;
+
+  return complete;   // read error or truncated reply: caller must not take result as complete
+}
+
+//
+// enable directory cache (browse results), budget limits memory usage in bytes 
+// (0: SOAP_CACHE_BUDGET or SOAP_CACHE_BUDGET_PSRAM if PSRAM is available)
+//
+void SoapESP32::enableBrowseCache(size_t budget)
+{
+  if (budget == 0) budget = psramFound() ? SOAP_CACHE_BUDGET_PSRAM : SOAP_CACHE_BUDGET;
+  m_cacheBudget = budget;
+  log_i("directory cache enabled, budget: %d bytes", budget);
+
+  // evict least recently used entries in case budget has been reduced
+  while (m_cacheBytes > m_cacheBudget && !m_cache.empty()) soapCacheErase(--m_cache.end());
+}
+
+//
+// disable directory cache and free its memory
+//
+void SoapESP32::disableBrowseCache()
+{
+  m_cacheBudget = 0;
+  invalidateBrowseCache();
+}
+
+//
+// drop cached browse results: all (srv < 0), of a server or of a server directory
+//
+void SoapESP32::invalidateBrowseCache(int srv, const char *objectId)
+{
+  soapServer_t server;
+
+  if (srv >= 0 && !getServerInfo(srv, &server)) return;
+  soapCacheApplyEvents();
+  for (soapCacheList_t::iterator it = m_cache.begin(); it != m_cache.end(); ) {
+    if (srv < 0 || (it->ip == server.ip && it->port == server.port && (!objectId || it->objectId == objectId))) {
+      soapCacheErase(it++);
+    }
+    else {
+      ++it;
+    }
+  }
+  if (srv < 0) m_cacheSystemUpdateIds.clear();
+}
+
+//
+// ask server for its SystemUpdateID (changes with every content modification) and drop 
+// cached browse results of this server if it changed since last check (or was never checked)
+// returns true if cached results are still valid
+//
+bool SoapESP32::checkBrowseCache(uint8_t srv)
+{
+  soapServer_t server;
+  uint32_t id;
+
+  if (!getServerInfo(srv, &server) || !soapGetSystemUpdateId(&server, &id)) return false;
+  soapCacheApplyEvents();
+
+  return soapCacheSystemUpdateId(server.ip, server.port, id);
+}
+
+//
+// ask server for its SystemUpdateID, changes with every content modification
+//
+bool SoapESP32::getSystemUpdateId(uint8_t srv, uint32_t *id)
+{
+  soapServer_t server;
+
+  return id && getServerInfo(srv, &server) && soapGetSystemUpdateId(&server, id);
+}
+
+//
+// helper function: store SystemUpdateID of a server, drop its cached browse results if the
+// id changed (or was not known yet). Returns true if cached results are still valid
+//
+bool SoapESP32::soapCacheSystemUpdateId(const IPAddress ip, const uint16_t port, const uint32_t id)
+{
+  int i;
+
+  for (i = 0; i < m_cacheSystemUpdateIds.size(); i++) {
+    if (m_cacheSystemUpdateIds[i].ip == ip && m_cacheSystemUpdateIds[i].port == port) break;
+  }
+  if (i < m_cacheSystemUpdateIds.size() && m_cacheSystemUpdateIds[i].id == id) return true;
+
+  log_i("SystemUpdateID of server %s:%d changed: %u, dropping cached results", ip.toString().c_str(), port, id);
+  for (soapCacheList_t::iterator it = m_cache.begin(); it != m_cache.end(); ) {
+    if (it->ip == ip && it->port == port) {
+      soapCacheErase(it++);
+    }
+    else {
+      ++it;
+    }
+  }
+  if (i < m_cacheSystemUpdateIds.size()) {
+    m_cacheSystemUpdateIds[i].id = id;
+  }
+  else {
+    m_cacheSystemUpdateIds.push_back({ .ip = ip, .port = port, .id = id });
+  }
+
+  return false;
+}
+
+//
+// helper function: apply cache invalidations reported by events (NOTIFY listener task)
+//
+void SoapESP32::soapCacheApplyEvents()
+{
+  std::vector<soapCacheEvent_t> events;
+  bool overflow;
+
+  claimServerList();
+  events.swap(m_cacheEvents);
+  overflow = m_cacheEventsOverflow;
+  m_cacheEventsOverflow = false;
+  releaseServerList();
+
+  if (overflow) {
+    log_i("too many events, dropping all cached results");
+    m_cache.clear();
+    m_cacheBytes = 0;
+    m_cacheSystemUpdateIds.clear();
+  }
+  for (int i = 0; i < events.size(); i++) {
+    soapCacheEvent_t *ev = &events[i];
+
+    if (ev->objectId.length() == 0) {
+      soapCacheSystemUpdateId(ev->ip, ev->port, ev->id);
+      continue;
+    }
+    // ContainerUpdateIDs: drop cached pages of that container with different UpdateID
+    for (soapCacheList_t::iterator it = m_cache.begin(); it != m_cache.end(); ) {
+      if (it->ip == ev->ip && it->port == ev->port && it->objectId == ev->objectId && it->updateId != ev->id) {
+        soapCacheErase(it++);
+      }
+      else {
+        ++it;
+      }
+    }
+  }
+}
+
+//
+// helper function: deliver cached browse result to callback function
+// returns false if request is not cached
+//
+bool SoapESP32::soapCacheLookup(const soapServer_t *server, const char *objectId, const uint32_t startingIndex, 
+                                const uint16_t maxCount, const uint16_t fields, soapBrowseCallback_t callback, void *userData)
+{
+  soapCacheList_t::iterator it;
+
+  soapCacheApplyEvents();
+  for (it = m_cache.begin(); it != m_cache.end(); ++it) {
+    if (it->ip == server->ip && it->port == server->port && it->startingIndex == startingIndex && 
+        it->maxCount == maxCount && it->fields == fields && it->objectId == objectId) break;
+  }
+  if (it == m_cache.end()) return false;
+
+  log_i("served from directory cache: %d objects", it->objects.size());
+  m_cache.splice(m_cache.begin(), m_cache, it);   // now most recently used entry
+  m_browseNumberReturned = it->numberReturned;
+  m_browseTotalMatches = it->totalMatches;
+  m_browseUpdateId = it->updateId;
+  m_browseStopped = false;
+  for (int i = 0; i < it->objects.size(); i++) {
+    if (!callback(&it->objects[i], userData)) {
+      m_browseStopped = true;
+      break;
+    }
+  }
+
+  return true;
+}
+
+//
+// helper function: add object to browse result collected for directory cache, keeping a running
+// estimate of memory usage. Once the result exceeds the budget the objects collected so far are
+// dropped and false is returned (stop collecting, result won't be cached)
+//
+bool SoapESP32::soapCacheCollect(soapCacheEntry_t *entry, const soapObject_t *o)
+{
+  if (entry->objects.empty()) entry->bytes = sizeof(soapCacheEntry_t);
+  entry->bytes += sizeof(soapObject_t) + o->parentId.length() + o->id.length() + o->name.length() + 
+                  o->artist.length() + o->album.length() + o->uri.length() + o->albumArtUri.length() + o->iconUri.length();
+  for (int j = 0; j < o->resources.size(); j++) {
+    entry->bytes += sizeof(soapResource_t) + o->resources[j].protocolInfo.length() + o->resources[j].uri.length();
+  }
+  if (entry->bytes > m_cacheBudget) {
+    log_d("browse result too big for directory cache, more than %d bytes", m_cacheBudget);
+    soapObjectVect_t().swap(entry->objects);   // release memory
+    return false;
+  }
+  entry->objects.push_back(*o);
+
+  return true;
+}
+
+//
+// helper function: add browse result to directory cache, least recently used entries are 
+// evicted when budget is exceeded
+//
+void SoapESP32::soapCacheInsert(soapCacheEntry_t *entry)
+{
+  // memory usage was estimated while collecting
+  entry->bytes += entry->objectId.length();
+  if (entry->bytes > m_cacheBudget) {
+    log_d("browse result too big for directory cache: %d bytes", entry->bytes);
+    return;
+  }
+
+  // directory content changed (UpdateID differs): drop its other cached pages
+  for (soapCacheList_t::iterator it = m_cache.begin(); it != m_cache.end(); ) {
+    if (it->ip == entry->ip && it->port == entry->port && it->objectId == entry->objectId && 
+        (it->updateId != entry->updateId || 
+         (it->startingIndex == entry->startingIndex && it->maxCount == entry->maxCount && it->fields == entry->fields))) {
+      soapCacheErase(it++);
+    }
+    else {
+      ++it;
+    }
+  }
+
+  m_cache.push_front(soapCacheEntry_t());
+  std::swap(m_cache.front(), *entry);
+  m_cacheBytes += m_cache.front().bytes;
+  while (m_cacheBytes > m_cacheBudget) soapCacheErase(--m_cache.end());
+  log_d("directory cache: %d entries, %d bytes", m_cache.size(), m_cacheBytes);
+}
+
+//
+// helper function: remove entry from directory cache
+//
+void SoapESP32::soapCacheErase(soapCacheList_t::iterator it)
+{
+  m_cacheBytes -= it->bytes;
+  m_cache.erase(it);
+}
+
+//
+// prepare paged browsing of a directory, no server communication yet
+//
+bool SoapESP32::browseBegin(soapBrowseCursor_t *cursor,      // keeps state of paged browsing
+                            const uint8_t srv,               // server number in list
+                            const char *objectId,            // directory to browse
+                            // optional parameter
+                            const uint16_t maxCount,         // page size
+                            const uint16_t fields)           // object fields to request & scan (SOAP_FIELD_...)
+{
+  if (!cursor || !objectId || srv >= getServerCount()) {
+    log_e("invalid parameter");
+    return false;
+  }
+  cursor->srv = srv;
+  cursor->objectId = objectId;
+  cursor->criteria = "";
+  cursor->sortCriteria = "";
+  cursor->maxCount = maxCount;
+  cursor->fields = fields;
+  cursor->startingIndex = 0;
+  cursor->totalMatches = 0;
+  cursor->complete = false;
+  cursor->walkContainers.clear();
+  cursor->walkNext = 0;
+  cursor->walkOffset = 0;
+  cursor->walkObjectId = "";
+
+  return true;
+}
+
+//
+// browse next page of a directory, returns false if no pages are left (or error). Requests for 
+// consecutive pages go over the same kept open connection (keep-alive) if the server allows it. 
+// The next page isn't requested ahead (pipelined): its starting index depends on NumberReturned, 
+// which servers send after all objects of the current page, when the connection is idle anyway
+//
+bool SoapESP32::browseNext(soapBrowseCursor_t *cursor, soapBrowseCallback_t callback, void *userData)
+{
+  if (!cursor || cursor->complete) return false;
+
+  bool ok = cursor->criteria.length() ? 
+            soapSearch(cursor->srv, cursor->objectId.c_str(), cursor->criteria.c_str(), callback, userData, 
+                       cursor->startingIndex, cursor->maxCount, cursor->sortCriteria.c_str(), cursor->fields, cursor) :
+            browseServer(cursor->srv, cursor->objectId.c_str(), callback, userData, 
+                         cursor->startingIndex, cursor->maxCount, cursor->fields);
+  if (!ok) {
+    cursor->complete = true;
+    return false;
+  }
+  cursor->startingIndex += m_browseNumberReturned;
+  if (m_browseTotalMatches > 0) cursor->totalMatches = m_browseTotalMatches;  // 0 means unknown (UPnP spec)
+
+  // last page reached ?
+  if (m_browseStopped || m_browseNumberReturned == 0 ||
+      (cursor->totalMatches > 0 && cursor->startingIndex >= cursor->totalMatches) ||
+      (cursor->totalMatches == 0 && cursor->maxCount > 0 && m_browseNumberReturned < cursor->maxCount)) {
+    cursor->complete = true;
+  }
+  log_d("page done, next starting index: %d, total matches: %d, complete: %s", 
+        cursor->startingIndex, cursor->totalMatches, cursor->complete ? "true" : "false");
+
+  return true;
+}
+
+bool SoapESP32::browseNext(soapBrowseCursor_t *cursor, soapObjectVect_t *page)
+{
+  if (!page) return false;
+  page->clear();
+
+  return browseNext(cursor, soapAddToList, page);
+}
+
+bool SoapESP32::browseNext(soapBrowseCursor_t *cursor, SoapObjectArena *page)
+{
+  if (!page) return false;
+  page->clear();
+  if (!cursor || cursor->complete) return false;
+
+  // reserve for next page, size of last page is known once server reported total matches
+  size_t count = (cursor->maxCount > 0 && cursor->maxCount < SOAP_DEFAULT_BROWSE_MAX_COUNT) ? 
+                 cursor->maxCount : SOAP_DEFAULT_BROWSE_MAX_COUNT;
+  if (cursor->totalMatches > cursor->startingIndex && cursor->totalMatches - cursor->startingIndex < count) {
+    count = cursor->totalMatches - cursor->startingIndex;
+  }
+  page->reserve(count, count * SOAP_ARENA_BYTES_PER_OBJECT);
+
+  // memory of page is kept for next one, given back after last page
+  bool ret = browseNext(cursor, soapAddToArena, page);
+  if (page->outOfMemory()) {
+    cursor->complete = true;
+    return false;
+  }
+  if (cursor->complete) page->shrink();
+
+  return ret;
+}
+
+//
+// helper functions: evaluate UPnP search criteria (ContentDirectory spec, e.g. 'upnp:class derivedfrom
+// "object.item.audioItem" and upnp:artist contains "queen"') on client side. "and" binds tighter than "or"
+//
+static const char *soapCriteriaSkip(const char *p)
+{
+  while (isspace((unsigned char)*p)) p++;
+
+  return p;
+}
+
+static bool soapCriteriaToken(const char **p, const char *token)
+{
+  const char *s = soapCriteriaSkip(*p);
+  size_t len = strlen(token);
+
+  if (strncasecmp(s, token, len) != 0) return false;
+  if (isalpha((unsigned char)token[0]) && isalnum((unsigned char)s[len])) return false;   // only whole words
+  *p = s + len;
+
+  return true;
+}
+
+static bool soapCriteriaQuoted(const char **p, String *value)
+{
+  const char *s = soapCriteriaSkip(*p);
+
+  if (*s++ != '"') return false;
+  *value = "";
+  for (; *s && *s != '"'; s++) {
+    if (*s == '\\' && (s[1] == '"' || s[1] == '\\')) s++;
+    *value += *s;
+  }
+  if (*s != '"') return false;
+  *p = s + 1;
+
+  return true;
+}
+
+static const char *soapObjectClass(const soapObject_t *object)
+{
+  if (object->isDirectory) return "object.container";
+  switch (object->fileType) {
+    case fileTypeAudio: return "object.item.audioItem";
+    case fileTypeImage: return "object.item.imageItem";
+    case fileTypeVideo: return "object.item.videoItem";
+    default:            return "object.item";
+  }
+}
+
+//
+// helper function: value of object property, false if object doesn't have it
+//
+static bool soapCriteriaProperty(const soapObject_t *object, const char *name, size_t len, String *value)
+{
+  struct { const char *name; const String *value; } strings[] = {
+    { "dc:title", &object->name }, { "upnp:artist", &object->artist }, { "dc:creator", &object->artist },
+    { "upnp:album", &object->album }, { "@id", &object->id }, { "@parentID", &object->parentId }, 
+    { "res", &object->uri }, { "upnp:albumArtURI", &object->albumArtUri }
+  };
+
+  for (size_t i = 0; i < sizeof(strings) / sizeof(strings[0]); i++) {
+    if (strlen(strings[i].name) == len && strncasecmp(name, strings[i].name, len) == 0) {
+      *value = *strings[i].value;
+      return value->length() > 0;
+    }
+  }
+  if (len == 10 && strncasecmp(name, "upnp:class", len) == 0) {
+    *value = soapObjectClass(object);
+    return true;
+  }
+  if ((len == 8 && strncasecmp(name, "res@size", len) == 0 && !object->isDirectory) ||
+      (len == 11 && strncasecmp(name, "@childCount", len) == 0 && object->isDirectory)) {
+    *value = String(object->size);
+    return !object->sizeMissing;
+  }
+
+  return false;   // property not known to this library
+}
+
+static bool soapCriteriaOr(const char **p, const soapObject_t *object, bool *error);
+
+static bool soapCriteriaRelation(const char **p, const soapObject_t *object, bool *error)
+{
+  static const char *ops[] = { "exists", "contains", "doesNotContain", "derivedfrom", "startsWith", 
+                               "!=", "<=", ">=", "=", "<", ">" };
+  enum { opExists = 0, opContains, opDoesNotContain, opDerivedFrom, opStartsWith, 
+         opNotEqual, opLessEqual, opGreaterEqual, opEqual, opLess, opGreater, opNone };
+  const char *name = soapCriteriaSkip(*p), *s = name;
+  String value((char *)0), operand((char *)0);
+  int op;
+
+  while (*s && !isspace((unsigned char)*s) && !strchr("=!<>()\"", *s)) s++;
+  *p = s;
+  for (op = 0; op < opNone && !soapCriteriaToken(p, ops[op]); op++);
+  if (s == name || op == opNone) {
+    *error = true;
+    return false;
+  }
+  bool known = soapCriteriaProperty(object, name, s - name, &value);
+  if (op == opExists) {
+    if (soapCriteriaToken(p, "true")) return known;
+    if (soapCriteriaToken(p, "false")) return !known;
+    *error = true;
+    return false;
+  }
+  if (!soapCriteriaQuoted(p, &operand)) {
+    *error = true;
+    return false;
+  }
+  if (!known) return op == opDoesNotContain || op == opNotEqual;
+
+  switch (op) {
+    case opContains:       return strcasestr(value.c_str(), operand.c_str()) != NULL;
+    case opDoesNotContain: return strcasestr(value.c_str(), operand.c_str()) == NULL;
+    case opStartsWith:     return strncasecmp(value.c_str(), operand.c_str(), operand.length()) == 0;
+    case opDerivedFrom:
+      // we only know base classes of items (e.g. audioItem), a sub class (musicTrack) matches them
+      if (strncasecmp(value.c_str(), operand.c_str(), operand.length()) == 0) return true;
+      return object->fileType != fileTypeOther && !object->isDirectory &&
+             strncasecmp(value.c_str(), operand.c_str(), value.length()) == 0;
+    default:
+      break;
+  }
+  char *end;
+  uint64_t number = strtoull(operand.c_str(), &end, 10);
+  int cmp = (*end || operand.length() == 0) ? strcasecmp(value.c_str(), operand.c_str()) :   // numbers: size, child count
+            (strtoull(value.c_str(), NULL, 10) < number) ? -1 : (strtoull(value.c_str(), NULL, 10) > number) ? 1 : 0;
+  switch (op) {
+    case opNotEqual:     return cmp != 0;
+    case opLessEqual:    return cmp <= 0;
+    case opGreaterEqual: return cmp >= 0;
+    case opEqual:        return cmp == 0;
+    case opLess:         return cmp < 0;
+    default:             return cmp > 0;
+  }
+}
+
+static bool soapCriteriaPrimary(const char **p, const soapObject_t *object, bool *error)
+{
+  if (!soapCriteriaToken(p, "(")) return soapCriteriaRelation(p, object, error);
+
+  bool ret = soapCriteriaOr(p, object, error);
+  if (!soapCriteriaToken(p, ")")) *error = true;
+
+  return ret;
+}
+
+static bool soapCriteriaAnd(const char **p, const soapObject_t *object, bool *error)
+{
+  bool ret = soapCriteriaPrimary(p, object, error);
+
+  while (!*error && soapCriteriaToken(p, "and")) {
+    ret = soapCriteriaPrimary(p, object, error) && ret;     // always parse right side
+  }
+
+  return ret;
+}
+
+static bool soapCriteriaOr(const char **p, const soapObject_t *object, bool *error)
+{
+  bool ret = soapCriteriaAnd(p, object, error);
+
+  while (!*error && soapCriteriaToken(p, "or")) {
+    ret = soapCriteriaAnd(p, object, error) || ret;
+  }
+
+  return ret;
+}
+
+static bool soapCriteriaMatch(const char *criteria, const soapObject_t *object, bool *error)
+{
+  const char *p = criteria;
+
+  *error = false;
+  if (soapCriteriaToken(&p, SOAP_SEARCH_ALL) && *soapCriteriaSkip(p) == 0) return true;
+  p = criteria;
+  bool ret = soapCriteriaOr(&p, object, error);
+  if (*soapCriteriaSkip(p)) *error = true;
+
+  return ret && !*error;
+}
+
+// client side search: browses directories and hands over matching objects
+struct soapSearchWalk_t
+{
+  const char *criteria;
+  soapBrowseCallback_t callback;
+  void *userData;
+  uint32_t skip;                  // matches in front of requested page
+  uint16_t maxCount;
+  uint32_t delivered;
+  uint32_t scanned;               // objects of current directory scanned
+  String resumeId;                // continued walk: skip objects up to this one (scanned by last page)
+  String lastId;                  // object not scanned because page was full
+  bool full;                      // another match behind a full page found
+  bool stopped;                   // callback returned false
+  std::vector<String> *containers;
+};
+
+static bool soapSearchWalkAdd(const soapObject_t *object, void *userData)
+{
+  soapSearchWalk_t *walk = (soapSearchWalk_t *)userData;
+  bool error;
+  if (walk->resumeId.length()) {
+    walk->scanned++;
+    if (object->id != walk->resumeId) return true;
+    walk->scanned--;
+    walk->resumeId = "";
+  }
+
+  bool match = soapCriteriaMatch(walk->criteria, object, &error);
+  if (match && walk->skip == 0 && walk->maxCount > 0 && walk->delivered >= walk->maxCount) {
+    walk->full = true;   // object not scanned, next page starts with it
+    walk->lastId = object->id;
+    return false;
+  }
+  walk->scanned++;
+  if (object->isDirectory && walk->containers->size() < SOAP_SEARCH_WALK_MAX_CONTAINERS) {
+    walk->containers->push_back(object->id);
+  }
+  if (!match) return true;
+  if (walk->skip > 0) {
+    walk->skip--;
+    return true;
+  }
+  walk->delivered++;
+  if (!walk->callback(object, walk->userData)) {
+    walk->stopped = true;
+    return false;
+  }
+
+  return true;
+}
+
+//
+// helper function: search by browsing all directories below containerId (breadth first),
+// for servers not supporting the Search action. Sort criteria are not supported. With a 
+// cursor (searchBegin()/browseNext()) each page continues the walk where the last one ended, 
+// otherwise the walk starts at containerId and skips startingIndex matches
+//
+bool SoapESP32::soapSearchWalk(const uint8_t srv, 
+                               const char *containerId, 
+                               const char *criteria, 
+                               soapBrowseCallback_t callback, 
+                               void *userData, 
+                               const uint32_t startingIndex, 
+                               const uint16_t maxCount, 
+                               const uint16_t fields,
+                               soapBrowseCursor_t *cursor)
+{
+  std::vector<String> containers;
+  soapBrowseCursor_t dir;
+  soapSearchWalk_t walk;
+  soapObject_t empty;
+  bool error;
+  size_t i = 0;
+  uint32_t offset = 0;
+
+  soapCriteriaMatch(criteria, &empty, &error);
+  if (error) {
+    log_e("invalid search criteria: %s", criteria);
+    return false;
+  }
+  walk.criteria = criteria;
+  walk.callback = callback;
+  walk.userData = userData;
+  walk.skip = startingIndex;
+  walk.maxCount = maxCount;
+  walk.delivered = 0;
+  walk.full = false;
+  walk.stopped = false;
+  walk.containers = &containers;
+  if (cursor && cursor->walkContainers.size()) {
+    // continue walk of last page
+    containers.swap(cursor->walkContainers);
+    i = cursor->walkNext;
+    offset = cursor->walkOffset;
+    walk.resumeId = cursor->walkObjectId;
+    walk.skip = 0;
+  }
+  else {
+    containers.push_back(containerId);
+  }
+
+  // criteria may ask for class, album, artist & size, whatever fields the caller selected
+  for (; i < containers.size(); i++, offset = 0) {
+    browseBegin(&dir, srv, containers[i].c_str(), SOAP_DEFAULT_BROWSE_MAX_COUNT, 
+                fields | SOAP_FIELD_CLASS | SOAP_FIELD_ALBUM | SOAP_FIELD_ARTIST | SOAP_FIELD_SIZE);
+    dir.startingIndex = offset;
+    walk.scanned = 0;
+    bool ok = browseNext(&dir, soapSearchWalkAdd, &walk);
+    if (!ok && i == 0 && offset == 0) return false;
+    while (ok && !dir.complete) ok = browseNext(&dir, soapSearchWalkAdd, &walk);
+    if (walk.full || walk.stopped) break;
+    walk.resumeId = "";   // object not found anymore, directory changed
+  }
+  if (containers.size() >= SOAP_SEARCH_WALK_MAX_CONTAINERS) {
+    log_w("search limited to %d directories", SOAP_SEARCH_WALK_MAX_CONTAINERS);
+  }
+  log_i("client side search: %d directories browsed, %d objects delivered", i, walk.delivered);
+
+  // page info like a search reply, total matches known if all directories were browsed
+  m_browseNumberReturned = walk.delivered;
+  m_browseTotalMatches = (walk.full || walk.stopped) ? 0 : startingIndex - walk.skip + walk.delivered;
+  m_browseStopped = walk.stopped;
+  if (cursor && walk.full) {
+    // remember position for next page
+    cursor->walkContainers.swap(containers);
+    cursor->walkNext = i;
+    cursor->walkOffset = offset + walk.scanned;
+    cursor->walkObjectId = walk.lastId;
+  }
+
+  return true;
+}
+
+//
+// helper function: remember search capability of a server in server list
+//
+void SoapESP32::soapSetSearchCaps(const soapServer_t *server, uint8_t searchCaps)
+{
+  claimServerList();
+  for (size_t i = 0; i < m_server.size(); i++) {
+    if (m_server[i].ip == server->ip && m_server[i].port == server->port) m_server[i].searchCaps = searchCaps;
+  }
+  releaseServerList();
+}
+
+//
+// ask media server which properties can be used in search criteria, returns an empty
+// string if the server doesn't support the Search action
+//
+bool SoapESP32::getSearchCapabilities(uint8_t srv, String *caps)
+{
+  uint64_t contentSize;
+  bool chunked = false, start;
+  soapServer_t server;
+  String str((char *)0);
+  MiniXPathMulti xPath;
+
+  if (!caps || !getServerInfo(srv, &server)) return false;
+  *caps = "";
+  if (!soapActionPost(server.ip, server.port, server.controlURL.c_str(), 
+                      HEADER_SOAP_ACTION_GET_SEARCH_CAPABILITIES, SOAP_GET_SEARCH_CAPABILITIES)) {
+    return false;
+  }
+  if (!soapReadHttpHeader(&contentSize, &chunked)) {
+    soapClientStop();
+    if (m_httpStatus == 0) return false;   // no valid reply, server might support searching
+    // error reply, action not implemented
+    soapSetSearchCaps(&server, SOAP_SEARCH_CAPS_NONE);
+    return true;
+  }
+
+  xPath.setPaths(searchCapsPath, sizeof(searchCapsPath) / sizeof(xPathParser_t));
+  while (true) {
+    int ret = soapReadXML(chunked, true);
+    if (ret < 0) {
+      log_e("soapReadXML() returned: %d", ret); 
+      soapClientStop();
+      return false;
+    }
+    int path = xPath.getValue((char)ret, &str, NULL, &start);
+    if (path == 0 && !start) {
+      *caps = str;
+      break;
+    }
+    if (path == 1 && !start) break;   // empty element <SearchCaps/>
+  }
+  soapFinishResponse(chunked, true);
+  log_i("search capabilities of server \"%s\": \"%s\"", server.friendlyName.c_str(), caps->c_str());
+  soapSetSearchCaps(&server, caps->length() ? SOAP_SEARCH_CAPS_SERVER : SOAP_SEARCH_CAPS_NONE);
+
+  return true;
+}
+
+//
+// search for objects below a container (e.g. "0": whole server) with UPnP search criteria, 
+// e.g. 'upnp:class derivedfrom "object.item.audioItem" and dc:creator = "Queen"'. Each object 
+// found is handed over to callback function. Servers not supporting the Search action get searched 
+// by browsing all directories below containerId instead
+//
+bool SoapESP32::searchServer(const uint8_t srv,              // server number in list
+                             const char *containerId,        // container to search in, "0" represents root
+                             const char *criteria,           // search criteria, SOAP_SEARCH_ALL (*) matches all objects
+                             soapBrowseCallback_t callback,  // called for each object found, returns false to stop
+                             void *userData,                 // handed over to callback function
+                             // optional parameter
+                             const uint32_t startingIndex,   // offset into result list
+                             const uint16_t maxCount,        // limits number of objects, 0 means all (UPnP spec)
+                             const char *sortCriteria,       // e.g. "+upnp:artist,+dc:title", ignored when browsing
+                             const uint16_t fields)          // object fields to request & scan (SOAP_FIELD_...)
+{
+  return soapSearch(srv, containerId, criteria, callback, userData, startingIndex, maxCount, sortCriteria, fields, NULL);
+}
+
+//
+// helper function: search, cursor (optional) keeps position of client side search for next page
+//
+bool SoapESP32::soapSearch(const uint8_t srv, 
+                           const char *containerId, 
+                           const char *criteria, 
+                           soapBrowseCallback_t callback, 
+                           void *userData, 
+                           const uint32_t startingIndex, 
+                           const uint16_t maxCount, 
+                           const char *sortCriteria, 
+                           const uint16_t fields,
+                           soapBrowseCursor_t *cursor)
+{
+  soapServer_t server;
+  String caps((char *)0);
+
+  if (!containerId || !criteria || !callback) {
+    log_e("invalid parameter");
+    return false;
+  }
+  if (!getServerInfo(srv, &server)) {
+    log_e("invalid server number: %d", srv);
+    return false;
+  }
+  if (server.searchCaps == SOAP_SEARCH_CAPS_UNKNOWN) {
+    if (!getSearchCapabilities(srv, &caps)) return false;
+    getServerInfo(srv, &server);
+  }
+  if (server.searchCaps == SOAP_SEARCH_CAPS_SERVER && 
+      soapBrowse(srv, containerId, criteria, sortCriteria, callback, userData, startingIndex, maxCount, fields)) {
+    return true;
+  }
+  // no reply means nothing was delivered yet (e.g. criteria refused by server)
+  log_i("server \"%s\" doesn't search, browsing instead", server.friendlyName.c_str());
+
+  return soapSearchWalk(srv, containerId, criteria, callback, userData, startingIndex, maxCount, fields, cursor);
+}
+
+bool SoapESP32::searchServer(const uint8_t srv,                 // server number in list
+                             const char *containerId,           // container to search in, "0" represents root
+                             const char *criteria,              // search criteria, SOAP_SEARCH_ALL (*) matches all objects
+                             soapObjectVect_t *searchResult,    // where to store objects found
+                             // optional parameter
+                             const uint32_t startingIndex,      // offset into result list
+                             const uint16_t maxCount,           // limits number of objects in result list
+                             const char *sortCriteria,          // e.g. "+upnp:artist,+dc:title", ignored when browsing
+                             const uint16_t fields)             // object fields to request & scan (SOAP_FIELD_...)
+{
+  if (!searchResult) return false;
+  searchResult->clear();
+
+  return searchServer(srv, containerId, criteria, soapAddToList, searchResult, startingIndex, maxCount, sortCriteria, fields);
+}
+
+//
+// start paged search, following pages are read with browseNext()
+//
+bool SoapESP32::searchBegin(soapBrowseCursor_t *cursor,      // keeps state of paged search
+                            const uint8_t srv,               // server number in list
+                            const char *containerId,         // container to search in
+                            const char *criteria,            // search criteria
+                            // optional parameter
+                            const uint16_t maxCount,         // page size
+                            const char *sortCriteria,        // e.g. "+dc:title"
+                            const uint16_t fields)           // object fields to request & scan (SOAP_FIELD_...)
+{
+  if (!criteria || !*criteria || !browseBegin(cursor, srv, containerId, maxCount, fields)) return false;
+  cursor->criteria = criteria;
+  cursor->sortCriteria = sortCriteria ? sortCriteria : "";
+
+  return true;
+}
+
+//
+// request object (file) from media server
+//
+bool SoapESP32::readStart(soapObject_t *object, size_t *size)
+{
+  uint64_t contentSize;
+
+  if (!readStart(object, &contentSize, 0, 0)) return false;
+
+  // size can't be returned if file is bigger than 4.2GB (SIZE_MAX), 0: size not known
+  if (contentSize > (uint64_t)SIZE_MAX) {
+    log_e("file too big, please use readStart() with 64 bit size parameter.");
+    readStop();
+    return false;
+  }
+  if (size) {                            // pointer valid ?
+    *size = (size_t)contentSize;         // return size of file
+  }
+
+  return true; 
+}
+
+//
+// request part of object (file) from media server: length bytes (0: up to end of file) starting at 
+// offset. Uses HTTP range request, if the server ignores it data in front of offset is skipped.
+// Returned size is 0 if the server doesn't announce it (chunked transfer or no Content-Length), 
+// file data then ends when read() returns 0
+//
+bool SoapESP32::readStart(soapObject_t *object, uint64_t *size, uint64_t offset, uint64_t length)
+{
+  uint64_t contentSize;
+
+  if (object->isDirectory) return false;
+  m_clientDataAvailable = 0;
+
+  log_i("server ip: %s, port: %d, uri: \"%s\", offset: %llu, length: %llu", 
+        object->downloadIp.toString().c_str(), object->downloadPort, object->uri.c_str(), offset, length);
+
+  // just to make sure old connection is closed
+  if (m_clientDataConOpen) {
+    soapClientStop();
+    m_clientDataConOpen = false;
+    log_w("client data connection to media server was still open. Closed now.");
+  }
+
+  // establish connection to server and send GET request
+  if (!soapGet(object->downloadIp, object->downloadPort, object->uri.c_str(), offset, length)) {
+    return false;
+  }
+
+  // connection established, read HTTP header
+  if (!soapReadHttpHeader(&contentSize, &m_clientDataChunked) && !m_httpNoLength) {
+    // error returned
+    log_e("soapReadHttpHeader() was unsuccessful.");
+    soapClientStop();
+    return false;
+  }
+  // streams & transcoded files: data ends with final chunk or when server closes connection
+  m_clientDataUnbounded = m_clientDataChunked || m_httpNoLength;
+  if (m_httpNoLength) m_connKeepAlive = false;
+
+  if (m_httpStatus == HTTP_STATUS_PARTIAL_CONTENT) {
+    if (m_contentRangeStart != offset) {
+      log_e("server delivers range starting at %llu instead of %llu", m_contentRangeStart, offset);
+      soapClientStop();
+      return false;
+    }
+  }
+  else if (offset > 0) {
+    // server ignored range request and sends whole file
+    log_w("server does not support range requests, skipping %llu bytes", offset);
+    if ((!m_clientDataUnbounded && offset >= contentSize) || !soapSkipData(offset)) {
+      log_e("could not skip data up to offset %llu", offset);
+      soapClientStop();
+      return false;
+    }
+    if (!m_clientDataUnbounded) contentSize -= offset;
+  }
+  if (length > 0 && (m_clientDataUnbounded || length < contentSize)) {
+    contentSize = length;
+    m_clientDataUnbounded = false;
+    m_connKeepAlive = false;   // rest of reply won't be read, connection can't be reused
+  }
+
+  m_clientDataAvailable = m_clientDataUnbounded ? UINT64_MAX : contentSize;
+  if (m_clientDataAvailable == 0) {  
+    // no data available
+    log_e("announced file size: 0 !"); 
+    soapClientStop();
+    return false;
+  } 
+
+  m_clientDataConOpen = true;
+  m_clientDataPosition = offset;
+  if (size) {                            // pointer valid ?
+    *size = m_clientDataUnbounded ? 0 : m_clientDataAvailable;   // return size of file (or requested part)
+  }
+
+  return true; 
+}
+
+//
+// request file by its absolute URL "http://ip:port/uri", e.g. albumArtUri or iconUri of an object
+//
+bool SoapESP32::readStart(const char *url, uint64_t *size, uint64_t offset, uint64_t length)
+{
+  char host[SOAP_URL_HOST_BUF_SIZE];
+  unsigned int port = 80;
+  const char *uri;
+  soapObject_t object;
+
+  // "http://host[:port][/path]", host: ip address or name
+  size_t len = url && strncasecmp(url, "http://", 7) == 0 ? strcspn(url + 7, ":/") : 0;
+  if (len == 0 || len >= sizeof(host) ||
+      (url[7 + len] == ':' && (sscanf(url + 8 + len, "%u", &port) != 1 || port == 0 || port > 65535))) {
+    log_e("URL not supported: \"%s\"", url ? url : "");
+    return false;
+  }
+  memcpy(host, url + 7, len);
+  host[len] = 0;
+  if (!object.downloadIp.fromString(host) && !soapResolveHost(host, &object.downloadIp)) {
+    log_e("could not resolve host name: %s", host);
+    return false;
+  }
+  uri = strchr(url + 7, '/');
+  object.isDirectory = false;
+  object.downloadPort = (uint16_t)port;
+  object.uri = uri ? uri + 1 : "";
+
+  return readStart(&object, size, offset, length);
+}
+
+//
+// read up to size bytes from server and place them into buf
+// returnes number of bytes read or -1 in case nothing was read (default read timeout is 3s)
+// Remarks: 
+// - older WiFi library versions & the Ethernet library return -1 if connection is still up but 
+//   momentarily no data available and return 0 in case of EOF. Newer WiFi versions return 0 in 
+//   both cases, so we need to treat -1 & 0 equally.
+// - timeout checking is vital because client.read() can return 0 for ages in case of WiFi problems
+//
+int SoapESP32::read(uint8_t *buf, size_t size, uint32_t timeout) {
+
+  // first some basic checks
+  if (!buf || !size || !m_clientDataConOpen || m_readTask) return -1;  // clearly an error
+  if (!m_clientDataAvailable) return 0;   // most probably EOF
+
+  int res;  
+  uint32_t start = millis();
+
+  while (1) {
+    if ((res = soapReadData(buf, size)) > 0) break;  // got at least 1 byte from server
+    if (res < 0) break;                               // invalid chunk
+    if (!m_clientDataAvailable) break;                // EOF of file with unknown size
+    if ((millis() - start) > timeout) {
+      // read timeout
+      log_e("error, read timeout: %d ms", timeout);
+      res = -1;
+      break;
+    }
+    delay(1);   // nothing received yet, don't hog the CPU 
+  }
+
+  return res;
+}
+
+//
+// helper function: read & discard count bytes of file data (server ignored range request)
+//
+bool SoapESP32::soapSkipData(uint64_t count)
+{
+  while (count > 0) {
+    if (m_clientDataChunked && soapChunkBegin() < 0) {
+      return false;  // invalid chunk or final chunk: file ends in front of offset
+    }
+    if (m_rxBufferOffset >= m_rxBufferCount && !soapClientFillBuffer()) {
+      return false;  // read timeout
+    }
+    size_t len = m_rxBufferCount - m_rxBufferOffset;
+    if (len > count) len = (size_t)count;
+    if (m_clientDataChunked && len > (size_t)m_xmlChunkCount) len = m_xmlChunkCount;
+    m_rxBufferOffset += len;
+    count -= len;
+    if (m_clientDataChunked && soapChunkConsumed(len) < 0) return false;
+  }
+
+  return true;
+}
+
+//
+// helper function: count bytes of file data have been delivered
+//
+void SoapESP32::soapDataConsumed(size_t count)
+{
+  if (!m_clientDataUnbounded) m_clientDataAvailable -= count;
+  m_clientDataPosition += count;
+}
+
+//
+// helper function: end of file data with unknown size (final chunk or connection closed by server)
+//
+void SoapESP32::soapDataEnd()
+{
+  // skip optional trailer following final chunk
+  if (m_clientDataChunked && !soapDrainResponse(true)) m_connKeepAlive = false;
+  m_clientDataAvailable = 0;
+  log_d("end of file data, %llu bytes read", m_clientDataPosition);
+}
+
+//
+// helper function: read available file data without waiting (de-chunked if needed)
+// returns nr of bytes read or -1 in case of an invalid chunk
+//
+int SoapESP32::soapReadData(uint8_t *buf, size_t size)
+{
+  int res;
+  bool closed = false;
+
+  if (!m_clientDataUnbounded && m_clientDataAvailable < size) {
+    size = (size_t)m_clientDataAvailable;  // don't read into next reply (keep-alive)
+  }
+  if (m_clientDataChunked) {
+    // line with size of next chunk is read once data has arrived
+    if (m_xmlChunkCount <= 0 && soapClientAvailable() == 0) return 0;
+    if ((res = soapChunkBegin()) < 0) {
+      if (res == -4) {
+        soapDataEnd();     // final chunk
+        return 0;
+      }
+      log_e("invalid chunk, error: %d", res);
+      return -1;
+    }
+    if (size > (size_t)m_xmlChunkCount) size = m_xmlChunkCount;
+  }
+  if (m_rxBufferOffset < m_rxBufferCount) {
+    // deliver data first that was buffered while reading the HTTP header
+    res = min(size, m_rxBufferCount - m_rxBufferOffset);
+    memcpy(buf, m_rxBuffer + m_rxBufferOffset, res);
+    m_rxBufferOffset += res;
+  }
+  else {
+    claimSPI();
+    res = m_client->read(buf, size);
+    if (res <= 0 && m_httpNoLength) closed = !m_client->connected();
+    releaseSPI();
+    if (res <= 0) {
+      if (closed) soapDataEnd();   // no size announced: server closed connection
+      return 0;
+    }
+    m_stats.bytesReceived += res;
+  }
+  soapDataConsumed(res);
+  if (m_clientDataChunked && soapChunkConsumed(res) < 0) {
+    log_e("invalid chunk, missing CRLF");
+    return -1;
+  }
+
+  return res;
+}
+
+//
+// start reader task after readStart(): file data is written straight into ring buffer.
+// Reading pauses when fill level reaches highWatermark (0: ring buffer size) and resumes
+// when it dropped to lowWatermark (0: half of highWatermark)
+//
+bool SoapESP32::readTaskStart(SoapRingBuffer *ring, size_t highWatermark, size_t lowWatermark)
+{
+  if (!ring || ring->size() == 0) return false;
+
+  m_readRing = ring;
+  m_readSink = NULL;
+  m_readHigh = (highWatermark == 0 || highWatermark > ring->size()) ? ring->size() : highWatermark;
+  m_readLow  = (lowWatermark == 0 || lowWatermark >= m_readHigh) ? m_readHigh / 2 : lowWatermark;
+
+  return soapReadTaskCreate();
+}
+
+//
+// start reader task after readStart(): file data is handed over to sink (e.g. a File or 
+// Stream object), sink->write() not accepting data pauses reading
+//
+bool SoapESP32::readTaskStart(Print *sink)
+{
+  if (!sink) return false;
+
+  m_readRing = NULL;
+  m_readSink = sink;
+
+  return soapReadTaskCreate();
+}
+
+//
+// returns state of reader task, all data has been delivered with readTaskDone
+//
+readTaskState_et SoapESP32::readTaskState()
+{
+  return m_readTaskState;
+}
+
+//
+// stop reader task (waits until task has finished)
+//
+void SoapESP32::readTaskStop()
+{
+  if (!m_readTask) return;
+
+  m_readTaskRun = false;
+  xSemaphoreTake(m_readTaskDone, portMAX_DELAY);
+  m_readTask = NULL;
+}
+
+//
+// helper function: create reader task
+//
+bool SoapESP32::soapReadTaskCreate()
+{
+  if (!m_clientDataConOpen || m_readTask) return false;
+  if (!m_readTaskDone && !(m_readTaskDone = xSemaphoreCreateBinary())) return false;
+
+  m_readTaskRun = true;
+  m_readTaskState = readTaskRunning;
+  if (xTaskCreate(soapReadTask, "soapRead", SOAP_READ_TASK_STACK, this, 
+                  SOAP_READ_TASK_PRIO, &m_readTask) != pdPASS) {
+    log_e("could not start reader task");
+    m_readTask = NULL;
+    m_readTaskState = readTaskError;
+    return false;
+  }
+
+  return true;
+}
+
+//
+// reader task
+//
+void SoapESP32::soapReadTask(void *param)
+{
+  SoapESP32 *soap = (SoapESP32 *)param;
+
+  bool ok = soap->m_readRing ? soap->soapReadToRing() : soap->soapReadToSink();
+  log_d("reader task finished, %s", ok ? "ok" : "error");
+  soap->m_readTaskState = ok ? readTaskDone : readTaskError;
+
+  xSemaphoreGive(soap->m_readTaskDone);
+  vTaskDelete(NULL);
+}
+
+//
+// async requests: parameters are copied (browse results, cursor & size must stay valid until 
+// request has finished). Other functions of this object must not be called meanwhile
+//
+bool SoapESP32::seekServerAsync(serviceClass_et serviceClass, uint8_t workers, soapAsyncCallback_t done, void *userData)
+{
+  if (m_asyncState == asyncRunning) return false;
+
+  m_asyncClass = serviceClass;
+  m_asyncSrv = workers;
+
+  return soapAsyncTaskCreate(asyncSeek, done, userData);
+}
+
+bool SoapESP32::browseServerAsync(const uint8_t srv, const char *objectId, soapObjectVect_t *browseResult,
+                                  soapAsyncCallback_t done, void *userData,
+                                  const uint32_t startingIndex, const uint16_t maxCount, const uint16_t fields)
+{
+  if (m_asyncState == asyncRunning || !objectId || !browseResult) return false;
+
+  m_asyncSrv = srv;
+  m_asyncObjectId = objectId;
+  m_asyncResult = browseResult;
+  m_asyncOffset = startingIndex;
+  m_asyncLength = maxCount;
+  m_asyncFields = fields;
+
+  return soapAsyncTaskCreate(asyncBrowse, done, userData);
+}
+
+bool SoapESP32::browseNextAsync(soapBrowseCursor_t *cursor, soapObjectVect_t *page, soapAsyncCallback_t done, void *userData)
+{
+  if (m_asyncState == asyncRunning || !cursor || !page) return false;
+
+  m_asyncCursor = cursor;
+  m_asyncResult = page;
+
+  return soapAsyncTaskCreate(asyncBrowseNext, done, userData);
+}
+
+bool SoapESP32::readStartAsync(soapObject_t *object, uint64_t *size, soapAsyncCallback_t done, void *userData, 
+                               uint64_t offset, uint64_t length)
+{
+  if (m_asyncState == asyncRunning || !object || !size) return false;
+
+  m_asyncObject = *object;
+  m_asyncSize = size;
+  m_asyncOffset = offset;
+  m_asyncLength = length;
+
+  return soapAsyncTaskCreate(asyncReadStart, done, userData);
+}
+
+bool SoapESP32::wakeUpServerAsync(const char *macWOL, uint8_t srv, uint32_t timeout, soapAsyncCallback_t done, void *userData)
+{
+  if (m_asyncState == asyncRunning || !macWOL) return false;
+
+  m_asyncObjectId = macWOL;
+  m_asyncSrv = srv;
+  m_asyncLength = timeout;
+
+  return soapAsyncTaskCreate(asyncWakeUp, done, userData);
+}
+
+//
+// returns state of last async request, asyncDone: request was successful
+//
+asyncState_et SoapESP32::asyncState()
+{
+  return m_asyncState;
+}
+
+//
+// wait until async request has finished, returns result of request
+//
+bool SoapESP32::asyncWait()
+{
+  if (m_asyncTask) {
+    xSemaphoreTake(m_asyncTaskDone, portMAX_DELAY);
+    m_asyncTask = NULL;
+  }
+
+  return m_asyncState == asyncDone;
+}
+
+//
+// helper function: create request task
+//
+bool SoapESP32::soapAsyncTaskCreate(asyncRequest_et request, soapAsyncCallback_t done, void *userData)
+{
+  asyncWait();   // task of last request has finished, clean up
+  if (!m_asyncTaskDone && !(m_asyncTaskDone = xSemaphoreCreateBinary())) return false;
+
+  m_asyncRequest = request;
+  m_asyncDone = done;
+  m_asyncUserData = userData;
+  m_asyncState = asyncRunning;
+  if (xTaskCreate(soapAsyncTask, "soapAsync", SOAP_ASYNC_TASK_STACK, this, 
+                  SOAP_ASYNC_TASK_PRIO, &m_asyncTask) != pdPASS) {
+    log_e("could not start request task");
+    m_asyncTask = NULL;
+    m_asyncState = asyncError;
+    return false;
+  }
+
+  return true;
+}
+
+//
+// request task
+//
+void SoapESP32::soapAsyncTask(void *param)
+{
+  SoapESP32 *soap = (SoapESP32 *)param;
+  bool ok = false;
+
+  switch (soap->m_asyncRequest) {
+    case asyncSeek:
+      ok = soap->seekServer(soap->m_asyncClass, soap->m_asyncSrv) > 0;
+      break;
+    case asyncBrowse:
+      ok = soap->browseServer(soap->m_asyncSrv, soap->m_asyncObjectId.c_str(), soap->m_asyncResult, 
+                              (uint32_t)soap->m_asyncOffset, (uint16_t)soap->m_asyncLength, soap->m_asyncFields);
+      break;
+    case asyncBrowseNext:
+      ok = soap->browseNext(soap->m_asyncCursor, soap->m_asyncResult);
+      break;
+    case asyncReadStart:
+      ok = soap->readStart(&soap->m_asyncObject, soap->m_asyncSize, soap->m_asyncOffset, soap->m_asyncLength);
+      break;
+    case asyncWakeUp:
+      ok = soap->wakeUpServer(soap->m_asyncObjectId.c_str(), soap->m_asyncSrv, (uint32_t)soap->m_asyncLength);
+      break;
+  }
+  log_d("request task finished, %s", ok ? "ok" : "error");
+  // request is finished before callback runs, so callback can use asyncState() & asyncWait() or start 
+  // next async request. Object isn't touched after semaphore was given (might get destroyed meanwhile)
+  soapAsyncCallback_t done = soap->m_asyncDone;
+  void *userData = soap->m_asyncUserData;
+  soap->m_asyncState = ok ? asyncDone : asyncError;
+  xSemaphoreGive(soap->m_asyncTaskDone);
+  if (done) done(ok, userData);
+
+  vTaskDelete(NULL);
+}
+
+//
+// helper function: read file data directly into free space of ring buffer (no copy)
+//
+bool SoapESP32::soapReadToRing()
+{
+  bool paused = false;
+  uint32_t start = millis();
+  uint8_t *p;
+  size_t len, fill;
+
+  while (m_clientDataAvailable) {
+    if (!m_readTaskRun) return false;   // stopped
+
+    // backpressure: watermarks
+    fill = m_readRing->available();
+    if (paused && fill <= m_readLow) paused = false;
+    else if (!paused && fill >= m_readHigh) paused = true;
+    if (paused || (p = m_readRing->writePtr(&len)) == NULL) {
+      delay(SOAP_READ_TASK_IDLE_DELAY);
+      start = millis();
+      continue;
+    }
+
+    int res = soapReadData(p, min(len, m_readHigh - fill));
+    if (res < 0) return false;
+    if (res > 0) {
+      m_readRing->commit(res);
+      start = millis();
+    }
+    else if ((millis() - start) > SERVER_READ_TIMEOUT) {
+      log_e("error, read timeout: %d ms", SERVER_READ_TIMEOUT);
+      return false;
+    }
+    else {
+      delay(1);  // waiting for next TCP segment
+    }
+  }
+
+  return true;
+}
+
+//
+// helper function: read file data into receive buffer and hand it over to sink
+//
+bool SoapESP32::soapReadToSink()
+{
+  uint32_t start = millis();
+  size_t len;
+
+  while (m_clientDataAvailable) {
+    if (!m_readTaskRun) return false;   // stopped
+
+    if (m_clientDataChunked && m_xmlChunkCount <= 0) {
+      // line with size of next chunk
+      int ret = soapChunkBegin();
+      if (ret == -4) {
+        soapDataEnd();     // final chunk
+        break;
+      }
+      if (ret < 0) {
+        log_e("invalid chunk, error: %d", ret);
+        return false;
+      }
+    }
+    if (m_rxBufferOffset >= m_rxBufferCount) {
+      // receive buffer empty, refill it
+      bool closed = false;
+      len = sizeof(m_rxBuffer);
+      if (!m_clientDataUnbounded && m_clientDataAvailable < len) len = (size_t)m_clientDataAvailable;
+      claimSPI();
+      int res = m_client->read(m_rxBuffer, len);
+      if (res <= 0 && m_httpNoLength) closed = !m_client->connected();
+      releaseSPI();
+      if (closed) {
+        soapDataEnd();     // no size announced: server closed connection
+        break;
+      }
+      if (res <= 0) {
+        if ((millis() - start) > SERVER_READ_TIMEOUT) {
+          log_e("error, read timeout: %d ms", SERVER_READ_TIMEOUT);
+          return false;
+        }
+        delay(1);  // waiting for next TCP segment
+        continue;
+      }
+      m_rxBufferCount = (size_t)res;
+      m_rxBufferOffset = 0;
+      m_stats.bytesReceived += res;
+    }
+
+    // data counts as delivered when sink has taken it
+    len = m_rxBufferCount - m_rxBufferOffset;
+    if (!m_clientDataUnbounded && m_clientDataAvailable < len) len = (size_t)m_clientDataAvailable;
+    if (m_clientDataChunked && (size_t)m_xmlChunkCount < len) len = m_xmlChunkCount;
+    len = m_readSink->write(m_rxBuffer + m_rxBufferOffset, len);
+    m_rxBufferOffset += len;
+    soapDataConsumed(len);
+    if (m_clientDataChunked && len > 0 && soapChunkConsumed(len) < 0) {
+      log_e("invalid chunk, missing CRLF");
+      return false;
+    }
+    if (len == 0) delay(SOAP_READ_TASK_IDLE_DELAY);  // sink busy
+    start = millis();
+  }
+
+  return true;
+}
+
+int SoapESP32::read(void)
+{
+  uint8_t b;
+  if (read(&b, 1) > 0) return b;
+  return -1;
+}
+
+//
+// final stuff to be done after last read() call
+//
+void SoapESP32::readStop()
+{
+  readTaskStop();
+  if (m_clientDataConOpen) {
+    if (m_keepAlive && m_connKeepAlive && m_clientDataAvailable == 0 && m_rxBufferOffset >= m_rxBufferCount) {
+      // download complete, connection can be used for next request
+      m_connReusable = true;
+      log_d("client data connection to media server kept open");
+    }
+    else {
+      soapClientStop();
+      log_d("client data connection to media server closed");
+    }
+    m_clientDataConOpen = false;
+  }
+  m_clientDataAvailable = 0;
+  m_clientDataChunked = m_clientDataUnbounded = false;
+  m_rxBufferCount = m_rxBufferOffset = 0;
+}
+
+bool SoapESP32::connectToServer(const IPAddress ip, const uint16_t port) 
+{
+  readStop(); 
+  soapStatsBegin();
+  m_connReused = false;
+  if (m_connReusable) {
+    // connection kept open from last request (nothing left in receive buffer then), reuse it 
+    // if still usable and no unexpected data arrived meanwhile
+    m_connReusable = false;
+    claimSPI();
+    bool usable = m_client->connected() && !m_client->available();
+    releaseSPI();
+    if (usable && m_connIp == ip && m_connPort == port) {
+      log_d("reusing connection to server ip=%s, port=%d", ip.toString().c_str(), port);
+      m_connReused = true;
+      return true;
+    }
+    soapClientStop();
+  }
+
+  return soapConnect(ip, port);
+}
+
+//
+// helper function: single connection attempt, limited to timeout ms
+//
+int SoapESP32::soapClientConnect(const IPAddress ip, const uint16_t port, uint32_t timeout)
+{
+  claimSPI();
+#ifdef USE_ETHERNET
+  m_client->setConnectionTimeout((uint16_t)min(timeout, (uint32_t)UINT16_MAX));
+  int ret = m_client->connect(ip, port);
+#else
+  int ret = m_client->connect(ip, port, (int32_t)timeout);
+#endif
+  releaseSPI();
+
+  return ret;
+}
+
+//
+// helper function: open new connection to server, within the statistics record of current request
+// (also used when a reused connection failed in the middle of a request)
+//
+bool SoapESP32::soapConnect(const IPAddress ip, const uint16_t port)
+{
+  uint32_t start = millis();
+
+  m_connReused = false;
+  for (int i = 0;;) {
+    // each attempt limited to time left until deadline (if set)
+    uint32_t timeout = soapTimeout(SERVER_CONNECT_TIMEOUT);
+    int ret = 0;
+    if (timeout > 0) {
+      ret = soapClientConnect(ip, port, timeout);
+    }
+    if (ret) break;
+    if (++i >= 3 || soapTimeout(100) < 100) {   // gave up or no time left for another attempt
+      log_e("error connecting to server ip=%s, port=%d", ip.toString().c_str(), port);
+      m_stats.connectTime += millis() - start;
+      return false;
+    }  
+    delay(100);  
+  }
+  m_stats.connectTime += millis() - start;
+  m_connIp = ip;
+  m_connPort = port;
+  return true;
+}
+
+bool SoapESP32::waitForResponse(void) 
+{
+  // give server some time to answer
+  uint32_t start = millis();
+  uint32_t timeout = soapTimeout(SERVER_RESPONSE_TIMEOUT);
+  while (true) {
+    claimSPI();
+    int av = m_client->available();
+    bool closed = !av && m_connReused && !m_client->connected();
+    releaseSPI();
+    if (av) break;
+    if (closed) {
+      // reused connection closed by server meanwhile, no need to wait for timeout
+      m_stats.firstByteTime += millis() - start;
+      soapClientStop();
+      log_d("reused connection closed by server");
+      return false;
+    }
+    if (millis() - start >= timeout) {
+      m_stats.firstByteTime += millis() - start;
+      soapClientStop();
+      log_e("No reply from server for %d ms", timeout);
+      return false;
+    }
+    delay(1);  // let other tasks run meanwhile
+  }
+  m_stats.firstByteTime += millis() - start;
+  return true;
+}
+
+//
+// start assembling a request: request line & host header. Requests are assembled in the receive
+// buffer (free until reply arrives), so building them needs neither heap nor extra stack. Parts 
+// not fitting into the buffer are written to the client right away
+//
+void SoapESP32::soapTxBegin(const char *method, const IPAddress ip, const uint16_t port, const char *uri)
+{
+  m_rxBufferCount = m_rxBufferOffset = 0;
+  m_txCount = 0;
+  m_txFlushed = false;
+  log_d("%s:%d %s /%s %s", ip.toString().c_str(), port, method, uri, HTTP_VERSION);
+  soapTxAdd(method);
+  soapTxAdd(" /", 2);
+  soapTxAdd(uri);
+  soapTxAdd(" " HTTP_VERSION "\r\n");
+  soapTxPrintf(HEADER_HOST, ip[0], ip[1], ip[2], ip[3], port);
+}
+
+void SoapESP32::soapTxAdd(const char *str)
+{
+  soapTxAdd(str, strlen(str));
+}
+
+void SoapESP32::soapTxAdd(const char *str, size_t len)
+{
+  while (len > 0) {
+    size_t n = sizeof(m_rxBuffer) - m_txCount;
+    if (n > len) n = len;
+    memcpy(m_rxBuffer + m_txCount, str, n);
+    m_txCount += n;
+    str += n;
+    len -= n;
+    if (m_txCount == sizeof(m_rxBuffer)) soapTxFlush();
+  }
+}
+
+//
+// helper functions: replacement of XML special characters, NULL if none needed
+//
+static const char *soapXmlEntity(const char c)
+{
+  switch (c) {
+    case '&': return "&amp;";
+    case '<': return "&lt;";
+    case '>': return "&gt;";
+    case '"': return "&quot;";
+    default:  return NULL;
+  }
+}
+
+static size_t soapXmlEscapedLength(const char *str)
+{
+  size_t len = 0;
+
+  for (; *str; str++) {
+    const char *entity = soapXmlEntity(*str);
+    len += entity ? strlen(entity) : 1;
+  }
+
+  return len;
+}
+
+//
+// add request part with XML special characters replaced (text content of action arguments)
+//
+void SoapESP32::soapTxAddEscaped(const char *str)
+{
+  const char *run = str;
+
+  for (; *str; str++) {
+    const char *entity = soapXmlEntity(*str);
+    if (!entity) continue;
+    soapTxAdd(run, str - run);
+    soapTxAdd(entity);
+    run = str + 1;
+  }
+  soapTxAdd(run, str - run);
+}
+
+//
+// add formatted request part, only meant for short parts (header lines, numbers)
+//
+void SoapESP32::soapTxPrintf(const char *format, ...)
+{
+  va_list args;
+
+  for (int i = 0; i < 2; i++) {
+    va_start(args, format);
+    int len = vsnprintf((char *)m_rxBuffer + m_txCount, sizeof(m_rxBuffer) - m_txCount, format, args);
+    va_end(args);
+    if (len < 0) break;
+    if (m_txCount + len < sizeof(m_rxBuffer)) {
+      m_txCount += len;
+      return;
+    }
+    if (m_txCount == 0) break;
+    soapTxFlush();        // didn't fit behind assembled part, try again with empty buffer
+  }
+  log_e("request part too long: %s", format);
+}
+
+void SoapESP32::soapTxFlush(bool last)
+{
+  if (m_txCount == 0) return;
+  if (!last && !m_txFlushed && m_connReused) {
+    // request bigger than buffer: soapTxSend() couldn't repeat it if the kept connection turns 
+    // out to be closed by server meanwhile, so it goes to a new connection right away
+    log_d("request doesn't fit into buffer, not reusing connection");
+    soapClientStop();
+    if (!soapConnect(m_connIp, m_connPort)) return;   // failure shows up in soapTxSend()
+  }
+  log_v("send request to server:\n%.*s", (int)m_txCount, (const char *)m_rxBuffer);
+  claimSPI();
+  m_client->write(m_rxBuffer, m_txCount);
+  releaseSPI();
+  m_txFlushed = true;
+  m_txCount = 0;
+}
+
+//
+// send assembled request & wait for response. A reused connection (keep-alive) might have been
+// closed by server in the meantime, in which case we try once more with a new connection
+//
+bool SoapESP32::soapTxSend(const IPAddress ip, const uint16_t port)
+{
+  size_t count = m_txCount;
+
+  soapTxFlush(true);
+  if (waitForResponse()) return true;
+  if (!m_connReused) return false;   // requests bigger than buffer never go to a reused connection
+
+  log_w("reused connection to server failed, trying new connection");
+  if (!soapConnect(ip, port)) return false;
+  log_v("send request to server:\n%.*s", (int)count, (const char *)m_rxBuffer);
+  claimSPI();
+  m_client->write(m_rxBuffer, count);
+  releaseSPI();
+
+  return waitForResponse();
+}
+
+//
+// HTTP GET request, gzip: accept compressed reply (XML, never used for file downloads)
+//
+bool SoapESP32::soapGet(const IPAddress ip, const uint16_t port, const char *uri, uint64_t offset, uint64_t length,
+                        bool gzip)
+{
+  if (!connectToServer(ip, port)) {
+    return false;
+  }
+
+  // assemble HTTP header
+  soapTxBegin("GET", ip, port, uri);
+  if (offset > 0 || length > 0) {
+    // range request: "Range: bytes=1000-" or "Range: bytes=1000-1999"
+    soapTxPrintf(HEADER_RANGE, offset);
+    if (length > 0) soapTxPrintf("%llu", offset + length - 1);
+    soapTxAdd("\r\n", 2);
+  }
+  if (gzip) soapTxAdd(HEADER_ACCEPT_ENCODING_GZIP);
+  soapTxAdd(m_keepAlive ? HEADER_CONNECTION_KEEP_ALIVE : HEADER_CONNECTION_CLOSE);
+  soapTxAdd(HEADER_USER_AGENT);
+  soapTxAdd(HEADER_EMPTY_LINE);           // empty line marks end of HTTP header
+
+  return soapTxSend(ip, port);
+}
+
+//
+// HTTP POST request: SOAP action with body (complete action element)
+//
+bool SoapESP32::soapActionPost(const IPAddress ip, 
+                               const uint16_t port, 
+                               const char *uri, 
+                               const char *soapAction, 
+                               const char *body)
+{
+  if (!connectToServer(ip, port)) return false;
+
+  uint16_t messageLength;
+  size_t bodyLength = strlen(body);
+
+  // calculate XML message length
+  messageLength = sizeof(SOAP_ENVELOPE_START) - 1;
+  messageLength += sizeof(SOAP_BODY_START) - 1;
+  messageLength += bodyLength;
+  messageLength += sizeof(SOAP_BODY_END) - 1;
+  messageLength += sizeof(SOAP_ENVELOPE_END) - 1;
+
+  // assemble HTTP header
+  soapTxBegin("POST", ip, port, uri);
+  soapTxAdd(m_keepAlive ? HEADER_CONNECTION_KEEP_ALIVE : HEADER_CONNECTION_CLOSE);
+  soapTxPrintf(HEADER_CONTENT_LENGTH_D, messageLength);
+  soapTxAdd(HEADER_CONTENT_TYPE);
+  soapTxAdd(soapAction);
+  soapTxAdd(HEADER_USER_AGENT);
+  soapTxAdd(HEADER_EMPTY_LINE);                // empty line marks end of HTTP header !
+
+  // assemble SOAP message
+  soapTxAdd(SOAP_ENVELOPE_START SOAP_BODY_START);
+  soapTxAdd(body, bodyLength);
+  soapTxAdd(SOAP_BODY_END SOAP_ENVELOPE_END);
+
+  return soapTxSend(ip, port);
+}
+
+//
+// helper function: ask ContentDirectory service for SystemUpdateID
+//
+bool SoapESP32::soapGetSystemUpdateId(const soapServer_t *server, uint32_t *id)
+{
+  uint64_t contentSize;
+  bool chunked = false, start;
+  String str((char *)0);
+  MiniXPathMulti xPath;
+
+  if (!soapActionPost(server->ip, server->port, server->controlURL.c_str(), 
+                      HEADER_SOAP_ACTION_GET_SYSTEM_UPDATE_ID, SOAP_GET_SYSTEM_UPDATE_ID)) {
+    return false;
+  }
+  if (!soapReadHttpHeader(&contentSize, &chunked)) {
+    soapClientStop();
+    return false;
+  }
+
+  xPath.setPaths(systemUpdateIdPath, sizeof(systemUpdateIdPath) / sizeof(xPathParser_t));
+  while (true) {
+    int ret = soapReadXML(chunked);
+    if (ret < 0) {
+      log_e("soapReadXML() returned: %d", ret); 
+      soapClientStop();
+      return false;
+    }
+    if (xPath.getValue((char)ret, &str, NULL, &start) != XPATH_MULTI_NO_MATCH && !start) break;
+  }
+  *id = strtoul(str.c_str(), NULL, 10);
+  log_d("SystemUpdateID: %u", *id);
+  soapFinishResponse(chunked, true);
+
+  return true;
+}
+
+//
+// HTTP POST request: Browse, or Search if criteria is given
+//
+bool SoapESP32::soapBrowsePost(const IPAddress ip, 
+                               const uint16_t port, 
+                               const char *uri, 
+                               const char *objectId, 
+                               const uint32_t startingIndex, 
+                               const uint16_t maxCount,
+                               const char *filter,
+                               const char *criteria,
+                               const char *sortCriteria)
+{
+  if (!connectToServer(ip, port)) return false;
+
+  uint16_t messageLength;
+  char index[12], count[6];
+  size_t idLength = strlen(objectId), filterLength = strlen(filter);
+
+  if (!sortCriteria) sortCriteria = SOAP_DEFAULT_BROWSE_SORT_CRITERIA;
+  itoa(startingIndex, index, 10);
+  itoa(maxCount, count, 10);
+  // calculate XML message length
+  messageLength = sizeof(SOAP_ENVELOPE_START) - 1;
+  messageLength += sizeof(SOAP_BODY_START) - 1;
+  if (criteria) {
+    messageLength += sizeof(SOAP_SEARCH_START) - 1;
+    messageLength += sizeof(SOAP_CONTAINERID_START) - 1 + idLength + sizeof(SOAP_CONTAINERID_END) - 1;
+    messageLength += sizeof(SOAP_SEARCHCRITERIA_START) - 1 + soapXmlEscapedLength(criteria) + sizeof(SOAP_SEARCHCRITERIA_END) - 1;
+  }
+  else {
+    messageLength += sizeof(SOAP_BROWSE_START) - 1;
+    messageLength += sizeof(SOAP_OBJECTID_START) - 1 + idLength + sizeof(SOAP_OBJECTID_END) - 1;
+    messageLength += sizeof(SOAP_BROWSEFLAG_START) - 1 + sizeof(SOAP_DEFAULT_BROWSE_FLAG) - 1 + sizeof(SOAP_BROWSEFLAG_END) - 1;
+  }
+  messageLength += sizeof(SOAP_FILTER_START) - 1 + filterLength + sizeof(SOAP_FILTER_END) - 1;
+  messageLength += sizeof(SOAP_STARTINGINDEX_START) - 1 + strlen(index) + sizeof(SOAP_STARTINGINDEX_END) - 1;
+  messageLength += sizeof(SOAP_REQUESTEDCOUNT_START) - 1 + strlen(count) + sizeof(SOAP_REQUESTEDCOUNT_END) - 1;
+  messageLength += sizeof(SOAP_SORTCRITERIA_START) - 1 + soapXmlEscapedLength(sortCriteria) + sizeof(SOAP_SORTCRITERIA_END) - 1;
+  messageLength += criteria ? sizeof(SOAP_SEARCH_END) - 1 : sizeof(SOAP_BROWSE_END) - 1;
+  messageLength += sizeof(SOAP_BODY_END) - 1;
+  messageLength += sizeof(SOAP_ENVELOPE_END) - 1;
+
+  // assemble HTTP header
+  soapTxBegin("POST", ip, port, uri);
+  soapTxAdd(HEADER_NO_CACHE);
+  soapTxAdd(m_keepAlive ? HEADER_CONNECTION_KEEP_ALIVE : HEADER_CONNECTION_CLOSE);
+  soapTxPrintf(HEADER_CONTENT_LENGTH_D, messageLength);
+  soapTxAdd(HEADER_CONTENT_TYPE);
+  soapTxAdd(criteria ? HEADER_SOAP_ACTION_SEARCH : HEADER_SOAP_ACTION_BROWSE);
+  if (m_compression) soapTxAdd(HEADER_ACCEPT_ENCODING_GZIP);
+  soapTxAdd(HEADER_USER_AGENT);
+  soapTxAdd(HEADER_EMPTY_LINE);                // empty line marks end of HTTP header !
+
+  // assemble SOAP message (adjacent literals get merged by compiler)
+  if (criteria) {
+    soapTxAdd(SOAP_ENVELOPE_START SOAP_BODY_START SOAP_SEARCH_START SOAP_CONTAINERID_START);
+    soapTxAdd(objectId, idLength);
+    soapTxAdd(SOAP_CONTAINERID_END SOAP_SEARCHCRITERIA_START);
+    soapTxAddEscaped(criteria);
+    soapTxAdd(SOAP_SEARCHCRITERIA_END SOAP_FILTER_START);
+  }
+  else {
+    soapTxAdd(SOAP_ENVELOPE_START SOAP_BODY_START SOAP_BROWSE_START SOAP_OBJECTID_START);
+    soapTxAdd(objectId, idLength);
+    soapTxAdd(SOAP_OBJECTID_END SOAP_BROWSEFLAG_START SOAP_DEFAULT_BROWSE_FLAG SOAP_BROWSEFLAG_END SOAP_FILTER_START);
+  }
+  soapTxAdd(filter, filterLength);
+  soapTxAdd(SOAP_FILTER_END SOAP_STARTINGINDEX_START);
+  soapTxAdd(index);
+  soapTxAdd(SOAP_STARTINGINDEX_END SOAP_REQUESTEDCOUNT_START);
+  soapTxAdd(count);
+  soapTxAdd(SOAP_REQUESTEDCOUNT_END SOAP_SORTCRITERIA_START);
+  soapTxAddEscaped(sortCriteria);
+  soapTxAdd(SOAP_SORTCRITERIA_END);
+  soapTxAdd(criteria ? SOAP_SEARCH_END : SOAP_BROWSE_END);
+  soapTxAdd(SOAP_BODY_END SOAP_ENVELOPE_END);
+
+  return soapTxSend(ip, port);
+}
+
+//
+// returns number of usable media servers in our list
+//
+uint8_t SoapESP32::getServerCount(void)
+{
+  claimServerList();
+  uint8_t count = m_server.size();
+  releaseServerList();
+
+  return count;
+}
+
+//
+// returns infos about a media servers from our internal list
+//
+bool SoapESP32::getServerInfo(uint8_t srv, soapServer_t *serverInfo)
+{
+  claimServerList();
+  bool ret = (srv < m_server.size());
+  if (ret) *serverInfo = m_server[srv];
+  releaseServerList();
+
+  return ret;
+}
+
+//
+// servers of the same replica group (1..255, 0: none) deliver the same library with identical 
+// object ids (e.g. same server software on mirrored NAS). Browse & search requests for any of
+// them go to the fastest healthy one, others take over when it fails.
+//
+bool SoapESP32::setReplicaGroup(uint8_t srv, uint8_t group)
+{
+  claimServerList();
+  bool ret = (srv < m_server.size());
+  if (ret) m_server[srv].replicaGroup = group;
+  releaseServerList();
+
+  return ret;
+}
+
+//
+// returns server that answered last browse/search request (differs from requested server if a
+// replica was chosen), -1: none
+//
+int SoapESP32::getLastServer()
+{
+  return m_lastServer;
+}
+
+//
+// helper function: choose server for request to srv, healthy servers first (no failure within 
+// SOAP_REPLICA_RETRY_AFTER ms), then the lowest latency. srv wins a tie, servers in bit mask 
+// tried are skipped. Returns -1 if none is left.
+//
+int SoapESP32::soapSelectServer(uint8_t srv, uint32_t tried)
+{
+  int best = -1;
+  bool bestHealthy = false;
+  uint32_t now = millis();
+
+  claimServerList();
+  if (srv < m_server.size()) {
+    uint8_t group = m_server[srv].replicaGroup;
+
+    for (size_t n = 0; n <= m_server.size(); n++) {
+      size_t i = (n == 0) ? srv : n - 1;   // requested server first
+
+      if (n > 0 && (i == srv || group == 0 || m_server[i].replicaGroup != group || i >= 32)) continue;
+      if (i < 32 && (tried & ((uint32_t)1 << i))) continue;
+
+      const soapServer_t *server = &m_server[i];
+      bool healthy = server->online && 
+                     (server->failures == 0 || (now - server->lastFailure) >= SOAP_REPLICA_RETRY_AFTER);
+      if (best < 0 ||
+          (healthy && !bestHealthy) ||
+          (healthy && server->latency < m_server[best].latency) ||
+          (!healthy && !bestHealthy && (int32_t)(server->lastFailure - m_server[best].lastFailure) < 0)) {
+        best = i;
+        bestHealthy = healthy;
+      }
     }
-    if (xPathNumberReturned.getValue((char)ret, &str) ||
-        xPathNumberReturnedAlt1.getValue((char)ret, &str) ||
-        xPathNumberReturnedAlt2.getValue((char)ret, &str)) {
-      count = str.toInt();
-      log_d("announced number of folders and/or files: %d", count);
-      break;  // numberReturned comes last, so we can break here
+  }
+  releaseServerList();
+
+  return best;
+}
+
+//
+// helper function: update health of server after request, latency 0: not measured
+//
+void SoapESP32::soapServerHealth(const soapServer_t *server, bool ok, uint32_t latency)
+{
+  claimServerList();
+  for (size_t i = 0; i < m_server.size(); i++) {
+    if (!(m_server[i].ip == server->ip && m_server[i].port == server->port)) continue;
+    if (!ok) {
+      if (m_server[i].failures < 255) m_server[i].failures++;
+      m_server[i].lastFailure = millis();
+      log_d("server %s:%d failed %d time(s)", server->ip.toString().c_str(), server->port, m_server[i].failures);
+      continue;
+    }
+    m_server[i].failures = 0;
+    if (latency > 0) {
+      // moving average, a single slow reply doesn't make a server slow
+      m_server[i].latency = m_server[i].latency ? (3 * m_server[i].latency + latency + 2) / 4 : latency;
     }
   }
+  releaseServerList();
+}
 
-  if (count == 0) {
-    log_i("XML scanned, no elements announced");
+//
+// merged browsing: shared job description & per worker task parameters
+//
+typedef struct {
+  const std::vector<uint8_t> *servers;      // servers to browse
+  soapObjectVect_t *result;                 // one result list per server
+  int              *answered;               // server that answered (replica), -1: failed
+  const char       *objectId;
+  uint16_t          maxCount;
+  uint16_t          fields;
+  size_t            next;                   // next server to be browsed
+  SemaphoreHandle_t lock;                   // protects next
+  SemaphoreHandle_t done;                   // given by each worker task when finished
+} soapMergeJob_t;
+
+typedef struct {
+  soapMergeJob_t *job;
+  SoapESP32      *soap;                     // worker session with own client
+} soapMergeWorker_t;
+
+//
+// merge worker task: browse servers until no server is left
+//
+void SoapESP32::soapMergeTask(void *param)
+{
+  soapMergeWorker_t *worker = (soapMergeWorker_t *)param;
+  soapMergeJob_t *job = worker->job;
+
+  while (true) {
+    xSemaphoreTake(job->lock, portMAX_DELAY);
+    size_t j = job->next++;
+    xSemaphoreGive(job->lock);
+    if (j >= job->servers->size()) break;
+    if (worker->soap->browseServer((*job->servers)[j], job->objectId, &job->result[j], 
+                                   SOAP_DEFAULT_BROWSE_STARTING_INDEX, job->maxCount, job->fields)) {
+      job->answered[j] = worker->soap->getLastServer();
+    }
   }
-  else if (count != (countContainer + countItem)) {
-    log_w("XML scanned, elements announced: %d != found: %d", count, countContainer + countItem);
+
+  xSemaphoreGive(job->done);
+  vTaskDelete(NULL);
+}
+
+//
+// browse the same directory (default: root) of all servers in list in parallel, replica groups 
+// are browsed once (fastest healthy replica). Results are appended in order of the server list, 
+// servers[i] is the server delivering browseResult[i] (use it to browse further down). 
+// Returns false if no server answered.
+//
+bool SoapESP32::browseMerged(soapObjectVect_t *browseResult, std::vector<uint8_t> *servers, const char *objectId,
+                             const uint16_t maxCount, const uint16_t fields)
+{
+  std::vector<uint8_t> targets;   // one server of each replica group
+  uint32_t groups[8] = { 0 };     // bit mask of replica groups seen
+
+  if (!browseResult || !servers || !objectId) return false;
+  browseResult->clear();
+  servers->clear();
+
+  claimServerList();
+  for (size_t i = 0; i < m_server.size() && i < 256; i++) {
+    uint8_t group = m_server[i].replicaGroup;
+    if (group && (groups[group / 32] & ((uint32_t)1 << (group % 32)))) continue;
+    if (group) groups[group / 32] |= (uint32_t)1 << (group % 32);
+    targets.push_back(i);
+  }
+  releaseServerList();
+  if (targets.empty()) return false;
+
+  std::vector<soapObjectVect_t> result(targets.size());
+  std::vector<int> answered(targets.size(), -1);
+  soapMergeJob_t job = { .servers = &targets, .result = result.data(), .answered = answered.data(), .objectId = objectId,
+                         .maxCount = maxCount, .fields = fields, .next = 0, .lock = NULL, .done = NULL };
+  int workers = min((int)targets.size(), SOAP_MERGE_MAX_WORKERS), started = 0;
+
+  if (workers > 1 && (job.lock = xSemaphoreCreateMutex()) && (job.done = xSemaphoreCreateCounting(workers, 0))) {
+#ifdef USE_ETHERNET
+    EthernetClient client[SOAP_MERGE_MAX_WORKERS];
+#else
+    WiFiClient client[SOAP_MERGE_MAX_WORKERS];
+#endif
+    soapMergeWorker_t worker[SOAP_MERGE_MAX_WORKERS];
+
+    for (int i = 0; i < workers; i++) {
+      worker[started].soap = new SoapESP32(this, &client[i]);
+      worker[started].job = &job;
+      if (xTaskCreate(soapMergeTask, "soapMerge", SOAP_MERGE_TASK_STACK, &worker[started], 
+                      SOAP_MERGE_TASK_PRIO, NULL) != pdPASS) {
+        log_w("could not start merge task %d", i);
+        delete worker[started].soap;
+        break;
+      }
+      started++;
+    }
+    log_i("browsing %d servers with %d worker tasks", targets.size(), started);
+
+    // wait for all workers to finish
+    for (int i = 0; i < started; i++) xSemaphoreTake(job.done, portMAX_DELAY);
+    for (int i = 0; i < started; i++) delete worker[i].soap;
+  }
+  if (job.lock) vSemaphoreDelete(job.lock);
+  if (job.done) vSemaphoreDelete(job.done);
+
+  if (started == 0) {
+    // single server or no worker task: browse one after the other
+    for (size_t j = 0; j < targets.size(); j++) {
+      if (browseServer(targets[j], objectId, &result[j], SOAP_DEFAULT_BROWSE_STARTING_INDEX, maxCount, fields)) {
+        answered[j] = m_lastServer;
+      }
+    }
+  }
+
+  bool ok = false;
+  for (size_t j = 0; j < targets.size(); j++) {
+    if (answered[j] < 0) continue;
+    ok = true;
+    for (auto &object : result[j]) {
+      browseResult->push_back(std::move(object));
+      servers->push_back((uint8_t)answered[j]);
+    }
+  }
+
+  return ok;
+}
+
+//
+// returns number of available/remaining bytes
+//
+size_t SoapESP32::available()
+{
+  if (!m_clientDataConOpen) return 0;
+
+  return (m_clientDataAvailable > (uint64_t)SIZE_MAX) ? SIZE_MAX : (size_t)m_clientDataAvailable;
+}
+
+//
+// returns number of available/remaining bytes (files bigger than 4.2GB)
+//
+uint64_t SoapESP32::available64()
+{
+  return m_clientDataConOpen ? m_clientDataAvailable : 0;
+}
+
+//
+// returns file offset of next byte to be read (offset requested with readStart() + bytes read)
+//
+uint64_t SoapESP32::readPosition()
+{
+  return m_clientDataPosition;
+}
+
+//
+// returns pointer to string (item type name)
+//
+const char *SoapESP32::getFileTypeName(eFileType fileType)
+{
+  return (fileTypeAudio <= fileType && fileType <= fileTypeVideo) ? fileTypes[fileType] : fileTypes[fileTypeOther];
+}
+
+//
+// helper function: ms until subscription with given timeout (s, 0: infinite) should be renewed
+//
+static uint32_t soapEventRenewDelay(uint32_t timeout)
+{
+  if (timeout > 2 * SOAP_EVENT_RENEW_MARGIN) return (timeout - SOAP_EVENT_RENEW_MARGIN) * 1000;
+
+  return timeout * 500;
+}
+
+//
+// start NOTIFY listener task on given port, it receives the events of subscriptions made with 
+// subscribeEvents() and renews them in time. Callback function (optional) runs in listener task !
+//
+bool SoapESP32::startEventListener(soapEventCallback_t callback, void *userData, uint16_t port)
+{
+  if (m_eventTask) return true;
+  if (!m_serverLock) return false;
+  if (!m_eventDone && !(m_eventDone = xSemaphoreCreateBinary())) return false;
+
+  m_eventCallback = callback;
+  m_eventUserData = userData;
+  m_eventPort = port;
+  m_eventRun = true;
+  if (xTaskCreate(soapEventTask, "soapEvent", SOAP_EVENT_TASK_STACK, this, 
+                  SOAP_EVENT_TASK_PRIO, &m_eventTask) != pdPASS) {
+    log_e("could not start event listener task");
+    m_eventTask = NULL;
+    m_eventRun = false;
+    return false;
+  }
+  log_i("event listener started on port %d", port);
+
+  return true;
+}
+
+//
+// stop NOTIFY listener task (waits until task has finished), the task cancels all subscriptions
+// on its own connection before it ends, so a download in progress isn't disturbed
+//
+void SoapESP32::stopEventListener()
+{
+  if (!m_eventTask) return;
+
+  m_eventRun = false;
+  xSemaphoreTake(m_eventDone, portMAX_DELAY);
+  m_eventTask = NULL;
+  log_i("event listener stopped");
+}
+
+//
+// subscribe to events of a server's service (ContentDirectory/AVTransport), timeout in s
+// requires a running event listener
+//
+bool SoapESP32::subscribeEvents(uint8_t srv, uint32_t timeout)
+{
+  soapServer_t server;
+  soapSubscription_t sub;
+  int i;
+
+  if (!m_eventTask) {
+    log_e("event listener not running");
+    return false;
+  }
+  if (!getServerInfo(srv, &server)) return false;
+  if (server.eventSubURL.length() == 0) {
+    log_e("server \"%s\" doesn't announce an event subscription URL", server.friendlyName.c_str());
+    return false;
+  }
+  unsubscribeEvents(srv);
+
+  // pending entry: initial NOTIFY might arrive before we got the reply
+  sub = { .ip = server.ip, .port = server.port, .eventSubURL = server.eventSubURL, .sid = "", 
+          .timeout = 0, .renewAt = 0, .playing = false };
+  claimServerList();
+  m_subscriptions.push_back(sub);
+  releaseServerList();
+
+  bool ok = soapEventRequest("SUBSCRIBE", server.ip, server.port, server.eventSubURL.c_str(), NULL, timeout, m_eventPort) && 
+            m_httpSid.length() > 0;
+
+  claimServerList();
+  for (i = 0; i < m_subscriptions.size(); i++) {
+    if (m_subscriptions[i].ip == server.ip && m_subscriptions[i].port == server.port) break;
+  }
+  if (i < m_subscriptions.size()) {
+    if (ok) {
+      m_subscriptions[i].sid = m_httpSid;
+      m_subscriptions[i].timeout = m_httpTimeout;
+      m_subscriptions[i].renewAt = millis() + soapEventRenewDelay(m_httpTimeout);
+    }
+    else {
+      m_subscriptions.erase(m_subscriptions.begin() + i);
+    }
+  }
+  releaseServerList();
+
+  if (!ok) {
+    log_e("subscription to events of server \"%s\" failed", server.friendlyName.c_str());
+    return false;
+  }
+  log_i("subscribed to events of server \"%s\", SID: %s, timeout: %u s", 
+        server.friendlyName.c_str(), m_httpSid.c_str(), m_httpTimeout);
+
+  return true;
+}
+
+//
+// cancel event subscription of a server
+//
+bool SoapESP32::unsubscribeEvents(uint8_t srv)
+{
+  soapServer_t server;
+  String sid((char *)0), url((char *)0);
+  int i;
+
+  if (!getServerInfo(srv, &server)) return false;
+
+  claimServerList();
+  for (i = 0; i < m_subscriptions.size(); i++) {
+    if (m_subscriptions[i].ip == server.ip && m_subscriptions[i].port == server.port) break;
+  }
+  if (i < m_subscriptions.size()) {
+    sid = m_subscriptions[i].sid;
+    url = m_subscriptions[i].eventSubURL;
+    m_subscriptions.erase(m_subscriptions.begin() + i);
+  }
+  releaseServerList();
+  if (sid.length() == 0) return false;
+
+  return soapEventRequest("UNSUBSCRIBE", server.ip, server.port, url.c_str(), sid.c_str());
+}
+
+//
+// helper function: send GENA request (SUBSCRIBE/UNSUBSCRIBE), returns true if server accepted it
+// SUBSCRIBE without sid: new subscription (callback to our listener), with sid: renewal
+// SID & granted timeout of reply end up in m_httpSid & m_httpTimeout
+//
+bool SoapESP32::soapEventRequest(const char *method, 
+                                 const IPAddress ip, 
+                                 const uint16_t port, 
+                                 const char *eventSubURL, 
+                                 const char *sid,
+                                 const uint32_t timeout,
+                                 const uint16_t callbackPort)
+{
+  uint64_t contentSize;
+
+  m_httpStatus = 0;
+  m_httpSid = "";
+  if (!connectToServer(ip, port)) return false;
+
+  // assemble HTTP header
+  soapTxBegin(method, ip, port, eventSubURL);
+  if (sid) {
+    soapTxAdd(HEADER_SID);
+    soapTxAdd(sid);
+    soapTxAdd("\r\n", 2);
+  }
+  else {
+    // callback URL points to our NOTIFY listener
+#ifdef USE_ETHERNET
+    claimSPI();
+    IPAddress local = Ethernet.localIP();
+    releaseSPI();
+#else
+    IPAddress local = WiFi.localIP();
+#endif
+    soapTxPrintf(HEADER_CALLBACK, local[0], local[1], local[2], local[3], callbackPort, SOAP_EVENT_PATH);
+    soapTxAdd(HEADER_NT_EVENT);
+  }
+  if (timeout) soapTxPrintf(HEADER_TIMEOUT_D, timeout);
+  soapTxAdd(HEADER_CONNECTION_CLOSE HEADER_USER_AGENT HEADER_EMPTY_LINE);
+
+  if (!soapTxSend(ip, port)) return false;
+
+  // replies usually come without content, missing content length doesn't matter here
+  soapReadHttpHeader(&contentSize);
+  soapClientStop();
+
+  return m_httpStatus == HTTP_STATUS_OK;
+}
+
+//
+// NOTIFY listener task: accepts event messages & renews subscriptions, uses own server, 
+// clients & SoapESP32 instances
+//
+void SoapESP32::soapEventTask(void *param)
+{
+  SoapESP32 *soap = (SoapESP32 *)param;
+
+  // inner scope: destructors (servers, clients, mutexes of instances) run before task gets deleted
+  {
+#ifdef USE_ETHERNET
+    EthernetServer server(soap->m_eventPort);
+    EthernetClient client, notifyClient;
+    SoapESP32 worker(&client, NULL, soap->m_SPIsem);
+    SoapESP32 listener(&notifyClient, NULL, soap->m_SPIsem);
+#else
+    WiFiServer server(soap->m_eventPort);
+    WiFiClient client, notifyClient;
+    SoapESP32 worker(&client);
+    SoapESP32 listener(&notifyClient);
+#endif
+    soapSubscriptionVect_t subs;
+
+    soapClaimSPI(&listener);
+    server.begin();
+    soapReleaseSPI(&listener);
+
+    while (soap->m_eventRun) {
+      soapClaimSPI(&listener);
+      notifyClient = server.available();
+      bool incoming = notifyClient;
+      soapReleaseSPI(&listener);
+      if (incoming) {
+        listener.soapEventNotify(soap);
+        continue;
+      }
+      worker.soapEventRenew(soap);
+      delay(SOAP_EVENT_POLL_INTERVAL);
+    }
+
+    // cancel all subscriptions
+    soapClaimServerList(soap);
+    subs.swap(soap->m_subscriptions);
+    soapReleaseServerList(soap);
+    for (int i = 0; i < subs.size(); i++) {
+      if (subs[i].sid.length() == 0) continue;
+      worker.soapEventRequest("UNSUBSCRIBE", subs[i].ip, subs[i].port, subs[i].eventSubURL.c_str(), subs[i].sid.c_str());
+    }
+
+    soapClaimSPI(&listener);
+    notifyClient.stop();
+#ifndef USE_ETHERNET
+    server.stop();   // EthernetServer has no stop(), its socket gets released by destructor
+#endif
+    soapReleaseSPI(&listener);
+  }
+
+  xSemaphoreGive(soap->m_eventDone);
+  vTaskDelete(NULL);
+}
+
+//
+// helper function: renew next due subscription (called on listener task's worker instance)
+//
+void SoapESP32::soapEventRenew(SoapESP32 *owner)
+{
+  soapSubscription_t due;
+  bool found = false;
+  int i;
+
+  soapClaimServerList(owner);
+  for (i = 0; i < owner->m_subscriptions.size(); i++) {
+    soapSubscription_t *sub = &owner->m_subscriptions[i];
+    if (sub->sid.length() && sub->timeout && (int32_t)(millis() - sub->renewAt) >= 0) {
+      due = *sub;
+      found = true;
+      break;
+    }
+  }
+  soapReleaseServerList(owner);
+  if (!found) return;
+
+  bool ok = soapEventRequest("SUBSCRIBE", due.ip, due.port, due.eventSubURL.c_str(), due.sid.c_str(), due.timeout);
+  if (!ok && m_httpStatus == HTTP_STATUS_PRECONDITION_FAILED) {
+    // server doesn't know subscription anymore (e.g. after restart), subscribe again
+    log_i("subscription %s expired, subscribing again", due.sid.c_str());
+    ok = soapEventRequest("SUBSCRIBE", due.ip, due.port, due.eventSubURL.c_str(), NULL, due.timeout, 
+                          owner->m_eventPort) && m_httpSid.length();
+  }
+
+  soapClaimServerList(owner);
+  for (i = 0; i < owner->m_subscriptions.size(); i++) {
+    soapSubscription_t *sub = &owner->m_subscriptions[i];
+    if (sub->sid != due.sid) continue;
+    if (ok) {
+      if (m_httpSid.length()) sub->sid = m_httpSid;
+      sub->timeout = m_httpTimeout;
+      sub->renewAt = millis() + soapEventRenewDelay(m_httpTimeout);
+      log_d("subscription %s renewed, timeout: %u s", sub->sid.c_str(), sub->timeout);
+    }
+    else {
+      sub->renewAt = millis() + SOAP_EVENT_RETRY_INTERVAL * 1000;
+      log_w("renewal of subscription %s failed, trying again in %d s", sub->sid.c_str(), SOAP_EVENT_RETRY_INTERVAL);
+    }
+    break;
+  }
+  soapReleaseServerList(owner);
+}
+
+//
+// helper function: read NOTIFY message from listener connection, deliver events & reply
+// (called on listener task's own instance, owner keeps subscriptions & callback)
+//
+void SoapESP32::soapEventNotify(SoapESP32 *owner)
+{
+  size_t len;
+  uint64_t contentLength = 0;
+  int status = HTTP_STATUS_OK;
+  bool start;
+  soapEvent_t event;
+  MiniXPathMulti xPath;
+  char tmpBuffer[TMP_BUFFER_SIZE_200];
+  String str((char *)0);
+
+  m_rxBufferCount = m_rxBufferOffset = 0;
+
+  // request line "NOTIFY /event HTTP/1.1" followed by header with SID, SEQ & content length
+  len = soapClientReadBytesUntil('\n', tmpBuffer, sizeof(tmpBuffer) - 1);
+  tmpBuffer[len] = 0;
+  log_d("event listener: %s", tmpBuffer);
+  if (strncmp(tmpBuffer, "NOTIFY ", 7) != 0) status = HTTP_STATUS_BAD_REQUEST;
+  event.seq = 0;
+  while (true) {
+    len = soapClientReadBytesUntil('\n', tmpBuffer, sizeof(tmpBuffer) - 1);
+    tmpBuffer[len] = 0;
+    if (len <= 1) break;      // end of header (line contains only "\r\n") or timeout
+    log_v("header line: %s", tmpBuffer);
+    if (strncasecmp(tmpBuffer, HEADER_SID, sizeof(HEADER_SID) - 1) == 0) {
+      event.sid = tmpBuffer + sizeof(HEADER_SID) - 1;
+      event.sid.trim();
+    }
+    else if (strncasecmp(tmpBuffer, HEADER_SEQ, sizeof(HEADER_SEQ) - 1) == 0) {
+      event.seq = strtoul(tmpBuffer + sizeof(HEADER_SEQ) - 1, NULL, 10);
+    }
+    else if (strncasecmp(tmpBuffer, HEADER_CONTENT_LENGTH, sizeof(HEADER_CONTENT_LENGTH) - 1) == 0) {
+      sscanf(tmpBuffer + sizeof(HEADER_CONTENT_LENGTH) - 1, "%llu", &contentLength);
+    }
+  }
+  if (status == HTTP_STATUS_OK && (contentLength == 0 || contentLength > SOAP_EVENT_MAX_BODY)) {
+    log_w("event message size not acceptable: %llu", contentLength);
+    status = HTTP_STATUS_BAD_REQUEST;
+  }
+  if (status == HTTP_STATUS_OK && !owner->soapEventSender(&event)) {
+    log_w("event of unknown subscription: %s", event.sid.c_str());
+    status = HTTP_STATUS_PRECONDITION_FAILED;
+  }
+
+  if (status == HTTP_STATUS_OK) {
+    // scan property set for evented state variables
+    m_xmlContentLeft = contentLength;
+    xPath.setPaths(eventParserPaths, sizeof(eventParserPaths) / sizeof(xPathParser_t));
+    while (true) {
+      int c = soapReadXML(false);
+      if (c < 0) break;
+      int path = xPath.getValue((char)c, &str, NULL, &start);
+      if (path == XPATH_MULTI_NO_MATCH || start) continue;
+      event.name = eventParserPaths[path].tagNames[2];
+      event.value = str;
+      owner->soapEventDeliver(&event, path);
+    }
   }
 
-end_stop:
+  len = snprintf(tmpBuffer, sizeof(tmpBuffer), HTTP_REPLY_NOTIFY, status, 
+                 (status == HTTP_STATUS_OK) ? "OK" : (status == HTTP_STATUS_BAD_REQUEST) ? "Bad Request" : "Precondition Failed");
   claimSPI();
-  m_client->stop();
+  m_client->write((const uint8_t *)tmpBuffer, len);
   releaseSPI();
-  log_i("found %d folders and %d files", countContainer, countItem);
-
-  // TEST
-#if CORE_DEBUG_LEVEL > 3
-  delay(10);	// allow pending serial monitor output to be sent, can be massive when verbose
-#elif CORE_DEBUG_LEVEL > 0  
-  delay(2);
-#endif  
-
-  return true;
+  soapClientStop();
 }
 
 //
-// request object (file) from media server
+// helper function: find server of subscription that sent an event, waits for pending subscriptions
 //
-bool SoapESP32::readStart(soapObject_t *object, size_t *size)
+bool SoapESP32::soapEventSender(soapEvent_t *event)
 {
-  uint64_t contentSize;
-
-  if (object->isDirectory) return false;
-  m_clientDataAvailable = 0;
-
-  log_i("server ip: %s, port: %d, uri: \"%s\"", 
-        object->downloadIp.toString().c_str(), object->downloadPort, object->uri.c_str());
+  uint32_t start = millis();
 
-  // just to make sure old connection is closed
-  if (m_clientDataConOpen) {
-    claimSPI();
-    m_client->stop();
-    releaseSPI();
-    m_clientDataConOpen = false;
-    log_w("client data connection to media server was still open. Closed now.");
+  if (event->sid.length() == 0) return false;
+  while (true) {
+    bool pending = false;
+    claimServerList();
+    for (int i = 0; i < m_subscriptions.size(); i++) {
+      if (m_subscriptions[i].sid == event->sid) {
+        event->ip = m_subscriptions[i].ip;
+        event->port = m_subscriptions[i].port;
+        releaseServerList();
+        return true;
+      }
+      if (m_subscriptions[i].sid.length() == 0) pending = true;
+    }
+    releaseServerList();
+    if (!pending || millis() - start >= SERVER_RESPONSE_TIMEOUT) return false;
+    delay(SOAP_EVENT_POLL_INTERVAL);
   }
+}
 
-  // establish connection to server and send GET request
-  if (!soapGet(object->downloadIp, object->downloadPort, object->uri.c_str())) {
-    return false;
-  }
+//
+// helper function: process event (runs in listener task), queue cache invalidations, 
+// track transport state & hand over to callback function
+//
+void SoapESP32::soapEventDeliver(soapEvent_t *event, int path)
+{
+  int i, next;
+
+  log_i("event from %s:%d: %s = %s", event->ip.toString().c_str(), event->port, event->name, event->value.c_str());
+  switch (path) {
+    case xpeSystemUpdateId:
+    case xpeContainerUpdateIds:
+      if (!m_cacheBudget) break;
+      claimServerList();
+      if (path == xpeSystemUpdateId) {
+        m_cacheEvents.push_back({ .ip = event->ip, .port = event->port, .objectId = "", 
+                                  .id = (uint32_t)strtoul(event->value.c_str(), NULL, 10) });
+      }
+      else {
+        // comma separated pairs: "containerId,updateId,containerId,updateId..."
+        for (i = 0; i < event->value.length(); i = next + 1) {
+          int comma = event->value.indexOf(',', i);
+          if (comma < 0) break;
+          next = event->value.indexOf(',', comma + 1);
+          if (next < 0) next = event->value.length();
+          m_cacheEvents.push_back({ .ip = event->ip, .port = event->port, .objectId = event->value.substring(i, comma), 
+                                    .id = (uint32_t)strtoul(event->value.substring(comma + 1, next).c_str(), NULL, 10) });
+        }
+      }
+      if (m_cacheEvents.size() > SOAP_EVENT_MAX_PENDING) {
+        m_cacheEvents.clear();
+        m_cacheEventsOverflow = true;
+      }
+      releaseServerList();
+      break;
 
-  // connection established, read HTTP header
-  if (!soapReadHttpHeader(&contentSize)) {
-    // error returned
-    log_e("soapReadHttpHeader() was unsuccessful.");
-    claimSPI();
-    m_client->stop();
-    releaseSPI();
-    return false;
+    case xpeLastChange:
+      // value is escaped XML: <Event><InstanceID val="0"><TransportState val="PLAYING"/>...
+      event->value.replace("&lt;", "<");
+      event->value.replace("&gt;", ">");
+      event->value.replace("&quot;", "\"");
+      event->value.replace("&apos;", "'");
+      event->value.replace("&amp;", "&");
+      if ((i = event->value.indexOf("<TransportState val=\"")) >= 0) {
+        i += sizeof("<TransportState val=\"") - 1;
+        bool playing = event->value.substring(i, event->value.indexOf('"', i)) == "PLAYING";
+        claimServerList();
+        for (int j = 0; j < m_subscriptions.size(); j++) {
+          if (m_subscriptions[j].sid == event->sid) m_subscriptions[j].playing = playing;
+        }
+        releaseServerList();
+      }
+      break;
   }
 
-  // max allowed file size for download is 4.2GB (SIZE_MAX)
-  if (contentSize > (uint64_t)SIZE_MAX) {
-    log_e("file too big for download. Maximum allowed file size is 4.2GB.");
-    claimSPI();
-    m_client->stop();
-    releaseSPI();
-    return false;
-  }
+  if (m_eventCallback) m_eventCallback(event, m_eventUserData);
+}
 
-  m_clientDataAvailable = (size_t)contentSize;
-  if (m_clientDataAvailable == 0) {  
-    // no data available
-    log_e("announced file size: 0 !"); 
-    claimSPI();
-    m_client->stop();
-    releaseSPI();
-    return false;
-  } 
+//
+// transport state of renderer as reported by AVTransport LastChange events, needs event 
+// subscription (subscribeEvents()), otherwise false
+//
+bool SoapESP32::isPlaying(uint8_t srv) 
+{
+  bool playing = false;
 
-  m_clientDataConOpen = true;
-  if (size) {                            // pointer valid ?
-    *size = m_clientDataAvailable;       // return size of file
+  claimServerList();
+  if (srv < m_server.size()) {
+    for (int i = 0; i < m_subscriptions.size(); i++) {
+      if (m_subscriptions[i].ip == m_server[srv].ip && m_subscriptions[i].port == m_server[srv].port) {
+        playing = m_subscriptions[i].playing;
+      }
+    }
   }
+  releaseServerList();
 
-  return true; 
+  return playing;
 }
 
+#ifndef SOAP_NO_DMR
 //
-// read up to size bytes from server and place them into buf
-// returnes number of bytes read or -1 in case nothing was read (default read timeout is 3s)
-// Remarks: 
-// - older WiFi library versions & the Ethernet library return -1 if connection is still up but 
-//   momentarily no data available and return 0 in case of EOF. Newer WiFi versions return 0 in 
-//   both cases, so we need to treat -1 & 0 equally.
-// - timeout checking is vital because client.read() can return 0 for ages in case of WiFi problems
+// helper function: "H:MM:SS" (optionally followed by fraction) to seconds, 0 if not valid
 //
-int SoapESP32::read(uint8_t *buf, size_t size, uint32_t timeout) {
+static uint32_t soapParseTime(const String &str)
+{
+  unsigned int h, m, s;
 
-  // first some basic checks
-  if (!buf || !size || !m_clientDataConOpen) return -1;  // clearly an error
-  if (!m_clientDataAvailable) return 0;   // most probably EOF
+  if (sscanf(str.c_str(), "%u:%u:%u", &h, &m, &s) != 3) return 0;
 
-  int res = -1;  
-  uint32_t start = millis();
-  
-  while (1) {
-    //if (m_clientDataAvailable < size) size = m_clientDataAvailable;
-    claimSPI();
-    res = m_client->read(buf, size);
-    releaseSPI();
-    if (res > 0) {
-      // got at least 1 byte from server
-      m_clientDataAvailable -= res;
-      break;
-    }  
-    if ((millis() - start) > timeout) {
-      // read timeout
-      log_e("error, read timeout: %d ms", timeout);
-      break;
-    }
-  }
+  return h * 3600 + m * 60 + s;
+}
 
-  return res;
+//
+// renderer: set URI of media to be played, optional DIDL-Lite meta data
+//
+bool SoapESP32::setTransportURI(uint8_t srv, const char *uri, const char *metaData)
+{
+  const char *escaped[] = { uri, metaData ? metaData : "" };
+
+  if (!uri) return false;
+
+  return soapControlRequest(srv, false, "SetAVTransportURI", SOAP_ARGS_SET_URI, NULL, 0, NULL, escaped);
 }
 
-int SoapESP32::read(void)
+bool SoapESP32::play(uint8_t srv) 
 {
-  uint8_t b;
-  if (read(&b, 1) > 0) return b;
-  return -1;
+  return soapControlRequest(srv, false, "Play", SOAP_ARGS_PLAY);
 }
 
-//
-// final stuff to be done after last read() call
-//
-void SoapESP32::readStop()
+bool SoapESP32::pause(uint8_t srv) 
 {
-  if (m_clientDataConOpen) {
-    claimSPI();
-    m_client->stop();
-    releaseSPI();
-    m_clientDataConOpen = false;
-    log_d("client data connection to media server closed");
-  }
-  m_clientDataAvailable = 0;
+  return soapControlRequest(srv, false, "Pause", "");
 }
 
-bool SoapESP32::connectToServer(const IPAddress ip, const uint16_t port) 
+bool SoapESP32::stop(uint8_t srv)
 {
-  readStop(); 
-  for (int i = 0;;) {
-    claimSPI();
-    int ret = m_client->connect(ip, (uint16_t)port);
-    releaseSPI();
-    if (ret) break;
-    if (++i >= 3) {
-      log_e("error connecting to server ip=%s, port=%d", ip.toString().c_str(), port);
-      return false;
-    }  
-    delay(100);  
-  }
-  return true;
+  return soapControlRequest(srv, false, "Stop", "");
 }
 
-void SoapESP32::sendRequest(String str) 
+//
+// renderer: jump to position (s) in current track
+//
+bool SoapESP32::seek(uint8_t srv, uint32_t position)
 {
-  // send request to server
-  log_v("send request to server:\n%s", str.c_str());
-  claimSPI();
-  m_client->print(str);
-  releaseSPI();
+  char args[SOAP_ARGS_BUF_SIZE];
+
+  snprintf(args, sizeof(args), SOAP_ARGS_SEEK, position / 3600, (position / 60) % 60, position % 60);
+
+  return soapControlRequest(srv, false, "Seek", args);
 }
 
-bool SoapESP32::waitForResponse(void) 
+//
+// renderer: current track, its duration & position
+//
+bool SoapESP32::getPositionInfo(uint8_t srv, soapPositionInfo_t *info)
 {
-  // give server some time to answer
-  uint32_t start = millis();
-  while (true) {
-    claimSPI();
-    int av = m_client->available();
-    releaseSPI();
-    if (av) break;
-    if (millis() > (start + SERVER_RESPONSE_TIMEOUT)) {
-      claimSPI();
-      m_client->stop();
-      releaseSPI();
-      log_e("No reply from server for %d ms", SERVER_RESPONSE_TIMEOUT);
-      return false;
-    }
+  String values[sizeof(positionInfoPaths) / sizeof(xPathParser_t)];
+
+  if (!info) return false;
+  if (!soapControlRequest(srv, false, "GetPositionInfo", "", positionInfoPaths, 
+                          sizeof(positionInfoPaths) / sizeof(xPathParser_t), values)) {
+    return false;
   }
+  info->track = strtoul(values[xppTrack].c_str(), NULL, 10);
+  info->duration = soapParseTime(values[xppTrackDuration]);
+  info->position = soapParseTime(values[xppRelTime]);
+  info->uri = values[xppTrackUri];
+
   return true;
 }
 
 //
-// HTTP GET request
+// renderer: transport state, status & speed
 //
-bool SoapESP32::soapGet(const IPAddress ip, const uint16_t port, const char *uri)
+bool SoapESP32::getTransportInfo(uint8_t srv, soapTransportInfo_t *info)
 {
-  if (!connectToServer(ip, port)) {
-    return false;
-  }
+  String values[sizeof(transportInfoPaths) / sizeof(xPathParser_t)];
 
-  // memory allocation for assembling HTTP header
-  size_t length = strlen(uri) + 25;
-  char *buffer = (char *)malloc(length);
-  if (!buffer) {
-    log_e("malloc() couldn't allocate memory");    
+  if (!info) return false;
+  if (!soapControlRequest(srv, false, "GetTransportInfo", "", transportInfoPaths, 
+                          sizeof(transportInfoPaths) / sizeof(xPathParser_t), values)) {
     return false;
   }
-  String str((char *)0);
+  info->state = values[xptState];
+  info->status = values[xptStatus];
+  info->speed = values[xptSpeed];
 
-  // assemble HTTP header
-  snprintf(buffer, length, "GET /%s %s", uri, HTTP_VERSION);
-  str += buffer;
-  log_d("%s:%d %s", ip.toString().c_str(), port, buffer);
-  str += "\r\n";
-  snprintf(buffer, length, HEADER_HOST, ip.toString().c_str(), port);
-  str += buffer;
-  str += HEADER_CONNECTION_CLOSE;
-  str += HEADER_USER_AGENT;
-  str += HEADER_EMPTY_LINE;           // empty line marks end of HTTP header
-
-  sendRequest(str);
-  bool ret = waitForResponse();
-  free(buffer);
-  return ret;
+  return true;
 }
 
-bool SoapESP32::soapTransportActionPost(const IPAddress ip, 
-                               const uint16_t port, 
-                               const char *uri,
-                               transportAction_et action) 
+//
+// renderer: set master volume (0..100)
+//
+bool SoapESP32::setVolume(uint8_t srv, uint8_t volume)
 {
-  if (!connectToServer(ip, port)) {
-    return false;
-  }
-  
-  uint16_t messageLength;
-  char buffer[200];
-  char index[12], count[6];
-  String str((char *)0);
+  char args[SOAP_ARGS_BUF_SIZE];
 
-  // calculate XML message length
-  messageLength = sizeof(SOAP_ENVELOPE_START) - 1;
-  messageLength += sizeof(SOAP_BODY_START) - 1;
-   
-  switch (action) {
-    case PLAY: messageLength += sizeof(SOAP_PLAY) - 1; break;
-    case STOP: messageLength += sizeof(SOAP_STOP) - 1; break;
-    case PAUSE: messageLength += sizeof(SOAP_PAUSE) - 1; break;
-  }
-  
-  messageLength += sizeof(SOAP_BODY_END) - 1;
-  messageLength += sizeof(SOAP_ENVELOPE_END) - 1;
+  snprintf(args, sizeof(args), SOAP_ARGS_SET_VOLUME, volume > 100 ? 100 : volume);
 
-  // assemble HTTP header
-  snprintf(buffer, sizeof(buffer), "POST /%s %s", uri, HTTP_VERSION);
-  str += buffer;
-  log_d("%s:%d %s", ip.toString().c_str(), port, buffer);
-  str += "\r\n";
-  snprintf(buffer, sizeof(buffer), HEADER_HOST, ip.toString().c_str(), port); // 29 bytes max
-  str += buffer;
-  // TEST
-  str += "CACHE-CONTROL: no-cache\r\nPRAGMA: no-cache\r\n";
-  //str += "FRIENDLYNAME.DLNA.ORG: ESP32-Radio\r\n";
-  //
-  str += HEADER_CONNECTION_CLOSE;
-  snprintf(buffer, sizeof(buffer), HEADER_CONTENT_LENGTH_D, messageLength);
-  str += buffer;
-  str += HEADER_CONTENT_TYPE;
-  switch (action) {
-    case PLAY: str += HEADER_SOAP_ACTION_PLAY; break;
-    case STOP: str += HEADER_SOAP_ACTION_STOP; break;
-    case PAUSE: str += HEADER_SOAP_ACTION_PAUSE; break;
-  }
-  str += HEADER_USER_AGENT;
-  str += HEADER_EMPTY_LINE;                    // empty line marks end of HTTP header !
-
-  // assemble SOAP message (multiple str+= instead of a single str+=..+..+.. reduces allocations)
-  str += SOAP_ENVELOPE_START;
-  str += SOAP_BODY_START;
-  switch (action) {
-    case PLAY: str += SOAP_PLAY; break;
-    case STOP: str += SOAP_STOP; break;
-    case PAUSE: str += SOAP_PAUSE; break;
-  }
-  str += SOAP_BODY_END;
-  str += SOAP_ENVELOPE_END;
-
-  sendRequest(str);
-  return waitForResponse();
+  return soapControlRequest(srv, true, "SetVolume", args);
 }
-                                 
+
 //
-// HTTP POST request    
+// helper function: send action to renderer's AVTransport or RenderingControl (rendering = true) 
+// service. Request gets assembled from templates (content length computed up front). 
+// Optional reply values: element content of paths[i] goes into values[i]
 //
-bool SoapESP32::soapBrowsePost(const IPAddress ip, 
-                               const uint16_t port, 
-                               const char *uri, 
-                               const char *objectId, 
-                               const uint32_t startingIndex, 
-                               const uint16_t maxCount)
+bool SoapESP32::soapControlRequest(const uint8_t srv, const bool rendering, const char *action, const char *args,
+                                   const xPathParser_t *paths, const uint8_t num, String *values, 
+                                   const char *const *escaped)
 {
-  connectToServer(ip, port);
+  IPAddress ip;
+  uint16_t port = 0;
+  char url[SSDP_CONTROL_URL_BUF_SIZE] = "";
+  uint64_t contentSize;
+  bool chunked = false, start;
+  String result((char *)0);
+  MiniXPathMulti xPath;
+
+  // no copy of server entry (Strings), requests without reply values don't touch the heap
+  const char *urn = rendering ? UPNP_URN_SCHEMA_RENDERING_CONTROL : UPNP_URN_SCHEMA_AV_TRANSPORT;
+  claimServerList();
+  if (srv < m_server.size()) {
+    const String &controlURL = rendering ? m_server[srv].renderingControlURL : m_server[srv].controlURL;
+    ip = m_server[srv].ip;
+    port = m_server[srv].port;
+    if (controlURL.length() < sizeof(url)) strcpy(url, controlURL.c_str());
+  }
+  releaseServerList();
+  if (!port) {
+    log_e("invalid renderer: %d", srv);
+    return false;
+  }
+  if (!*url) {
+    log_e("renderer %d doesn't offer service %s (or URL too long)", srv, urn);
+    return false;
+  }
 
-  uint16_t messageLength;
-  char buffer[200];
-  char index[12], count[6];
-  String str((char *)0);
+  if (!connectToServer(ip, port)) return false;
 
-  itoa(startingIndex, index, 10);
-  itoa(maxCount, count, 10);
-  // calculate XML message length
-  messageLength = sizeof(SOAP_ENVELOPE_START) - 1;
-  messageLength += sizeof(SOAP_BODY_START) - 1;
-  messageLength += sizeof(SOAP_BROWSE_START) - 1;
-  messageLength += sizeof(SOAP_OBJECTID_START) - 1 + strlen(objectId) + sizeof(SOAP_OBJECTID_END) - 1;
-  messageLength += sizeof(SOAP_BROWSEFLAG_START) - 1 + sizeof(SOAP_DEFAULT_BROWSE_FLAG) - 1 + sizeof(SOAP_BROWSEFLAG_END) - 1;
-  messageLength += sizeof(SOAP_FILTER_START) - 1 + sizeof(SOAP_DEFAULT_BROWSE_FILTER) - 1 + sizeof(SOAP_FILTER_END) - 1;
-  messageLength += sizeof(SOAP_STARTINGINDEX_START) - 1 + strlen(index) + sizeof(SOAP_STARTINGINDEX_END) - 1;
-  messageLength += sizeof(SOAP_REQUESTEDCOUNT_START) - 1 + strlen(count) + sizeof(SOAP_REQUESTEDCOUNT_END) - 1;
-  messageLength += sizeof(SOAP_SORTCRITERIA_START) - 1 + sizeof(SOAP_DEFAULT_BROWSE_SORT_CRITERIA) - 1 + sizeof(SOAP_SORTCRITERIA_END) - 1;
-  messageLength += sizeof(SOAP_BROWSE_END) - 1;
-  messageLength += sizeof(SOAP_BODY_END) - 1;
-  messageLength += sizeof(SOAP_ENVELOPE_END) - 1;
+  // escaped (optional): args is a template, each "%s" gets replaced by next string (XML escaped)
+  size_t argsLength = strlen(args);
+  if (escaped) {
+    int k = 0;
+    for (const char *p = args; (p = strstr(p, "%s")); p += 2) {
+      argsLength += soapXmlEscapedLength(escaped[k++]) - 2;
+    }
+  }
+  size_t bodyLength = SOAP_CONTROL_BODY_FIXED + 2 * strlen(action) + strlen(urn) + argsLength;
+  log_d("renderer action: %s", action);
+  soapTxBegin("POST", ip, port, url);
+  soapTxAdd(m_keepAlive ? HEADER_CONNECTION_KEEP_ALIVE : HEADER_CONNECTION_CLOSE);
+  soapTxPrintf(HEADER_CONTENT_LENGTH_D, (int)bodyLength);
+  soapTxAdd(HEADER_CONTENT_TYPE);
+  soapTxPrintf(SOAP_CONTROL_HEADER, urn, action);
+  soapTxAdd(HEADER_USER_AGENT HEADER_EMPTY_LINE);
+  soapTxAdd(SOAP_ENVELOPE_START SOAP_BODY_START);
+  soapTxPrintf(SOAP_CONTROL_ACTION_START, action, urn);
+  if (escaped) {
+    const char *p = args, *q;
+    for (int k = 0; (q = strstr(p, "%s")); p = q + 2) {
+      soapTxAdd(p, q - p);
+      soapTxAddEscaped(escaped[k++]);
+    }
+    soapTxAdd(p);
+  }
+  else {
+    soapTxAdd(args, argsLength);
+  }
+  soapTxPrintf(SOAP_CONTROL_ACTION_END, action);
+  soapTxAdd(SOAP_BODY_END SOAP_ENVELOPE_END);
+  if (!soapTxSend(ip, port)) return false;
+
+  // reply: 200 OK, errors come as 500 with UPnP error code
+  bool ok = soapReadHttpHeader(&contentSize, &chunked);
+  bool ret = (m_httpStatus == HTTP_STATUS_OK);
+  if (!ret) log_e("renderer %d refused action %s", srv, action);
+  if (ret && ok && paths) {
+    xPath.setPaths(paths, num);
+    while (true) {
+      int c = soapReadXML(chunked);
+      if (c < 0) break;
+      int path = xPath.getValue((char)c, &result, NULL, &start);
+      if (path != XPATH_MULTI_NO_MATCH && !start) values[path] = result;
+    }
+  }
+  soapFinishResponse(chunked, ok);
 
-  // assemble HTTP header
-  snprintf(buffer, sizeof(buffer), "POST /%s %s", uri, HTTP_VERSION);
-  str += buffer;
-  log_d("%s:%d %s", ip.toString().c_str(), port, buffer);
-  str += "\r\n";
-  snprintf(buffer, sizeof(buffer), HEADER_HOST, ip.toString().c_str(), port); // 29 bytes max
-  str += buffer;
-  // TEST
-  str += "CACHE-CONTROL: no-cache\r\nPRAGMA: no-cache\r\n";
-  //str += "FRIENDLYNAME.DLNA.ORG: ESP32-Radio\r\n";
-  //
-  str += HEADER_CONNECTION_CLOSE;
-  snprintf(buffer, sizeof(buffer), HEADER_CONTENT_LENGTH_D, messageLength);
-  str += buffer;
-  str += HEADER_CONTENT_TYPE;
-  str += HEADER_SOAP_ACTION_BROWSE;
-  str += HEADER_USER_AGENT;
-  str += HEADER_EMPTY_LINE;                    // empty line marks end of HTTP header !
-
-  // assemble SOAP message (multiple str+= instead of a single str+=..+..+.. reduces allocations)
-  str += SOAP_ENVELOPE_START;
-  str += SOAP_BODY_START;
-  str += SOAP_BROWSE_START;
-  str += SOAP_OBJECTID_START;
-  str += objectId;
-  str += SOAP_OBJECTID_END;
-  str += SOAP_BROWSEFLAG_START;
-  str += SOAP_DEFAULT_BROWSE_FLAG;
-  str += SOAP_BROWSEFLAG_END;
-  str += SOAP_FILTER_START;
-  str += SOAP_DEFAULT_BROWSE_FILTER;
-  str += SOAP_FILTER_END;
-  str += SOAP_STARTINGINDEX_START;
-  str += index;
-  str += SOAP_STARTINGINDEX_END;
-  str += SOAP_REQUESTEDCOUNT_START;
-  str += count;
-  str += SOAP_REQUESTEDCOUNT_END;
-  str += SOAP_SORTCRITERIA_START;
-  str += SOAP_DEFAULT_BROWSE_SORT_CRITERIA;
-  str += SOAP_SORTCRITERIA_END;
-  str += SOAP_BROWSE_END;
-  str += SOAP_BODY_END;
-  str += SOAP_ENVELOPE_END;
-
-  sendRequest(str);
-  return waitForResponse();  
+  return ret;
 }
+#endif
+
+
 
 //
-// returns number of usable media servers in our list
+// arena based result list: objects keep offsets into a single string arena
 //
-uint8_t SoapESP32::getServerCount(void)
+SoapObjectArena::SoapObjectArena()
+  : m_arena(NULL), m_size(0), m_used(0), m_oom(false)
 {
-  return m_server.size();
 }
 
-//
-// returns infos about a media servers from our internal list
-//
-bool SoapESP32::getServerInfo(uint8_t srv, soapServer_t *serverInfo)
+SoapObjectArena::~SoapObjectArena()
+{
+  free(m_arena);
+}
+
+void SoapObjectArena::clear()
 {
-  if (srv >= m_server.size()) return false;
-  *serverInfo = m_server[srv];
+  m_objects.clear();
+  m_used = m_arena ? 1 : 0;
+  m_oom = false;
+}
 
-  return true;
+void SoapObjectArena::release()
+{
+  std::vector<soapArenaObject_t>().swap(m_objects);
+  free(m_arena);
+  m_arena = NULL;
+  m_size = m_used = 0;
+  m_oom = false;
 }
 
-//
-// returns number of available/remaining bytes
-//
-size_t SoapESP32::available()
+bool SoapObjectArena::reserve(size_t objects, size_t bytes)
 {
-  return m_clientDataConOpen ? m_clientDataAvailable : 0;
+  m_objects.reserve(objects);
+
+  return bytes <= m_size || grow(bytes);
 }
 
 //
-// returns pointer to string (item type name)
+// objects only keep offsets, so the arena may move when being reallocated
 //
-const char *SoapESP32::getFileTypeName(eFileType fileType)
+void SoapObjectArena::shrink()
 {
-  return (fileTypeAudio <= fileType && fileType <= fileTypeVideo) ? fileTypes[fileType] : fileTypes[fileTypeOther];
+  if (m_objects.capacity() > m_objects.size()) m_objects.shrink_to_fit();
+  if (m_arena && m_used < m_size) {
+    char *p = (char *)realloc(m_arena, m_used);
+    if (p) {
+      m_arena = p;
+      m_size = m_used;
+    }
+  }
 }
 
-bool SoapESP32::isPlaying(void) 
+bool SoapObjectArena::grow(size_t bytes)
 {
-  return false;
-}
+  char *p = (char *)realloc(m_arena, bytes);
+  if (!p) {
+    log_e("realloc() couldn't allocate %d bytes", bytes);
+    m_oom = true;
+    return false;
+  }
+  if (!m_arena) {
+    p[0] = 0;           // offset 0: empty string
+    m_used = 1;
+  }
+  m_arena = p;
+  m_size = bytes;
 
-void SoapESP32::play(void) 
-{
-  soapTransportActionPost(m_server[0].ip, m_server[0].port, m_server[0].controlURL.c_str(), PLAY);
+  return true;
 }
 
-void SoapESP32::stop(void)
+uint32_t SoapObjectArena::addString(const String &str)
 {
-  soapTransportActionPost(m_server[0].ip, m_server[0].port, m_server[0].controlURL.c_str(), STOP);
+  size_t len = str.length();
+  if (len == 0) return 0;
+
+  uint32_t offset = m_used;
+  memcpy(m_arena + m_used, str.c_str(), len + 1);
+  m_used += len + 1;
+
+  return offset;
 }
 
-void SoapESP32::pause(void) 
+//
+// copy object into list, arena grows (at least doubles) if strings don't fit
+//
+bool SoapObjectArena::add(const soapObject_t *object)
 {
-  soapTransportActionPost(m_server[0].ip, m_server[0].port, m_server[0].controlURL.c_str(), PAUSE);
+  // 8 terminating zeros + empty string of a new arena
+  size_t need = 9 + object->parentId.length() + object->id.length() + object->name.length() + object->artist.length() +
+                object->album.length() + object->uri.length() + object->albumArtUri.length() + object->iconUri.length();
+  if (m_used + need > m_size && !grow((m_used + need > 2 * m_size) ? m_used + need : 2 * m_size)) return false;
+
+  soapArenaObject_t obj = { .isDirectory = object->isDirectory, .size = object->size, .sizeMissing = object->sizeMissing,
+                            .bitrate = object->bitrate, .sampleFrequency = object->sampleFrequency, 
+                            .searchable = object->searchable, .fileType = object->fileType,
+                            .downloadIp = object->downloadIp, .downloadPort = object->downloadPort,
+                            .parentId = addString(object->parentId), .id = addString(object->id), 
+                            .name = addString(object->name), .artist = addString(object->artist), 
+                            .album = addString(object->album), .uri = addString(object->uri), 
+                            .albumArtUri = addString(object->albumArtUri), .iconUri = addString(object->iconUri) };
+  m_objects.push_back(obj);
+
+  return true;
 }
 
+bool SoapObjectArena::get(size_t i, soapObject_t *object) const
+{
+  if (i >= m_objects.size() || !object) return false;
+
+  const soapArenaObject_t &obj = m_objects[i];
+  object->isDirectory = obj.isDirectory;
+  object->size = obj.size;
+  object->sizeMissing = obj.sizeMissing;
+  object->bitrate = obj.bitrate;
+  object->sampleFrequency = obj.sampleFrequency;
+  object->searchable = obj.searchable;
+  object->fileType = obj.fileType;
+  object->parentId = str(obj.parentId);
+  object->id = str(obj.id);
+  object->name = str(obj.name);
+  object->artist = str(obj.artist);
+  object->album = str(obj.album);
+  object->uri = str(obj.uri);
+  object->downloadIp = obj.downloadIp;
+  object->downloadPort = obj.downloadPort;
+  object->albumArtUri = str(obj.albumArtUri);
+  object->iconUri = str(obj.iconUri);
 
+  return true;
+}
@@ -28,6 +28,8 @@
 
 #include <Arduino.h>
 #include <vector>
+#include <list>
+#include "SoapRingBuffer.h"
 
 // Please uncomment if you use an Ethernet board/shield instead of builtin WiFi 
 //#define USE_ETHERNET
@@ -45,18 +47,92 @@
 #define TMP_BUFFER_SIZE_200         200
 #define TMP_BUFFER_SIZE_400         400
 #define TMP_BUFFER_SIZE_1000       1000
+#define SOAP_URL_HOST_BUF_SIZE       64   // host part of URLs handed over to readStart()
+
+// size of internal receive buffer, filled with bulk reads from client (fewer SPI transactions with Ethernet)
+// requests get assembled in the same buffer before a reply is expected, longer ones are sent in pieces
+#ifndef SOAP_RX_BUFFER_SIZE
+#define SOAP_RX_BUFFER_SIZE        1024
+#endif
 
 // network communication timeouts
+#define SERVER_CONNECT_TIMEOUT     3000   // ms, per connection attempt
 #define SERVER_RESPONSE_TIMEOUT    3000   // ms
 #define SERVER_READ_TIMEOUT        3000   // ms
 
+// reader task, delivers downloaded data into ring buffer or Print sink
+#define SOAP_READ_TASK_STACK       4096
+#define SOAP_READ_TASK_PRIO        2
+#define SOAP_READ_TASK_IDLE_DELAY  5      // ms, pause when ring buffer reached high watermark or sink is busy
+
+// request task, runs async requests (seekServerAsync(), browseServerAsync()...)
+#define SOAP_ASYNC_TASK_STACK      8192
+#define SOAP_ASYNC_TASK_PRIO       1
+
+// fetching device descriptions while seeking servers
+#define SOAP_DISCOVERY_DEADLINE    5000   // ms, max. time spent on a single server
+#ifndef SOAP_DISCOVERY_MAX_WORKERS
+#define SOAP_DISCOVERY_MAX_WORKERS 4      // max. nr of concurrent worker tasks (each with own client)
+#endif
+#define SOAP_DISCOVERY_TASK_STACK  6144
+#define SOAP_DISCOVERY_TASK_PRIO   1
+
+// replicas & merged browsing: failed server is avoided for a while, merged browse runs 
+// one worker task per server (each with a session)
+#define SOAP_REPLICA_RETRY_AFTER   30000  // ms
+#ifndef SOAP_MERGE_MAX_WORKERS
+#define SOAP_MERGE_MAX_WORKERS     4
+#endif
+#define SOAP_MERGE_TASK_STACK      8192
+#define SOAP_MERGE_TASK_PRIO       1
+
+// waking up a server with WOL and waiting until it answers
+#define SOAP_WAKE_UP_TIMEOUT       60000  // ms, default max. wait
+#define SOAP_WAKE_UP_PROBE_PERIOD  1000   // ms, server gets probed this often
+#define SOAP_WAKE_UP_RESEND        10000  // ms, WOL packets are repeated after that time
+
+// server list saved in NVS (Preferences), keys with server index
+#define SOAP_NVS_NAMESPACE         "soapesp32"
+#define SOAP_NVS_PROBE_TIMEOUT     500    // ms, connection attempt of seekServerCached() per restored server
+#define SOAP_NVS_KEY_COUNT         "count"
+#define SOAP_NVS_KEY_CLASS         "class"
+#define SOAP_NVS_KEY_IP            "ip%d"
+#define SOAP_NVS_KEY_PORT          "port%d"
+#define SOAP_NVS_KEY_LOCATION      "loc%d"
+#define SOAP_NVS_KEY_NAME          "name%d"
+#define SOAP_NVS_KEY_CONTROL_URL   "url%d"
+#define SOAP_NVS_KEY_UUID          "uuid%d"
+#define SOAP_NVS_KEY_EVENT_URL     "evt%d"
+#define SOAP_NVS_KEY_RENDERING_URL "rc%d"
+
 // SSDP UDP - seeking media servers
 #define SSDP_MULTICAST_IP          239,255,255,250
 #define SSDP_MULTICAST_PORT        1900
 #define SSDP_MAX_REPLY_TIMEOUT     4000   // ms
-#define SSDP_LOCATION_BUF_SIZE      150
+#ifndef SSDP_LOCATION_BUF_SIZE
+#define SSDP_LOCATION_BUF_SIZE      150   // path of device description
+#endif
 #define SSDP_CONTROL_URL_BUF_SIZE   200
-#define SSDP_TMP_BUFFER_SIZE        500
+#ifndef SSDP_TMP_BUFFER_SIZE
+#define SSDP_TMP_BUFFER_SIZE        500   // single SSDP reply (stack), longer ones get truncated
+#endif
+#define SSDP_UUID_BUF_SIZE           64
+#define SSDP_POLL_INTERVAL           10   // ms
+#define SSDP_MONITOR_POLL_INTERVAL   50   // ms
+#define SOAP_MONITOR_TASK_STACK    6144
+#define SOAP_MONITOR_TASK_PRIO        1
+
+// GENA eventing: event subscriptions & NOTIFY listener
+#define SOAP_EVENT_PORT           49152   // default port of NOTIFY listener
+#define SOAP_EVENT_PATH           "event" // path of callback URL
+#define SOAP_EVENT_TIMEOUT         1800   // s, requested subscription duration
+#define SOAP_EVENT_RENEW_MARGIN      60   // s, subscriptions get renewed this long before they expire
+#define SOAP_EVENT_RETRY_INTERVAL    30   // s, next attempt after failed renewal
+#define SOAP_EVENT_MAX_BODY        8192   // bytes, bigger NOTIFY messages get rejected
+#define SOAP_EVENT_MAX_PENDING       16   // cache invalidations waiting for next cache access
+#define SOAP_EVENT_POLL_INTERVAL     20   // ms
+#define SOAP_EVENT_TASK_STACK      6144
+#define SOAP_EVENT_TASK_PRIO          1
 
 #define SSDP_LOCATION              "Location: http://"
 #define SSDP_SERVICE_TYPE_DMS      "ST: urn:schemas-upnp-org:device:MediaServer:1"
@@ -65,6 +141,8 @@
 #define SSDP_NOTIFICATION_TYPE_DMS "NT: urn:schemas-upnp-org:device:MediaServer:1"
 #define SSDP_NOTIFICATION_TYPE_DMR "NT: urn:schemas-upnp-org:device:MediaRenderer:1"
 #define SSDP_NOTIFICATION_SUB_TYPE "NTS: ssdp:alive"
+#define SSDP_NOTIFICATION_SUB_TYPE_BYEBYE "NTS: ssdp:byebye"
+#define SSDP_USN                   "USN: uuid:"
 
 #define SSDP_DMR_SERVICE_TYPE      "ST: urn:schemas-upnp-org:device:MediaServer:1"
 
@@ -77,21 +155,38 @@
 // HTTP header lines
 #define HTTP_VERSION                 "HTTP/1.1"
 #define HTTP_HEADER_200_OK           "HTTP/1.1 200 OK"
+#define HTTP_STATUS_OK               200
+#define HTTP_STATUS_PARTIAL_CONTENT  206
+#define HTTP_STATUS_BAD_REQUEST      400
+#define HTTP_STATUS_PRECONDITION_FAILED 412
+#define HTTP_STATUS_SERVICE_UNAVAILABLE 503
+#define HTTP_REPLY_NOTIFY            "HTTP/1.1 %d %s\r\nContent-Length: 0\r\nConnection: close\r\n\r\n"
 #define HEADER_CONTENT_LENGTH        "Content-Length: "
-#define HEADER_HOST                  "Host: %s:%d\r\n"
+#define HEADER_HOST                  "Host: %d.%d.%d.%d:%d\r\n"
 #define HEADER_CONTENT_TYPE          "Content-Type: text/xml; charset=\"utf-8\"\r\n"
 #define HEADER_TRANS_ENC_CHUNKED     "Transfer-Encoding: chunked"
+#define HEADER_CONTENT_ENCODING_GZIP "Content-Encoding: gzip"
+#define HEADER_ACCEPT_ENCODING_GZIP  "Accept-Encoding: gzip\r\n"
+#define HEADER_CONNECTION            "Connection: "
+#define HEADER_CONTENT_RANGE         "Content-Range: bytes "
+#define HEADER_RANGE                 "Range: bytes=%llu-"
 #define HEADER_CONTENT_LENGTH_D      "Content-Length: %d\r\n"
+#define HEADER_SID                   "SID: "
+#define HEADER_SEQ                   "SEQ: "
+#define HEADER_TIMEOUT               "TIMEOUT: Second-"
+#define HEADER_TIMEOUT_D             "TIMEOUT: Second-%u\r\n"
+#define HEADER_CALLBACK              "CALLBACK: <http://%d.%d.%d.%d:%d/%s>\r\n"
+#define HEADER_NT_EVENT              "NT: upnp:event\r\n"
 
 #define HEADER_SOAP_ACTION_BROWSE    "SOAPAction: \"urn:schemas-upnp-org:service:ContentDirectory:1#Browse\"\r\n"
-#define HEADER_SOAP_ACTION_SetAVTransportURI  "SOAPAction: \"urn:schemas-upnp-org:service:AVTransport:1#SetAVTransportURI\"\r\n"                                   
-#define HEADER_SOAP_ACTION_PLAY      "SOAPAction: \"urn:schemas-upnp-org:service:AVTransport:1#Play\"\r\n"
-#define HEADER_SOAP_ACTION_PAUSE     "SOAPAction: \"urn:schemas-upnp-org:service:AVTransport:1#Pause\"\r\n"
-#define HEADER_SOAP_ACTION_STOP      "SOAPAction: \"urn:schemas-upnp-org:service:AVTransport:1#Stop\"\r\n"
+#define HEADER_SOAP_ACTION_GET_SYSTEM_UPDATE_ID "SOAPAction: \"urn:schemas-upnp-org:service:ContentDirectory:1#GetSystemUpdateID\"\r\n"
+#define HEADER_SOAP_ACTION_SEARCH    "SOAPAction: \"urn:schemas-upnp-org:service:ContentDirectory:1#Search\"\r\n"
+#define HEADER_SOAP_ACTION_GET_SEARCH_CAPABILITIES "SOAPAction: \"urn:schemas-upnp-org:service:ContentDirectory:1#GetSearchCapabilities\"\r\n"
 
 #define HEADER_USER_AGENT            "User-Agent: ESP32/Player/UPNP1.0\r\n"
 #define HEADER_CONNECTION_CLOSE      "Connection: close\r\n"
 #define HEADER_CONNECTION_KEEP_ALIVE "Connection: keep-alive\r\n"
+#define HEADER_NO_CACHE              "CACHE-CONTROL: no-cache\r\nPRAGMA: no-cache\r\n"
 #define HEADER_EMPTY_LINE            "\r\n"
 
 // SOAP tag data
@@ -115,19 +210,37 @@
 #define SOAP_REQUESTEDCOUNT_END   "</RequestedCount>\r\n"
 #define SOAP_SORTCRITERIA_START   "<SortCriteria>"
 #define SOAP_SORTCRITERIA_END     "</SortCriteria>\r\n"
-
-//#define SOAP_SETAVTRANSPORTURI_START  "<u:SetAVTransportURI xmlns:u=\"urn:schemas-upnp-org:service:AVTransport:1\">\r\n<InstanceID>0</InstanceID>\r\n<CurrentURI>http://192.168.12.222:32469/object/51a05d70ebb2ea7ee918/file.flac</CurrentURI>
-//#define SOAP_SETAVTRANSPORTURI_END "</u:SetAVTransportURI>"
-
-#define SOAP_PLAY                 "<u:Play xmlns:u=\"urn:schemas-upnp-org:service:AVTransport:1\">\r\n<InstanceID>0</InstanceID>\r\n<Speed>1</Speed>\r\n</u:Play>\r\n"
-#define SOAP_PAUSE                "<u:Pause xmlns:u=\"urn:schemas-upnp-org:service:AVTransport:1\">\r\n<InstanceID>0</InstanceID>\r\n</u:Play>\r\n"
-#define SOAP_STOP                 "<u:Stop xmlns:u=\"urn:schemas-upnp-org:service:AVTransport:1\">\r\n<InstanceID>0</InstanceID>\r\n</u:Stop>\r\n"
+#define SOAP_SEARCH_START         "<u:Search xmlns:u=\"urn:schemas-upnp-org:service:ContentDirectory:1\">\r\n"
+#define SOAP_SEARCH_END           "</u:Search>\r\n"
+#define SOAP_CONTAINERID_START    "<ContainerID>"
+#define SOAP_CONTAINERID_END      "</ContainerID>\r\n"
+#define SOAP_SEARCHCRITERIA_START "<SearchCriteria>"
+#define SOAP_SEARCHCRITERIA_END   "</SearchCriteria>\r\n"
+
+#define SOAP_GET_SYSTEM_UPDATE_ID "<u:GetSystemUpdateID xmlns:u=\"urn:schemas-upnp-org:service:ContentDirectory:1\"></u:GetSystemUpdateID>\r\n"
+#define SOAP_GET_SEARCH_CAPABILITIES "<u:GetSearchCapabilities xmlns:u=\"urn:schemas-upnp-org:service:ContentDirectory:1\"></u:GetSearchCapabilities>\r\n"
+
+// renderer control (AVTransport/RenderingControl) request templates
+// header: service URN, action
+#define SOAP_CONTROL_HEADER       "SOAPAction: \"%s#%s\"\r\n"
+// body: action & service URN, action arguments, action
+#define SOAP_CONTROL_ACTION_START "<u:%s xmlns:u=\"%s\"><InstanceID>0</InstanceID>"
+#define SOAP_CONTROL_ACTION_END   "</u:%s>"
+#define SOAP_CONTROL_BODY         SOAP_ENVELOPE_START SOAP_BODY_START SOAP_CONTROL_ACTION_START SOAP_CONTROL_ACTION_END \
+                                  SOAP_BODY_END SOAP_ENVELOPE_END
+#define SOAP_CONTROL_BODY_FIXED   (sizeof(SOAP_CONTROL_BODY) - 1 - 3 * 2)   // without the three "%s"
+#define SOAP_ARGS_SET_URI         "<CurrentURI>%s</CurrentURI><CurrentURIMetaData>%s</CurrentURIMetaData>"
+#define SOAP_ARGS_PLAY            "<Speed>1</Speed>"
+#define SOAP_ARGS_SEEK            "<Unit>REL_TIME</Unit><Target>%u:%02u:%02u</Target>"
+#define SOAP_ARGS_SET_VOLUME      "<Channel>Master</Channel><DesiredVolume>%u</DesiredVolume>"
+#define SOAP_ARGS_BUF_SIZE        60
 
 
 // UPnP service data
 #define UPNP_URN_SCHEMA                   "schemas-upnp-org:service:"
 #define UPNP_URN_SCHEMA_CONTENT_DIRECTORY "urn:schemas-upnp-org:service:ContentDirectory:1"
 #define UPNP_URN_SCHEMA_AV_TRANSPORT      "urn:schemas-upnp-org:service:AVTransport:1"
+#define UPNP_URN_SCHEMA_RENDERING_CONTROL "urn:schemas-upnp-org:service:RenderingControl:1"
 
 // SOAP default browse parameters
 #define SOAP_DEFAULT_BROWSE_FLAG           "BrowseDirectChildren"
@@ -135,6 +248,39 @@
 #define SOAP_DEFAULT_BROWSE_STARTING_INDEX 0
 #define SOAP_DEFAULT_BROWSE_MAX_COUNT      100     // arbitrary value to limit memory usage
 #define SOAP_DEFAULT_BROWSE_SORT_CRITERIA  ""
+#define SOAP_BROWSE_FILTER_BUF_SIZE        200
+#define SOAP_BROWSE_YIELD_OBJECTS          16      // parser lets other tasks run after this many objects
+#define SOAP_SEARCH_ALL                    "*"     // search criteria matching all objects
+#ifndef SOAP_SEARCH_WALK_MAX_CONTAINERS
+#define SOAP_SEARCH_WALK_MAX_CONTAINERS    500     // limits directories browsed by client side search
+#endif
+#define SOAP_ARENA_BYTES_PER_OBJECT        96      // initial arena size estimate for arena based result lists
+
+// directory cache (browse results), default memory budgets in bytes
+#ifndef SOAP_CACHE_BUDGET
+#define SOAP_CACHE_BUDGET                  16384
+#endif
+#ifndef SOAP_CACHE_BUDGET_PSRAM
+#define SOAP_CACHE_BUDGET_PSRAM           262144
+#endif
+
+// selectable object fields when browsing (id, parent id & title are always scanned),
+// unselected fields are neither requested from server (filter) nor scanned
+#define SOAP_FIELD_URI                     0x0001   // item uri, download ip & port
+#define SOAP_FIELD_SIZE                    0x0002   // item size
+#define SOAP_FIELD_CLASS                   0x0004   // item file type
+#define SOAP_FIELD_ALBUM                   0x0008
+#define SOAP_FIELD_ARTIST                  0x0010
+#define SOAP_FIELD_ALBUM_ART_URI           0x0020
+#define SOAP_FIELD_ICON_URI                0x0040
+#define SOAP_FIELD_BITRATE                 0x0080
+#define SOAP_FIELD_SAMPLE_FREQUENCY        0x0100
+#define SOAP_FIELD_CHILD_COUNT             0x0200   // container child count (stored in size)
+#define SOAP_FIELD_SEARCHABLE              0x0400
+#define SOAP_FIELD_ALL                     0x07FF
+#define SOAP_FIELD_RESOURCES               0x0800   // list of all <res> of an item (soapObject_t::resources), not in SOAP_FIELD_ALL
+#define SOAP_FIELD_RES                     (SOAP_FIELD_URI | SOAP_FIELD_SIZE | SOAP_FIELD_BITRATE | SOAP_FIELD_SAMPLE_FREQUENCY)
+#define SOAP_FIELD_COMPACT                 (SOAP_FIELD_URI | SOAP_FIELD_SIZE | SOAP_FIELD_CLASS | SOAP_FIELD_CHILD_COUNT)
  
 // selected DIDL attributes for scanning
 #define DIDL_ATTR_ID           "id="
@@ -144,18 +290,28 @@
 #define DIDL_ATTR_SIZE         "size="
 #define DIDL_ATTR_BITRATE      "bitrate="
 #define DIDL_ATTR_SAMPLEFREQU  "sampleFrequency="
+#define DIDL_ATTR_PROTOCOL_INFO "protocolInfo="
 
-// for replacing predefined XML entities in server reply
-enum eXmlReplaceState { xmlPassthrough = 0, xmlAmpDetected, xmlTakeFromBuffer };
-struct replaceWith_t 
-{
-  const char *replace;
-  const char with;
-};
+// for replacing XML entities in server reply
+enum eXmlReplaceState { xmlPassthrough = 0, xmlTakeFromBuffer };
 
 // defines the data content of a reported item (file/stream)
 enum eFileType { fileTypeOther = 0, fileTypeAudio, fileTypeImage, fileTypeVideo };
 
+// single <res> element of an item, one of them gets selected into soapObject_t (see setResourcePolicy())
+struct soapResource_t
+{
+  String protocolInfo;      // e.g. "http-get:*:audio/mpeg:DLNA.ORG_PN=MP3"
+  String uri;               // URI on server without "http://ip:port/"
+  IPAddress downloadIp;
+  uint16_t downloadPort;
+  uint64_t size;
+  bool sizeMissing;
+  int  bitrate;             // as reported (UPnP: bytes/s, some servers: bits/s), 0: missing
+  int  sampleFrequency;
+};
+typedef std::vector<soapResource_t> soapResourceVect_t;
+
 // info collection of a single SOAP object (<container> or <item>) 
 struct soapObject_t
 {
@@ -176,10 +332,134 @@ struct soapObject_t
   uint16_t downloadPort;    // download port can differ from server control port
   String albumArtUri;       // item URI of Album Art image
   String iconUri;           // item URI of Icon image ( smaller version of album art )
+  soapResourceVect_t resources;   // all <res> of item, only with SOAP_FIELD_RESOURCES
 };
 typedef std::vector<soapObject_t> soapObjectVect_t;
 
+// compact version of soapObject_t, for keeping big result lists in memory (see SOAP_FIELD_COMPACT)
+struct soapObjectCompact_t
+{
+  bool isDirectory;         // true if directory
+  uint64_t size;            // directory child count or item size, zero in case of missing size/child count attribute
+  bool sizeMissing;         // true in case server did not provide size
+  eFileType fileType;       // audio, picture, movie, stream or other
+  String id;                // unique id of directory/file on media server
+  String name;              // directory name or file name
+  String uri;               // item URI on server, needed for download with GET
+  IPAddress downloadIp;     // download IP can differ from server IP
+  uint16_t downloadPort;    // download port can differ from server control port
+};
+typedef std::vector<soapObjectCompact_t> soapObjectCompactVect_t;
+
+// object of an arena based result list (see SoapObjectArena), strings are offsets into the arena
+struct soapArenaObject_t
+{
+  bool isDirectory;         // true if directory
+  uint64_t size;            // directory child count or item size, zero in case of missing size/child count attribute
+  bool sizeMissing;         // true in case server did not provide size
+  int  bitrate;             // bitrate (music files only)
+  int  sampleFrequency;     // sample frequency (music files only)
+  bool searchable;          // only used for directories, some media servers don't provide it
+  eFileType fileType;       // audio, picture, movie, stream or other
+  IPAddress downloadIp;     // download IP can differ from server IP
+  uint16_t downloadPort;    // download port can differ from server control port
+  uint32_t parentId;        // string offsets into arena, see SoapObjectArena::str()
+  uint32_t id;
+  uint32_t name;
+  uint32_t artist;
+  uint32_t album;
+  uint32_t uri;
+  uint32_t albumArtUri;
+  uint32_t iconUri;
+};
+
+// result list keeping all object strings in a single contiguous arena: no allocation per string,
+// objects vector gets reserved before browsing, dropping the result frees just these two blocks
+class SoapObjectArena {
+  public:
+    SoapObjectArena();
+    ~SoapObjectArena();
+
+    void   clear();                                // drop objects, keep memory for next result
+    void   release();                              // drop objects & free memory
+    bool   reserve(size_t objects, size_t bytes);
+    void   shrink();                               // give back unused memory after result is complete
+    size_t size() const { return m_objects.size(); }
+    size_t bytes() const { return m_used; }        // arena bytes used by strings
+    bool   outOfMemory() const { return m_oom; }   // object(s) lost since last clear(), arena couldn't grow
+    const soapArenaObject_t &operator[](size_t i) const { return m_objects[i]; }
+    const char *str(uint32_t offset) const { return m_arena ? m_arena + offset : ""; }
+    bool   add(const soapObject_t *object);
+    bool   get(size_t i, soapObject_t *object) const;   // full object, e.g. for readStart()
+
+  private:
+    SoapObjectArena(const SoapObjectArena &);            // not copyable, owns arena
+    SoapObjectArena &operator=(const SoapObjectArena &);
+    bool     grow(size_t bytes);
+    uint32_t addString(const String &str);
+
+    std::vector<soapArenaObject_t> m_objects;
+    char    *m_arena;
+    size_t   m_size;                               // arena size
+    size_t   m_used;                               // arena bytes in use, offset 0 holds the empty string
+    bool     m_oom;                                // grow() failed
+};
+
+// called for each object (<container> or <item>) as soon as it is scanned during browsing
+// return false to stop browsing early
+typedef bool (*soapBrowseCallback_t)(const soapObject_t *object, void *userData);
+
+// keeps state of paged browsing through a directory or search results (see browseBegin()/searchBegin()/browseNext())
+struct soapBrowseCursor_t
+{
+  uint8_t  srv;             // server number in list
+  String   objectId;        // directory to browse (search: container to search in)
+  String   criteria;        // search criteria, empty when browsing
+  String   sortCriteria;    // search only, e.g. "+dc:title"
+  uint16_t maxCount;        // page size
+  uint16_t fields;          // object fields to request & scan (SOAP_FIELD_...)
+  uint32_t startingIndex;   // offset of next page into directory content list
+  uint32_t totalMatches;    // number of objects in directory as reported by server, 0 = not known (yet)
+  bool     complete;        // true when all pages have been read
+  // client side search (server can't search): position of directory walk, next page continues there
+  std::vector<String> walkContainers; // directories found so far, empty: walk not started (yet)
+  uint32_t walkNext;        // directory to be scanned next
+  uint32_t walkOffset;      // objects of that directory scanned already (parser drops not counted)
+  String   walkObjectId;    // object next page starts with
+};
+
+// directory cache entry: result of a browse request
+struct soapCacheEntry_t
+{
+  IPAddress        ip;              // server
+  uint16_t         port;
+  String           objectId;        // browsed directory
+  uint32_t         startingIndex;
+  uint16_t         maxCount;
+  uint16_t         fields;
+  uint32_t         updateId;        // container UpdateID reported with browse reply
+  uint32_t         numberReturned;
+  uint32_t         totalMatches;
+  size_t           bytes;           // estimated memory usage
+  soapObjectVect_t objects;
+};
+typedef std::list<soapCacheEntry_t> soapCacheList_t;
+
+// SystemUpdateID of a server, last seen by checkBrowseCache()
+struct soapSystemUpdateId_t
+{
+  IPAddress ip;
+  uint16_t  port;
+  uint32_t  id;
+};
+
+// media server support of Search action, unknown until asked by getSearchCapabilities()/searchServer()
+#define SOAP_SEARCH_CAPS_UNKNOWN  0
+#define SOAP_SEARCH_CAPS_NONE     1     // searches get done on client side by browsing
+#define SOAP_SEARCH_CAPS_SERVER   2
+
 // keeps vital infos of each media server
+
 struct soapServer_t
 {
   IPAddress ip;
@@ -187,11 +467,95 @@ struct soapServer_t
   String location;
   String friendlyName;
   String controlURL;
+  String uuid;              // unique device name (from SSDP), empty if not known
+  String eventSubURL;       // GENA event subscription URL of service, empty if not known
+  String renderingControlURL; // renderer (DMR): control URL of RenderingControl service (volume)
+  uint8_t searchCaps = SOAP_SEARCH_CAPS_UNKNOWN; // media server (DMS): support of Search action
+  uint8_t replicaGroup = 0; // servers of same group deliver the same library (setReplicaGroup()), 0: none
+  uint32_t latency = 0;     // ms, smoothed time until browse replies start, 0: not measured yet
+  uint8_t failures = 0;     // consecutive browse/search requests that failed
+  uint32_t lastFailure = 0; // millis() of last failed request
+  bool online = true;       // false after ssdp:byebye (server monitor), until announced again
 };
 typedef std::vector<soapServer_t> soapServerVect_t;
 
+// renderer (DMR): reply to GetPositionInfo, times in s
+struct soapPositionInfo_t
+{
+  uint32_t track;
+  uint32_t duration;        // 0 if not known (e.g. streams)
+  uint32_t position;
+  String   uri;
+};
+
+// request statistics (getStats()): last request & accumulated over all requests
+struct soapStats_t
+{
+  uint32_t requests;            // requests to servers (last: 1)
+  uint32_t connectTime;         // ms connecting to server (0: connection reused)
+  uint32_t firstByteTime;       // ms from request sent to first byte of reply (incl. failed reused connection)
+  uint32_t headerTime;          // ms reading HTTP header
+  uint32_t parseTime;           // ms receiving & scanning XML content (browse, search)
+  uint64_t bytesReceived;       // bytes read from client: header & content (compressed size)
+  uint32_t chunks;              // chunks of chunked content
+  uint32_t objectsEmitted;      // objects handed over by browse/search
+  uint32_t objectsDropped;      // objects skipped (empty file, missing title/uri, parent id mismatch...)
+  uint32_t spiWaitTime;         // us waiting for SPI semaphore (Ethernet)
+};
+
+// renderer (DMR): reply to GetTransportInfo
+struct soapTransportInfo_t
+{
+  String state;             // "STOPPED", "PLAYING", "PAUSED_PLAYBACK", "TRANSITIONING", "NO_MEDIA_PRESENT"
+  String status;            // "OK" or "ERROR_OCCURRED"
+  String speed;
+};
+
+// GENA event (state variable change) delivered by NOTIFY listener
+struct soapEvent_t
+{
+  IPAddress   ip;           // server/renderer that sent the event
+  uint16_t    port;
+  String      sid;          // subscription id
+  uint32_t    seq;          // event sequence number
+  const char *name;         // state variable: "SystemUpdateID", "ContainerUpdateIDs" or "LastChange"
+  String      value;        // LastChange: XML with entities replaced
+};
+typedef void (*soapEventCallback_t)(const soapEvent_t *event, void *userData);
+
+// GENA event subscription
+struct soapSubscription_t
+{
+  IPAddress ip;
+  uint16_t  port;
+  String    eventSubURL;
+  String    sid;            // empty while subscription is pending
+  uint32_t  timeout;        // s, granted by server, 0: infinite
+  uint32_t  renewAt;        // millis() value of next renewal
+  bool      playing;        // AVTransport: TransportState reported by last LastChange event
+};
+typedef std::vector<soapSubscription_t> soapSubscriptionVect_t;
+
+// directory cache invalidation reported by event, applied with next cache access
+struct soapCacheEvent_t
+{
+  IPAddress ip;
+  uint16_t  port;
+  String    objectId;       // container (ContainerUpdateIDs), empty: SystemUpdateID
+  uint32_t  id;             // new UpdateID/SystemUpdateID
+};
+
 typedef enum {	DMS, DMP, DMR, DMC } serviceClass_et;
-typedef enum { PLAY, PAUSE, STOP, SETURI } transportAction_et;
+typedef enum { ssdpIgnored, ssdpAlive, ssdpByebye } ssdpPacket_et;
+typedef enum { readTaskIdle, readTaskRunning, readTaskDone, readTaskError } readTaskState_et;
+typedef enum { asyncIdle, asyncRunning, asyncDone, asyncError } asyncState_et;
+typedef enum { asyncSeek, asyncBrowse, asyncBrowseNext, asyncReadStart, asyncWakeUp } asyncRequest_et;
+
+// called by request task when an async request has finished, ok: result of request
+typedef void (*soapAsyncCallback_t)(bool ok, void *userData);
+
+struct xPathParser_t;   // MiniXPath.h
+struct soapInflate_t;   // gzip decoder state (SoapESP32.cpp)
 
 // SoapESP32 class
 class SoapESP32
@@ -199,32 +563,138 @@ class SoapESP32
   public:
 #ifdef USE_ETHERNET
     SoapESP32(EthernetClient *client, EthernetUDP *udp = NULL, SemaphoreHandle_t *sem = NULL);
+    SoapESP32(SoapESP32 *parent, EthernetClient *client);   // session
 #else
     SoapESP32(WiFiClient *client, WiFiUDP *udp = NULL);
+    SoapESP32(SoapESP32 *parent, WiFiClient *client);       // session
 #endif
+    ~SoapESP32();
     bool        wakeUpServer(const char *macWOL);
+    bool        wakeUpServer(const char *macWOL, uint8_t srv, uint32_t timeout = SOAP_WAKE_UP_TIMEOUT);
     void        clearServerList(void);
-    bool        addServer(IPAddress ip, uint16_t port, const char *controlURL, const char *name = "My Media Server");
-    uint8_t     seekServer(serviceClass_et serviceClass);
+    bool        addServer(IPAddress ip, uint16_t port, const char *controlURL, const char *name = "My Media Server",
+                          const char *eventSubURL = NULL);
+    uint8_t     seekServer(serviceClass_et serviceClass = DMS, uint8_t workers = 1);
+    void        setSeekLimit(uint8_t maxServers, IPAddress ip = IPAddress(), uint16_t port = 0, const char *uuid = NULL);
+    uint8_t     seekServerCached(serviceClass_et serviceClass = DMS, uint8_t workers = 1, 
+                                 const char *nvsNamespace = SOAP_NVS_NAMESPACE);
+    bool        saveServerList(const char *nvsNamespace = SOAP_NVS_NAMESPACE, serviceClass_et serviceClass = DMS);
+    uint8_t     restoreServerList(const char *nvsNamespace = SOAP_NVS_NAMESPACE, serviceClass_et serviceClass = DMS,
+                                  bool probe = true);
+    bool        startServerMonitor(serviceClass_et serviceClass = DMS);
+    void        stopServerMonitor(void);
     uint8_t     getServerCount(void);
     bool        getServerInfo(uint8_t srv, soapServer_t *serverInfo);
+    bool        setReplicaGroup(uint8_t srv, uint8_t group);
+    int         getLastServer(void);
+    bool        browseMerged(soapObjectVect_t *browseResult, std::vector<uint8_t> *servers, const char *objectId = "0",
+                             const uint16_t maxCount = SOAP_DEFAULT_BROWSE_MAX_COUNT,
+                             const uint16_t fields   = SOAP_FIELD_ALL);
     bool        browseServer(const uint8_t srv, const char *objectId, soapObjectVect_t *browseResult, 
                              const uint32_t startingIndex = SOAP_DEFAULT_BROWSE_STARTING_INDEX, 
-                             const uint16_t maxCount      = SOAP_DEFAULT_BROWSE_MAX_COUNT);
+                             const uint16_t maxCount      = SOAP_DEFAULT_BROWSE_MAX_COUNT,
+                             const uint16_t fields        = SOAP_FIELD_ALL);
+    bool        browseServer(const uint8_t srv, const char *objectId, soapObjectCompactVect_t *browseResult, 
+                             const uint32_t startingIndex = SOAP_DEFAULT_BROWSE_STARTING_INDEX, 
+                             const uint16_t maxCount      = SOAP_DEFAULT_BROWSE_MAX_COUNT,
+                             const uint16_t fields        = SOAP_FIELD_COMPACT);
+    bool        browseServer(const uint8_t srv, const char *objectId, SoapObjectArena *browseResult, 
+                             const uint32_t startingIndex = SOAP_DEFAULT_BROWSE_STARTING_INDEX, 
+                             const uint16_t maxCount      = SOAP_DEFAULT_BROWSE_MAX_COUNT,
+                             const uint16_t fields        = SOAP_FIELD_ALL);
+    bool        browseServer(const uint8_t srv, const char *objectId, soapBrowseCallback_t callback, void *userData = NULL,
+                             const uint32_t startingIndex = SOAP_DEFAULT_BROWSE_STARTING_INDEX, 
+                             const uint16_t maxCount      = SOAP_DEFAULT_BROWSE_MAX_COUNT,
+                             const uint16_t fields        = SOAP_FIELD_ALL);
+    bool        browseBegin(soapBrowseCursor_t *cursor, const uint8_t srv, const char *objectId,
+                            const uint16_t maxCount = SOAP_DEFAULT_BROWSE_MAX_COUNT,
+                            const uint16_t fields   = SOAP_FIELD_ALL);
+    bool        searchServer(const uint8_t srv, const char *containerId, const char *criteria, soapObjectVect_t *searchResult,
+                             const uint32_t startingIndex = SOAP_DEFAULT_BROWSE_STARTING_INDEX, 
+                             const uint16_t maxCount      = SOAP_DEFAULT_BROWSE_MAX_COUNT,
+                             const char *sortCriteria     = SOAP_DEFAULT_BROWSE_SORT_CRITERIA,
+                             const uint16_t fields        = SOAP_FIELD_ALL);
+    bool        searchServer(const uint8_t srv, const char *containerId, const char *criteria, soapBrowseCallback_t callback, 
+                             void *userData = NULL,
+                             const uint32_t startingIndex = SOAP_DEFAULT_BROWSE_STARTING_INDEX, 
+                             const uint16_t maxCount      = SOAP_DEFAULT_BROWSE_MAX_COUNT,
+                             const char *sortCriteria     = SOAP_DEFAULT_BROWSE_SORT_CRITERIA,
+                             const uint16_t fields        = SOAP_FIELD_ALL);
+    bool        searchBegin(soapBrowseCursor_t *cursor, const uint8_t srv, const char *containerId, const char *criteria,
+                            const uint16_t maxCount  = SOAP_DEFAULT_BROWSE_MAX_COUNT,
+                            const char *sortCriteria = SOAP_DEFAULT_BROWSE_SORT_CRITERIA,
+                            const uint16_t fields    = SOAP_FIELD_ALL);
+    bool        getSearchCapabilities(uint8_t srv, String *caps);
+    bool        browseNext(soapBrowseCursor_t *cursor, soapObjectVect_t *page);
+    bool        browseNext(soapBrowseCursor_t *cursor, SoapObjectArena *page);
+    bool        browseNext(soapBrowseCursor_t *cursor, soapBrowseCallback_t callback, void *userData = NULL);
+    void        enableBrowseCache(size_t budget = 0);
+    void        disableBrowseCache(void);
+    void        invalidateBrowseCache(int srv = -1, const char *objectId = NULL);
+    bool        checkBrowseCache(uint8_t srv);
+    bool        getSystemUpdateId(uint8_t srv, uint32_t *id);
+    bool        startEventListener(soapEventCallback_t callback = NULL, void *userData = NULL, 
+                                   uint16_t port = SOAP_EVENT_PORT);
+    void        stopEventListener(void);
+    bool        subscribeEvents(uint8_t srv, uint32_t timeout = SOAP_EVENT_TIMEOUT);
+    bool        unsubscribeEvents(uint8_t srv);
     bool        readStart(soapObject_t *object, size_t *size);
+    bool        readStart(soapObject_t *object, uint64_t *size, uint64_t offset, uint64_t length = 0);
+    bool        readStart(const char *url, uint64_t *size, uint64_t offset = 0, uint64_t length = 0);
     int         read(uint8_t *buf, size_t size, uint32_t timeout = SERVER_READ_TIMEOUT);
     int         read(void);
     void        readStop(void);
+    bool        readTaskStart(SoapRingBuffer *ring, size_t highWatermark = 0, size_t lowWatermark = 0);
+    bool        readTaskStart(Print *sink);
+    readTaskState_et readTaskState(void);
+    void        readTaskStop(void);
     size_t      available(void);
+    uint64_t    available64(void);
+    uint64_t    readPosition(void);
     const char *getFileTypeName(eFileType fileType);
-
-    //DMR Transport control
-    bool isPlaying(void);
-    void play(void);
-    void stop(void);
-    void pause(void);
+    void        setKeepAlive(bool keepAlive);
+    bool        setCompression(bool gzip);
+    void        setResourcePolicy(const char *mimeTypes, int maxBitrate = 0, uint64_t maxSize = 0, bool mimeOnly = false);
+    void        getStats(soapStats_t *last, soapStats_t *total = NULL);
+    void        resetStats(void);
+
+    // async requests: run on a request task, one at a time. Finished when asyncState() returns 
+    // asyncDone/asyncError, done callback (if given) is called by request task
+    bool        seekServerAsync(serviceClass_et serviceClass = DMS, uint8_t workers = 1,
+                                soapAsyncCallback_t done = NULL, void *userData = NULL);
+    bool        browseServerAsync(const uint8_t srv, const char *objectId, soapObjectVect_t *browseResult,
+                                  soapAsyncCallback_t done = NULL, void *userData = NULL,
+                                  const uint32_t startingIndex = SOAP_DEFAULT_BROWSE_STARTING_INDEX, 
+                                  const uint16_t maxCount      = SOAP_DEFAULT_BROWSE_MAX_COUNT,
+                                  const uint16_t fields        = SOAP_FIELD_ALL);
+    bool        browseNextAsync(soapBrowseCursor_t *cursor, soapObjectVect_t *page,
+                                soapAsyncCallback_t done = NULL, void *userData = NULL);
+    bool        readStartAsync(soapObject_t *object, uint64_t *size, soapAsyncCallback_t done = NULL, 
+                               void *userData = NULL, uint64_t offset = 0, uint64_t length = 0);
+    bool        wakeUpServerAsync(const char *macWOL, uint8_t srv, uint32_t timeout = SOAP_WAKE_UP_TIMEOUT,
+                                  soapAsyncCallback_t done = NULL, void *userData = NULL);
+    asyncState_et asyncState(void);
+    bool        asyncWait(void);
+
+#ifndef SOAP_NO_DMR
+    // DMR transport & rendering control, srv: renderer in server list (seekServer(DMR))
+    bool        setTransportURI(uint8_t srv, const char *uri, const char *metaData = NULL);
+    bool        play(uint8_t srv = 0);
+    bool        pause(uint8_t srv = 0);
+    bool        stop(uint8_t srv = 0);
+    bool        seek(uint8_t srv, uint32_t position);
+    bool        getPositionInfo(uint8_t srv, soapPositionInfo_t *info);
+    bool        getTransportInfo(uint8_t srv, soapTransportInfo_t *info);
+    bool        setVolume(uint8_t srv, uint8_t volume);
+#endif
+    bool        isPlaying(uint8_t srv = 0);
     
   private:
+#ifdef USE_ETHERNET
+    SoapESP32(EthernetClient *client, EthernetUDP *udp, SemaphoreHandle_t *sem, SoapESP32 *parent);
+#else
+    SoapESP32(WiFiClient *client, WiFiUDP *udp, SoapESP32 *parent);
+#endif
 #ifdef USE_ETHERNET
     EthernetClient    *m_client;                // pointer to EthernetClient object
     EthernetUDP       *m_udp;                   // pointer to EthernetUDP object
@@ -234,24 +704,197 @@ class SoapESP32
     WiFiUDP           *m_udp;                   // pointer to WiFiUDP object
 #endif    
     bool               m_clientDataConOpen;     // marker: socket open for reading file
-    size_t             m_clientDataAvailable;   // file read count
-    soapServerVect_t   m_server ;               // list of usable media servers in local network
+    uint64_t           m_clientDataAvailable;   // file read count
+    uint64_t           m_clientDataPosition;    // file offset of next byte
+    bool               m_clientDataChunked;     // file data is chunked
+    bool               m_clientDataUnbounded;   // size not known, file data ends with final chunk or closed connection
+    SoapESP32         *m_parent;                // session: object sharing its server list, otherwise NULL
+    soapServerVect_t   m_serverList;            // list of usable media servers in local network
+    soapServerVect_t  &m_server;                // own list or list of parent (session)
     int                m_xmlChunkCount;         // nr of bytes left of chunk (0 = end of chunk, next line delivers chunk size)
     eXmlReplaceState   m_xmlReplaceState;       // state machine for replacing XML entities
     uint8_t            m_xmlReplaceOffset;
-    char               m_xmlReplaceBuffer[15];  // Fits longest string in replaceWith[] array
-
-    int  soapClientTimedRead(void);
+    char               m_xmlReplaceBuffer[15];  // rest of entity not replaced ('&' + name) or of UTF-8 sequence
+    uint8_t            m_rxBuffer[SOAP_RX_BUFFER_SIZE];  // receive buffer for HTTP header & XML data
+    size_t             m_rxBufferCount;         // nr of valid bytes in receive buffer
+    size_t             m_rxBufferOffset;        // read position in receive buffer
+    size_t             m_txCount;               // nr of request bytes assembled in receive buffer
+    bool               m_txFlushed;             // part of current request already written (didn't fit into buffer)
+    uint16_t           m_browseFields;          // object fields requested in current browse (SOAP_FIELD_...)
+    bool               m_resourcePolicy;        // select among all <res> of an item (setResourcePolicy())
+    String             m_resourceMime;          // preferred MIME types, comma separated
+    int                m_resourceMaxBitrate;    // 0: no limit
+    uint64_t           m_resourceMaxSize;       // 0: no limit
+    bool               m_resourceMimeOnly;      // resources with other MIME types are never selected
+    uint32_t           m_browseNumberReturned;  // objects announced (or found) in last browse reply
+    uint32_t           m_browseTotalMatches;    // total nr of objects in directory reported with last browse reply
+    bool               m_browseStopped;         // last browse stopped by callback function
+    int                m_lastServer;            // server that answered last browse/search request, -1: none
+    uint32_t           m_browseUpdateId;        // container UpdateID of last browse reply
+    soapCacheList_t    m_cache;                 // directory cache, most recently used entry first
+    size_t             m_cacheBytes;            // memory used by directory cache (estimate)
+    size_t             m_cacheBudget;           // max. memory for directory cache, 0: cache disabled
+    std::vector<soapSystemUpdateId_t> m_cacheSystemUpdateIds;
+    std::vector<soapCacheEvent_t> m_cacheEvents;   // reported by events (protected by m_serverLock)
+    bool               m_cacheEventsOverflow;   // too many cache events: drop all cached results
+    bool               m_keepAlive;             // connection reuse mode (HTTP keep-alive) enabled
+    bool               m_connReusable;          // client connection open & idle, can be used for next request
+    bool               m_connReused;            // current request uses a connection kept open
+    bool               m_connKeepAlive;         // server did not ask for closing connection in last reply
+    IPAddress          m_connIp;                // server ip & port of client connection
+    uint16_t           m_connPort;
+    uint64_t           m_xmlContentLeft;        // nr of bytes left of not chunked content
+    bool               m_xmlChunkFinal;         // final (empty) chunk has been read
+    int                m_httpStatus;            // status code of last reply (200 or 206)
+    bool               m_httpNoLength;          // last reply has neither Content-Length nor chunks (ends with closed connection)
+    bool               m_httpGzip;              // content of last reply is gzip compressed
+    bool               m_compression;           // ask for gzip compressed XML replies
+    soapInflate_t     *m_inflate;               // gzip decoder, allocated while reading compressed XML
+    uint64_t           m_contentRangeStart;     // "Content-Range:" of last reply (206 Partial Content)
+    uint64_t           m_contentRangeTotal;     // total size, 0 if not known
+    String             m_httpSid;               // "SID:" of last reply (GENA subscription)
+    uint32_t           m_httpTimeout;           // "TIMEOUT:" of last reply in s, 0: infinite
+    uint32_t           m_deadline;              // millis() value limiting current request, 0: none
+    uint8_t            m_seekMax;               // SSDP query ends when that many servers answered, 0: no limit
+    IPAddress          m_seekIp;                // SSDP query ends when this server answered (port 0: not used)
+    uint16_t           m_seekPort;
+    String             m_seekUuid;              // SSDP query ends when server with this uuid answered (empty: not used)
+    SemaphoreHandle_t  m_serverLock;            // protects server list while server monitor is running
+    TaskHandle_t       m_monitorTask;           // server monitor task (NOTIFY ssdp:alive/byebye)
+    SemaphoreHandle_t  m_monitorDone;           // given by server monitor task when finished
+    volatile bool      m_monitorRun;            // cleared to stop server monitor task
+    serviceClass_et    m_monitorClass;
+    TaskHandle_t       m_readTask;              // reader task (download into ring buffer/sink)
+    SemaphoreHandle_t  m_readTaskDone;          // given by reader task when finished
+    volatile bool      m_readTaskRun;           // cleared to stop reader task
+    volatile readTaskState_et m_readTaskState;
+    SoapRingBuffer    *m_readRing;
+    Print             *m_readSink;
+    size_t             m_readHigh;              // ring buffer watermarks
+    size_t             m_readLow;
+    TaskHandle_t       m_asyncTask;             // request task (async requests)
+    SemaphoreHandle_t  m_asyncTaskDone;         // given by request task when finished
+    volatile asyncState_et m_asyncState;
+    asyncRequest_et    m_asyncRequest;          // request & its parameters
+    serviceClass_et    m_asyncClass;
+    uint8_t            m_asyncSrv;              // seek: workers
+    String             m_asyncObjectId;         // wake up: MAC
+    soapObject_t       m_asyncObject;
+    soapObjectVect_t  *m_asyncResult;
+    soapBrowseCursor_t *m_asyncCursor;
+    uint64_t          *m_asyncSize;
+    uint64_t           m_asyncOffset;           // readStart: offset & length, browse: starting index & count
+    uint64_t           m_asyncLength;           // wake up: timeout
+    uint16_t           m_asyncFields;
+    soapAsyncCallback_t m_asyncDone;
+    void              *m_asyncUserData;
+    soapSubscriptionVect_t m_subscriptions;     // GENA event subscriptions (protected by m_serverLock)
+    TaskHandle_t       m_eventTask;             // NOTIFY listener task (also renews subscriptions)
+    SemaphoreHandle_t  m_eventDone;             // given by listener task when finished
+    volatile bool      m_eventRun;              // cleared to stop listener task
+    uint16_t           m_eventPort;             // port of NOTIFY listener
+    soapEventCallback_t m_eventCallback;
+    void              *m_eventUserData;
+    soapStats_t        m_stats;                 // statistics of current/last request
+    soapStats_t        m_statsTotal;            // accumulated statistics of all requests before
+
+    uint32_t soapTimeout(uint32_t timeout);
+    void   soapStatsBegin(void);
+    void   soapClientStop(void);
+    int    soapClientTimedRead(void);
+    bool   soapClientFillBuffer(void);
+    int    soapClientAvailable(void);
+    size_t soapClientReadBytesUntil(char terminator, char *buffer, size_t length);
     bool soapUDPmulticast(serviceClass_et serviceClass, uint8_t repeats = 0);
     bool soapSSDPquery(soapServerVect_t *result, serviceClass_et serviceClass, int msWait = SSDP_MAX_REPLY_TIMEOUT);
-    bool soapGet(const IPAddress ip, const uint16_t port, const char *uri);
-    bool soapBrowsePost(const IPAddress ip, const uint16_t port, const char *uri, const char *objectId, const uint32_t startingIndex, const uint16_t maxCount);
-    bool soapTransportActionPost(const IPAddress ip, const uint16_t port, const char *uri, transportAction_et action); 
+    bool soapActionPost(const IPAddress ip, const uint16_t port, const char *uri, const char *soapAction, const char *body);
+    bool soapGetSystemUpdateId(const soapServer_t *server, uint32_t *id);
+    bool soapCacheLookup(const soapServer_t *server, const char *objectId, const uint32_t startingIndex, 
+                         const uint16_t maxCount, const uint16_t fields, soapBrowseCallback_t callback, void *userData);
+    bool soapCacheCollect(soapCacheEntry_t *entry, const soapObject_t *object);
+    void soapCacheInsert(soapCacheEntry_t *entry);
+    void soapCacheErase(soapCacheList_t::iterator it);
+    void soapCacheApplyEvents(void);
+    bool soapCacheSystemUpdateId(const IPAddress ip, const uint16_t port, const uint32_t id);
+    bool soapEventRequest(const char *method, const IPAddress ip, const uint16_t port, const char *eventSubURL, 
+                          const char *sid, const uint32_t timeout = 0, const uint16_t callbackPort = 0);
+    static void soapEventTask(void *param);
+    void soapEventRenew(SoapESP32 *owner);
+    void soapEventNotify(SoapESP32 *owner);
+    bool soapEventSender(soapEvent_t *event);
+    void soapEventDeliver(soapEvent_t *event, int path);
+    bool soapGet(const IPAddress ip, const uint16_t port, const char *uri, uint64_t offset = 0, uint64_t length = 0,
+                 bool gzip = false);
+    bool soapBrowsePost(const IPAddress ip, const uint16_t port, const char *uri, const char *objectId, const uint32_t startingIndex, const uint16_t maxCount, const char *filter = SOAP_DEFAULT_BROWSE_FILTER,
+                        const char *criteria = NULL, const char *sortCriteria = NULL);
+    bool soapBrowse(const uint8_t srv, const char *objectId, const char *criteria, const char *sortCriteria, 
+                    soapBrowseCallback_t callback, void *userData, const uint32_t startingIndex, const uint16_t maxCount,
+                    const uint16_t fields);
+    bool soapSearch(const uint8_t srv, const char *containerId, const char *criteria, soapBrowseCallback_t callback, 
+                    void *userData, const uint32_t startingIndex, const uint16_t maxCount, const char *sortCriteria,
+                    const uint16_t fields, soapBrowseCursor_t *cursor);
+    bool soapSearchWalk(const uint8_t srv, const char *containerId, const char *criteria, soapBrowseCallback_t callback, 
+                        void *userData, const uint32_t startingIndex, const uint16_t maxCount, const uint16_t fields,
+                        soapBrowseCursor_t *cursor);
+    void soapSetSearchCaps(const soapServer_t *server, uint8_t searchCaps);
+    int  soapSelectServer(uint8_t srv, uint32_t tried);
+    void soapServerHealth(const soapServer_t *server, bool ok, uint32_t latency);
+    static void soapMergeTask(void *param);
+#ifndef SOAP_NO_DMR
+    bool soapControlRequest(const uint8_t srv, const bool rendering, const char *action, const char *args,
+                            const xPathParser_t *paths = NULL, const uint8_t num = 0, String *values = NULL,
+                            const char *const *escaped = NULL);
+#endif
     bool soapReadHttpHeader(uint64_t *contentLength, bool *chunked = NULL);
     int  soapReadXML(bool chunked = false, bool replace = false);
+    int  soapChunkBegin(void);
+    int  soapChunkConsumed(size_t count);
+    int  soapBodyPeek(bool chunked, const uint8_t **data);
+    int  soapBodySkip(bool chunked, size_t count);
+    int  soapBodyRead(bool chunked);
+    int  soapInflatePeek(bool chunked, const uint8_t **data);
+    int  soapXmlPeek(bool chunked, const uint8_t **data);
+    int  soapXmlSkip(bool chunked, size_t count);
+    int  soapXmlToken(bool chunked, char *token, size_t size);
+    void soapInflateEnd(void);
+    bool soapFetchDescription(const soapServer_t *rcvd, serviceClass_et serviceClass, soapServer_t *srv);
+    void soapMergeServerList(soapServerVect_t *found);
+    bool soapSeekParallel(soapServerVect_t *rcvd, soapServerVect_t *found, serviceClass_et serviceClass, uint8_t workers);
+    static void soapDiscoveryTask(void *param);
+    uint8_t soapRestoreServerList(const char *nvsNamespace, serviceClass_et serviceClass, bool probe, 
+                                  uint32_t timeout, uint8_t *dropped);
+    bool soapProbeServer(const IPAddress ip, const uint16_t port, uint32_t timeout = SERVER_CONNECT_TIMEOUT, bool keep = false);
+    bool soapResolveHost(const char *host, IPAddress *ip);
+    ssdpPacket_et soapScanSSDPpacket(char *packet, serviceClass_et serviceClass, soapServer_t *srv);
+    static void soapMonitorTask(void *param);
+    int  soapReadData(uint8_t *buf, size_t size);
+    bool soapSkipData(uint64_t count);
+    void soapDataConsumed(size_t count);
+    void soapDataEnd(void);
+    bool soapReadTaskCreate(void);
+    static void soapReadTask(void *param);
+    bool soapAsyncTaskCreate(asyncRequest_et request, soapAsyncCallback_t done, void *userData);
+    static void soapAsyncTask(void *param);
+    bool soapReadToRing(void);
+    bool soapReadToSink(void);
+    bool soapDrainResponse(bool chunked);
+    void soapFinishResponse(bool chunked, bool complete);
+    void soapTxBegin(const char *method, const IPAddress ip, const uint16_t port, const char *uri);
+    void soapTxAdd(const char *str);
+    void soapTxAdd(const char *str, size_t len);
+    void soapTxAddEscaped(const char *str);
+    void soapTxPrintf(const char *format, ...);
+    void soapTxFlush(bool last = false);
+    bool soapTxSend(const IPAddress ip, const uint16_t port);
     bool soapScanAttribute(const String *attributes, String *result, const char *searchFor);
-    bool soapScanContainer(const String *parentId, const String *attributes, const String *container, soapObjectVect_t *browseResult);
-    bool soapScanItem(const String *parentId, const String *attributes, const String *item, soapObjectVect_t *browseResult);
+    void soapBuildFilter(const uint16_t fields, char *filter, size_t size);
+    bool soapScanContainer(const String *parentId, const String *attributes, soapObject_t *info);
+    bool soapScanItem(const String *parentId, const String *attributes, soapObject_t *info);
+    bool soapScanResource(const String *attributes, String *res, soapResource_t *resource);
+    bool soapResourceFits(const soapResource_t *resource);
+    int  soapResourceRank(const soapResource_t *resource, eFileType fileType);
+    void soapSelectResource(soapObject_t *info);
+    bool soapScanObjectField(const int path, String *value, const String *attributes, soapObject_t *info);
     
     const char* ssdpST(serviceClass_et serviceClass);
     const char* ssdpNT(serviceClass_et serviceClass);
@@ -259,7 +902,8 @@ class SoapESP32
     const char* searchTX(serviceClass_et serviceClass);
     const char* serviceSchema(serviceClass_et serviceClass);
     bool connectToServer(const IPAddress ip, const uint16_t port);
-    void sendRequest(String str);
+    bool soapConnect(const IPAddress ip, const uint16_t port);
+    int  soapClientConnect(const IPAddress ip, const uint16_t port, uint32_t timeout);
     bool waitForResponse(void);
     
 
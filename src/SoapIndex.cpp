@@ -0,0 +1,883 @@
+/*
+  SoapIndex is part of SoapESP32 library, see SoapIndex.h
+*/
+
+#include "SoapIndex.h"
+#include <algorithm>
+#include <ctype.h>
+#include <stddef.h>
+
+#define SOAP_INDEX_SLOT_FREE      0           // slot ref values
+#define SOAP_INDEX_SLOT_DELETED   0xFFFFFFFF
+
+//
+// helper functions: string hashes (FNV-1a & djb2), ip as 32 bit value
+//
+static uint32_t soapIndexHash(const char *str, size_t len)
+{
+  uint32_t hash = 2166136261u;
+
+  while (len--) {
+    hash ^= (uint8_t)*str++;
+    hash *= 16777619u;
+  }
+
+  return hash;
+}
+
+static uint32_t soapIndexCheck(const char *str, size_t len)
+{
+  uint32_t hash = 5381;
+
+  while (len--) hash = hash * 33 + (uint8_t)*str++;
+
+  return hash;
+}
+
+static uint32_t soapIndexIp(const IPAddress ip)
+{
+  return (uint32_t)ip[0] | ((uint32_t)ip[1] << 8) | ((uint32_t)ip[2] << 16) | ((uint32_t)ip[3] << 24);
+}
+
+//
+// helper function: inline string of an object record (0: id, 1: title, 2: uri without prefix)
+//
+static const char *soapIndexField(const uint8_t *record, int n)
+{
+  const uint8_t *p = record + sizeof(soapIndexRecord_t);
+
+  for (; n > 0; n--) p += 2 + (p[0] | (p[1] << 8)) + 1;
+
+  return (const char *)p + 2;
+}
+
+static uint8_t *soapIndexPutField(uint8_t *p, const char *str, size_t len)
+{
+  *p++ = (uint8_t)len;
+  *p++ = (uint8_t)(len >> 8);
+  memcpy(p, str, len);
+  p[len] = 0;
+
+  return p + len + 1;
+}
+
+//
+// helper function: case insensitive (ASCII) search for pattern in text
+//
+static bool soapIndexMatch(const char *text, const char *pattern, size_t len)
+{
+  if (len == 0) return true;
+  for (; *text; text++) {
+    size_t i = 0;
+    while (i < len && text[i] && tolower((uint8_t)text[i]) == tolower((uint8_t)pattern[i])) i++;
+    if (i == len) return true;
+  }
+
+  return false;
+}
+
+static int soapIndexCompare(const void *a, const void *b)
+{
+  const soapIndexTableEntry_t *x = (const soapIndexTableEntry_t *)a, *y = (const soapIndexTableEntry_t *)b;
+
+  if (x->hash != y->hash) return (x->hash < y->hash) ? -1 : 1;
+  return (x->offset < y->offset) ? -1 : (x->offset > y->offset) ? 1 : 0;
+}
+
+//
+// constructor, index file lives on a file system (SD, LittleFS...)
+//
+SoapIndex::SoapIndex(fs::FS &fs, const char *path)
+  : m_fs(fs), m_path(path), m_end(0), m_objects(0), m_atEnd(false), m_ioError(false), m_copy(false),
+    m_slots(NULL), m_slotsUsed(0), m_parent(0)
+{
+  memset(&m_header, 0, sizeof(m_header));
+  memset(&m_outHeader, 0, sizeof(m_outHeader));
+  memset(&m_job, 0, sizeof(m_job));
+}
+
+SoapIndex::~SoapIndex()
+{
+  crawlEnd();
+  close();
+}
+
+//
+// open complete index for queries (called by all query functions)
+//
+bool SoapIndex::open()
+{
+  if (m_file) return true;
+
+  m_file = m_fs.open(m_path.c_str(), FILE_READ);
+  if (!m_file) return false;
+  if (!readHeader(m_file, &m_header) || !m_header.complete) {
+    log_w("index file %s not valid", m_path.c_str());
+    m_file.close();
+    return false;
+  }
+
+  return true;
+}
+
+void SoapIndex::close()
+{
+  if (m_file) m_file.close();
+}
+
+//
+// number of containers & items in index
+//
+uint32_t SoapIndex::count()
+{
+  return open() ? m_header.objects : 0;
+}
+
+//
+// true if index covers server srv and the server's content did not change since (SystemUpdateID)
+//
+bool SoapIndex::isUpToDate(SoapESP32 *soap, uint8_t srv)
+{
+  soapServer_t server;
+  uint32_t id;
+
+  if (!soap || !open() || !soap->getServerInfo(srv, &server)) return false;
+  if (m_header.serverIp != soapIndexIp(server.ip) || m_header.serverPort != server.port) return false;
+
+  return soap->getSystemUpdateId(srv, &id) && id == m_header.systemUpdateId;
+}
+
+//
+// crawl directory objectId of server srv and all its subdirectories into the index file.
+// Returns false if crawling failed or was paused by progress callback, the next call resumes
+// crawling. An up to date index is kept, otherwise directories with unchanged child count
+// are copied from the last index instead of being browsed again
+//
+bool SoapIndex::build(SoapESP32 *soap, uint8_t srv, const char *objectId, soapIndexProgress_t progress, void *userData)
+{
+  soapServer_t server;
+  String rootId, oldRootId;
+
+  if (!soap || !objectId || !soap->getServerInfo(srv, &server)) {
+    log_e("invalid parameter");
+    return false;
+  }
+  m_slots = (soapIndexSlot_t *)calloc(SOAP_INDEX_INTERN_SLOTS, sizeof(soapIndexSlot_t));
+  if (!m_slots) {
+    log_e("calloc() couldn't allocate memory");
+    return false;
+  }
+  m_slotsUsed = 0;
+  m_ioError = false;
+
+  bool ok = m_fs.exists((m_path + ".job").c_str()) && crawlResume(&server, objectId);
+  if (!ok) {
+    if (isUpToDate(soap, srv) && readString(m_file, m_header.rootId, &oldRootId) && oldRootId == objectId) {
+      log_i("index %s is up to date", m_path.c_str());
+      crawlEnd();
+      return true;
+    }
+    ok = crawlFresh(soap, &server, srv, objectId);
+  }
+
+  // last index of same server & directory provides unchanged directories
+  m_copy = ok && open() && m_header.serverIp == m_outHeader.serverIp && m_header.serverPort == m_outHeader.serverPort &&
+           readString(m_file, m_header.rootId, &oldRootId) && readString(m_out, m_outHeader.rootId, &rootId) &&
+           oldRootId == rootId;
+
+  while (ok && m_job.cursor != SOAP_INDEX_DONE) {
+    ok = crawlContainer(soap, srv);     // single page or copied directory
+    if (ok && progress && !progress(m_objects, userData)) {
+      log_i("crawling paused, %u objects so far", m_objects);
+      ok = false;
+      break;
+    }
+  }
+  if (ok) ok = crawlFinish();
+  crawlEnd();
+
+  return ok;
+}
+
+//
+// helper function: start new crawl into "<path>.new"
+//
+bool SoapIndex::crawlFresh(SoapESP32 *soap, const soapServer_t *server, uint8_t srv, const char *objectId)
+{
+  uint32_t updateId = 0;
+
+  if (!soap->getSystemUpdateId(srv, &updateId)) log_w("server doesn't report SystemUpdateID");
+  m_out = m_fs.open((m_path + ".new").c_str(), "w+");
+  if (!m_out) {
+    log_e("can't create index file %s.new", m_path.c_str());
+    return false;
+  }
+  memset(&m_outHeader, 0, sizeof(m_outHeader));
+  m_outHeader.magic = SOAP_INDEX_MAGIC;
+  m_outHeader.version = 1;
+  m_outHeader.systemUpdateId = updateId;
+  m_outHeader.serverIp = soapIndexIp(server->ip);
+  m_outHeader.serverPort = server->port;
+  memset(&m_job, 0, sizeof(m_job));
+  m_job.magic = SOAP_INDEX_JOB_MAGIC;
+  m_end = SOAP_INDEX_HEADER_SIZE;
+  m_objects = 0;
+  m_atEnd = false;
+  if (!writeAt(0, &m_outHeader, sizeof(m_outHeader))) return false;
+  m_outHeader.rootId = intern(objectId, strlen(objectId));
+  log_i("crawling server \"%s\", directory \"%s\"", server->friendlyName.c_str(), objectId);
+
+  return crawlCommit();
+}
+
+//
+// helper function: continue unfinished crawl of the same server & directory
+//
+bool SoapIndex::crawlResume(const soapServer_t *server, const char *objectId)
+{
+  soapIndexScan_t scan;
+  const uint8_t *p;
+  uint32_t offset;
+  String rootId;
+
+  File job = m_fs.open((m_path + ".job").c_str(), FILE_READ);
+  bool ok = job && job.read((uint8_t *)&m_job, sizeof(m_job)) == sizeof(m_job) && m_job.magic == SOAP_INDEX_JOB_MAGIC;
+  if (job) job.close();
+  if (ok) m_out = m_fs.open((m_path + ".new").c_str(), "r+");
+  ok = ok && m_out && readHeader(m_out, &m_outHeader) && m_outHeader.serverIp == soapIndexIp(server->ip) &&
+       m_outHeader.serverPort == server->port && readString(m_out, m_outHeader.rootId, &rootId) && rootId == objectId;
+  if (!ok) {
+    log_w("unfinished crawl discarded");
+    if (m_out) m_out.close();
+    return false;
+  }
+  m_end = m_job.dataEnd;
+  m_objects = m_job.objects;
+  m_atEnd = false;
+
+  // interned strings of committed part
+  if (!scanBegin(&scan, &m_out, SOAP_INDEX_HEADER_SIZE, m_end)) return false;
+  while ((p = scanNext(&scan, &offset))) {
+    if (p[0] != SOAP_INDEX_RECORD_STRING) continue;
+    size_t len = p[1] | (p[2] << 8);
+    internInsert(soapIndexHash((const char *)p + 3, len), soapIndexCheck((const char *)p + 3, len), offset);
+  }
+  scanEnd(&scan);
+  log_i("resuming crawl, %u objects so far", m_objects);
+
+  return true;
+}
+
+//
+// helper function: crawl next page of current container (or copy it from last index)
+//
+bool SoapIndex::crawlContainer(SoapESP32 *soap, uint8_t srv)
+{
+  soapBrowseCursor_t cursor;
+  uint32_t c = m_job.cursor, oldRecord;
+  uint64_t childCount = 0;
+  String id;
+
+  if (c == 0) {
+    if (!readString(m_out, m_outHeader.rootId, &id)) return false;
+  }
+  else {
+    if (!readRecord(m_out, c, m_record)) return false;
+    id = soapIndexField(m_record, 0);
+    childCount = ((const soapIndexRecord_t *)m_record)->size;
+  }
+  m_parent = c;
+
+  if (m_job.children == 0) {
+    m_job.children = m_end;
+    // directory with unchanged child count: copy its children from last index
+    if (c != 0 && m_copy && findRecord(id.c_str(), &oldRecord)) {
+      const soapIndexRecord_t *old = (const soapIndexRecord_t *)m_record;
+      if ((old->flags & SOAP_INDEX_FLAG_DIR) && old->size == childCount && old->children) {
+        log_d("directory \"%s\" unchanged, copied from last index", id.c_str());
+        if (!crawlCopy(old->children, old->childrenEnd)) {
+          crawlRollback();
+          return false;
+        }
+        return crawlNext(c);
+      }
+    }
+  }
+
+  soap->browseBegin(&cursor, srv, id.c_str(), SOAP_INDEX_PAGE_SIZE, SOAP_INDEX_FIELDS);
+  cursor.startingIndex = m_job.startingIndex;
+  bool ok = soap->browseNext(&cursor, soapIndexAdd, this);
+  if (m_ioError) return false;
+  if (!ok) {
+    crawlRollback();
+    if (++m_job.retries < SOAP_INDEX_MAX_RETRIES) {
+      crawlCommit();
+      return false;
+    }
+    log_w("browsing \"%s\" failed repeatedly, directory skipped", id.c_str());
+    return crawlNext(c);
+  }
+  m_job.retries = 0;
+  m_job.startingIndex = cursor.startingIndex;
+
+  return cursor.complete ? crawlNext(c) : crawlCommit();
+}
+
+//
+// helper function: browse callback storing objects of current container
+//
+bool SoapIndex::soapIndexAdd(const soapObject_t *object, void *userData)
+{
+  SoapIndex *index = (SoapIndex *)userData;
+
+  return index->addObject(object, index->m_parent);
+}
+
+//
+// helper function: copy children records of a container from last index
+//
+bool SoapIndex::crawlCopy(uint32_t from, uint32_t to)
+{
+  soapIndexScan_t scan;
+  soapObject_t object;
+  const uint8_t *p;
+  uint32_t offset;
+  bool ok = true;
+
+  if (!scanBegin(&scan, &m_file, from, to)) return false;
+  while (ok && (p = scanNext(&scan, &offset))) {
+    if (p[0] != SOAP_INDEX_RECORD_OBJECT) continue;
+    ok = toObject(m_file, p, "", &object) && addObject(&object, m_parent);
+  }
+  scanEnd(&scan);
+
+  return ok && !m_ioError;
+}
+
+//
+// helper function: container c completely crawled, store range of its children & move on to
+// next container record behind it (breadth first, the file itself is the queue)
+//
+bool SoapIndex::crawlNext(uint32_t c)
+{
+  soapIndexScan_t scan;
+  const uint8_t *p;
+  uint32_t offset;
+
+  if (c == 0) {
+    m_outHeader.rootChildren = m_job.children;
+    m_outHeader.rootChildrenEnd = m_end;
+  }
+  else {
+    uint32_t range[2] = { m_job.children, m_end };
+    if (!writeAt(c + offsetof(soapIndexRecord_t, children), range, sizeof(range))) return false;
+  }
+
+  m_job.cursor = SOAP_INDEX_DONE;
+  if (!scanBegin(&scan, &m_out, c ? c : SOAP_INDEX_HEADER_SIZE, m_end)) return false;
+  while ((p = scanNext(&scan, &offset))) {
+    if (offset > c && p[0] == SOAP_INDEX_RECORD_OBJECT && (p[1] & SOAP_INDEX_FLAG_DIR)) {
+      m_job.cursor = offset;
+      break;
+    }
+  }
+  scanEnd(&scan);
+  m_job.startingIndex = 0;
+  m_job.children = 0;
+  m_job.retries = 0;
+
+  return crawlCommit();
+}
+
+//
+// helper function: records written so far become permanent (header & job file)
+//
+bool SoapIndex::crawlCommit()
+{
+  m_outHeader.dataEnd = m_end;
+  m_outHeader.objects = m_objects;
+  if (!writeAt(0, &m_outHeader, sizeof(m_outHeader))) return false;
+  m_out.flush();
+
+  m_job.dataEnd = m_end;
+  m_job.objects = m_objects;
+  File job = m_fs.open((m_path + ".job").c_str(), FILE_WRITE);
+  bool ok = job && job.write((const uint8_t *)&m_job, sizeof(m_job)) == sizeof(m_job);
+  if (job) job.close();
+  if (!ok) {
+    log_e("writing job file failed");
+    m_ioError = true;
+  }
+
+  return ok;
+}
+
+//
+// helper function: drop records written since last commit
+//
+void SoapIndex::crawlRollback()
+{
+  m_end = m_job.dataEnd;
+  m_objects = m_job.objects;
+  m_atEnd = false;
+  for (uint32_t i = 0; i < SOAP_INDEX_INTERN_SLOTS; i++) {
+    if (m_slots[i].ref != SOAP_INDEX_SLOT_FREE && m_slots[i].ref >= m_end) m_slots[i].ref = SOAP_INDEX_SLOT_DELETED;
+  }
+}
+
+//
+// helper function: append id table (sorted by hash, built in slices of hash values that fit
+// into RAM), mark index complete & replace last index
+//
+bool SoapIndex::crawlFinish()
+{
+  soapIndexScan_t scan;
+  const uint8_t *p;
+  uint32_t offset, dataEnd = m_end;
+  const uint64_t hashRange = (uint64_t)1 << 32;
+  uint64_t lo = 0, step = hashRange * (SOAP_INDEX_SORT_ENTRIES / 2) / (m_objects + 1) + 1;
+
+  soapIndexTableEntry_t *table = (soapIndexTableEntry_t *)malloc(SOAP_INDEX_SORT_ENTRIES * sizeof(soapIndexTableEntry_t));
+  if (!table) {
+    log_e("malloc() couldn't allocate memory");
+    return false;
+  }
+  m_outHeader.table = m_end;
+  m_outHeader.tableCount = 0;
+  while (lo < hashRange) {
+    uint64_t hi = (lo + step < hashRange) ? lo + step : hashRange;
+    uint32_t n = 0;
+    bool overflow = false;
+
+    if (!scanBegin(&scan, &m_out, SOAP_INDEX_HEADER_SIZE, dataEnd)) break;
+    while ((p = scanNext(&scan, &offset))) {
+      if (p[0] != SOAP_INDEX_RECORD_OBJECT) continue;
+      const char *id = soapIndexField(p, 0);
+      uint32_t hash = soapIndexHash(id, strlen(id));
+      if (hash < lo || hash >= hi) continue;
+      if (n == SOAP_INDEX_SORT_ENTRIES) {
+        overflow = true;
+        break;
+      }
+      table[n].hash = hash;
+      table[n++].offset = offset;
+    }
+    scanEnd(&scan);
+    if (overflow) {
+      step = step / 2 + 1;      // too many ids in slice, try smaller one
+      continue;
+    }
+    qsort(table, n, sizeof(soapIndexTableEntry_t), soapIndexCompare);
+    if (!append(table, n * sizeof(soapIndexTableEntry_t))) break;
+    m_outHeader.tableCount += n;
+    lo = hi;
+  }
+  free(table);
+  if (lo < hashRange) return false;
+
+  m_outHeader.dataEnd = dataEnd;
+  m_outHeader.objects = m_objects;
+  m_outHeader.complete = 1;
+  if (!writeAt(0, &m_outHeader, sizeof(m_outHeader))) return false;
+  m_out.close();
+
+  close();
+  if (m_fs.exists(m_path.c_str())) m_fs.remove(m_path.c_str());
+  if (!m_fs.rename((m_path + ".new").c_str(), m_path.c_str())) {
+    log_e("renaming index file failed");
+    return false;
+  }
+  m_fs.remove((m_path + ".job").c_str());
+  log_i("index complete: %u objects", m_objects);
+
+  return true;
+}
+
+void SoapIndex::crawlEnd()
+{
+  free(m_slots);
+  m_slots = NULL;
+  if (m_out) m_out.close();
+}
+
+//
+// helper function: append object record (interned strings go in front of it)
+//
+bool SoapIndex::addObject(const soapObject_t *object, uint32_t parent)
+{
+  soapIndexRecord_t *rec = (soapIndexRecord_t *)m_record;
+  const char *uri = object->uri.c_str();
+  const char *slash = strrchr(uri, '/');
+  size_t prefixLen = slash ? slash - uri + 1 : 0;
+
+  if (prefixLen > SOAP_INDEX_STRING_MAX) prefixLen = 0;      // whole uri goes into record
+  size_t idLen = object->id.length(), nameLen = object->name.length(), restLen = object->uri.length() - prefixLen;
+  size_t length = sizeof(soapIndexRecord_t) + 3 * 3 + idLen + nameLen + restLen;
+  if (length > sizeof(m_record)) {
+    log_w("object \"%s\" too big for index, skipped", object->id.c_str());
+    return true;
+  }
+
+  uint32_t prefix = intern(uri, prefixLen);
+  uint32_t album = intern(object->album.c_str(), object->album.length());
+  uint32_t artist = intern(object->artist.c_str(), object->artist.length());
+  if (m_ioError) return false;
+
+  memset(rec, 0, sizeof(soapIndexRecord_t));
+  rec->type = SOAP_INDEX_RECORD_OBJECT;
+  rec->flags = (object->isDirectory ? SOAP_INDEX_FLAG_DIR : 0) | (object->sizeMissing ? SOAP_INDEX_FLAG_NO_SIZE : 0) |
+               (object->searchable ? SOAP_INDEX_FLAG_SEARCH : 0) | ((uint8_t)object->fileType << 4);
+  rec->length = length;
+  rec->parent = parent;
+  rec->size = object->size;
+  rec->ip = soapIndexIp(object->downloadIp);
+  rec->port = object->downloadPort;
+  rec->uriPrefix = prefix;
+  rec->album = album;
+  rec->artist = artist;
+  uint8_t *p = m_record + sizeof(soapIndexRecord_t);
+  p = soapIndexPutField(p, object->id.c_str(), idLen);
+  p = soapIndexPutField(p, object->name.c_str(), nameLen);
+  soapIndexPutField(p, uri + prefixLen, restLen);
+  if (!append(m_record, length)) return false;
+  m_objects++;
+
+  return true;
+}
+
+//
+// helper function: string record of str, stored once as long as interning table has room
+//
+uint32_t SoapIndex::intern(const char *str, size_t len)
+{
+  const uint32_t mask = SOAP_INDEX_INTERN_SLOTS - 1;
+
+  if (len == 0) return 0;
+  if (len > SOAP_INDEX_STRING_MAX) len = SOAP_INDEX_STRING_MAX;
+  uint32_t hash = soapIndexHash(str, len), check = soapIndexCheck(str, len);
+  for (uint32_t i = hash & mask; m_slots[i].ref != SOAP_INDEX_SLOT_FREE; i = (i + 1) & mask) {
+    if (m_slots[i].ref != SOAP_INDEX_SLOT_DELETED && m_slots[i].hash == hash && m_slots[i].check == check) {
+      return m_slots[i].ref;
+    }
+  }
+
+  uint8_t head[3] = { SOAP_INDEX_RECORD_STRING, (uint8_t)len, (uint8_t)(len >> 8) };
+  uint32_t ref = m_end;
+  if (!append(head, sizeof(head)) || !append(str, len) || !append("", 1)) return 0;
+  internInsert(hash, check, ref);
+
+  return ref;
+}
+
+bool SoapIndex::internInsert(uint32_t hash, uint32_t check, uint32_t ref)
+{
+  const uint32_t mask = SOAP_INDEX_INTERN_SLOTS - 1;
+  uint32_t i;
+
+  // keep table at most 3/4 full, further strings are stored with every use
+  if (m_slotsUsed >= SOAP_INDEX_INTERN_SLOTS / 4 * 3) return false;
+  for (i = hash & mask; m_slots[i].ref != SOAP_INDEX_SLOT_FREE; i = (i + 1) & mask);
+  m_slots[i].hash = hash;
+  m_slots[i].check = check;
+  m_slots[i].ref = ref;
+  m_slotsUsed++;
+
+  return true;
+}
+
+//
+// helper functions: file access
+//
+bool SoapIndex::append(const void *data, size_t len)
+{
+  if (m_ioError) return false;
+  if (!m_atEnd && !m_out.seek(m_end)) {
+    m_ioError = true;
+    return false;
+  }
+  m_atEnd = true;
+  if (m_out.write((const uint8_t *)data, len) != len) {
+    log_e("writing index file failed");
+    m_ioError = true;
+    return false;
+  }
+  m_end += len;
+
+  return true;
+}
+
+bool SoapIndex::writeAt(uint32_t offset, const void *data, size_t len)
+{
+  m_atEnd = false;
+  if (!m_out.seek(offset) || m_out.write((const uint8_t *)data, len) != len) {
+    log_e("writing index file failed");
+    m_ioError = true;
+    return false;
+  }
+
+  return true;
+}
+
+bool SoapIndex::readAt(File &file, uint32_t offset, void *data, size_t len)
+{
+  m_atEnd = false;
+
+  return file.seek(offset) && file.read((uint8_t *)data, len) == len;
+}
+
+bool SoapIndex::readString(File &file, uint32_t ref, String *str)
+{
+  uint8_t head[3];
+  char buffer[SOAP_INDEX_STRING_MAX + 1];
+
+  *str = "";
+  if (ref == 0) return true;
+  if (!readAt(file, ref, head, sizeof(head)) || head[0] != SOAP_INDEX_RECORD_STRING) return false;
+  size_t len = head[1] | (head[2] << 8);
+  if (len > SOAP_INDEX_STRING_MAX || file.read((uint8_t *)buffer, len) != len) return false;
+  buffer[len] = 0;
+  *str = buffer;
+
+  return true;
+}
+
+bool SoapIndex::readRecord(File &file, uint32_t offset, uint8_t *record)
+{
+  if (!readAt(file, offset, record, 4) || record[0] != SOAP_INDEX_RECORD_OBJECT) return false;
+  size_t len = record[2] | (record[3] << 8);
+  if (len < sizeof(soapIndexRecord_t) + 9 || len > SOAP_INDEX_RECORD_MAX) return false;
+
+  return file.read(record + 4, len - 4) == len - 4;
+}
+
+bool SoapIndex::readHeader(File &file, soapIndexHeader_t *header)
+{
+  return readAt(file, 0, header, sizeof(soapIndexHeader_t)) && header->magic == SOAP_INDEX_MAGIC && header->version == 1;
+}
+
+//
+// helper function: find object record by id (binary search in id table), record ends up in m_record
+//
+bool SoapIndex::findRecord(const char *id, uint32_t *offset)
+{
+  soapIndexTableEntry_t entry;
+  uint32_t hash = soapIndexHash(id, strlen(id));
+  uint32_t lo = 0, hi = m_header.tableCount;
+
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (!readAt(m_file, m_header.table + mid * sizeof(entry), &entry, sizeof(entry))) return false;
+    if (entry.hash < hash) lo = mid + 1; else hi = mid;
+  }
+  for (; lo < m_header.tableCount; lo++) {
+    if (!readAt(m_file, m_header.table + lo * sizeof(entry), &entry, sizeof(entry)) || entry.hash != hash) break;
+    if (readRecord(m_file, entry.offset, m_record) && strcmp(soapIndexField(m_record, 0), id) == 0) {
+      *offset = entry.offset;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+//
+// helper function: object record to soapObject_t, parent id gets read from index if not known
+//
+bool SoapIndex::toObject(File &file, const uint8_t *record, const char *parentId, soapObject_t *object)
+{
+  const soapIndexRecord_t *rec = (const soapIndexRecord_t *)record;
+  uint32_t ip = rec->ip, parent = rec->parent;
+  String prefix;
+
+  object->isDirectory = (rec->flags & SOAP_INDEX_FLAG_DIR) != 0;
+  object->size = rec->size;
+  object->sizeMissing = (rec->flags & SOAP_INDEX_FLAG_NO_SIZE) != 0;
+  object->bitrate = 0;
+  object->sampleFrequency = 0;
+  object->searchable = (rec->flags & SOAP_INDEX_FLAG_SEARCH) != 0;
+  object->fileType = (eFileType)(rec->flags >> 4);
+  object->id = soapIndexField(record, 0);
+  object->name = soapIndexField(record, 1);
+  if (!readString(file, rec->uriPrefix, &prefix) || !readString(file, rec->album, &object->album) ||
+      !readString(file, rec->artist, &object->artist)) {
+    return false;
+  }
+  object->uri = prefix;
+  object->uri += soapIndexField(record, 2);
+  object->downloadIp = IPAddress(ip & 0xFF, (ip >> 8) & 0xFF, (ip >> 16) & 0xFF, ip >> 24);
+  object->downloadPort = rec->port;
+  object->albumArtUri = "";
+  object->iconUri = "";
+
+  if (parentId) {
+    object->parentId = parentId;
+  }
+  else if (parent == 0) {
+    return readString(file, m_header.rootId, &object->parentId);
+  }
+  else {
+    // id of parent record, read in pieces
+    uint8_t head[2];
+    char buffer[65];
+    object->parentId = "";
+    if (!readAt(file, parent + sizeof(soapIndexRecord_t), head, sizeof(head))) return false;
+    for (size_t len = head[0] | (head[1] << 8); len > 0; ) {
+      size_t n = (len < sizeof(buffer) - 1) ? len : sizeof(buffer) - 1;
+      if (file.read((uint8_t *)buffer, n) != n) return false;
+      buffer[n] = 0;
+      object->parentId += buffer;
+      len -= n;
+    }
+  }
+
+  return true;
+}
+
+//
+// get object by id
+//
+bool SoapIndex::lookup(const char *id, soapObject_t *object)
+{
+  uint32_t offset;
+
+  if (!id || !object || !open() || !findRecord(id, &offset)) return false;
+
+  return toObject(m_file, m_record, NULL, object);
+}
+
+//
+// hand over all direct children of a directory (id NULL: crawled directory) to callback,
+// like browseServer() does
+//
+bool SoapIndex::children(const char *id, soapBrowseCallback_t callback, void *userData)
+{
+  soapIndexScan_t scan;
+  soapObject_t object;
+  const uint8_t *p;
+  uint32_t offset, from, to, parent = 0;
+  String rootId;
+
+  if (!callback || !open() || !readString(m_file, m_header.rootId, &rootId)) return false;
+  if (!id || rootId == id) {
+    from = m_header.rootChildren;
+    to = m_header.rootChildrenEnd;
+  }
+  else if (findRecord(id, &parent) && (m_record[1] & SOAP_INDEX_FLAG_DIR)) {
+    from = ((const soapIndexRecord_t *)m_record)->children;
+    to = ((const soapIndexRecord_t *)m_record)->childrenEnd;
+  }
+  else {
+    return false;
+  }
+
+  if (from == 0) return true;         // directory skipped while crawling
+  if (!scanBegin(&scan, &m_file, from, to)) return false;
+  while ((p = scanNext(&scan, &offset))) {
+    if (p[0] != SOAP_INDEX_RECORD_OBJECT || ((const soapIndexRecord_t *)p)->parent != parent) continue;
+    if (!toObject(m_file, p, id ? id : rootId.c_str(), &object) || !callback(&object, userData)) break;
+  }
+  scanEnd(&scan);
+
+  return true;
+}
+
+//
+// hand over all objects whose title, album or artist (fields) contain text (case insensitive)
+// to callback, returns number of objects found
+//
+uint32_t SoapIndex::search(const char *text, soapBrowseCallback_t callback, void *userData, uint8_t fields, uint32_t maxResults)
+{
+  soapIndexScan_t scan;
+  soapObject_t object;
+  const uint8_t *p;
+  uint32_t offset, found = 0;
+  std::vector<uint32_t> refs;         // string records containing text, ascending
+
+  if (!text || !callback || !open()) return 0;
+  size_t len = strlen(text);
+  if (!scanBegin(&scan, &m_file, SOAP_INDEX_HEADER_SIZE, m_header.dataEnd)) return 0;
+  while ((p = scanNext(&scan, &offset))) {
+    if (p[0] == SOAP_INDEX_RECORD_STRING) {
+      // string records precede the objects using them
+      if ((fields & (SOAP_INDEX_SEARCH_ALBUM | SOAP_INDEX_SEARCH_ARTIST)) && soapIndexMatch((const char *)p + 3, text, len)) {
+        refs.push_back(offset);
+      }
+      continue;
+    }
+    const soapIndexRecord_t *rec = (const soapIndexRecord_t *)p;
+    uint32_t album = rec->album, artist = rec->artist;
+    if (!((fields & SOAP_INDEX_SEARCH_TITLE) && soapIndexMatch(soapIndexField(p, 1), text, len)) &&
+        !((fields & SOAP_INDEX_SEARCH_ALBUM) && album && std::binary_search(refs.begin(), refs.end(), album)) &&
+        !((fields & SOAP_INDEX_SEARCH_ARTIST) && artist && std::binary_search(refs.begin(), refs.end(), artist))) {
+      continue;
+    }
+    if (!toObject(m_file, p, NULL, &object)) break;
+    found++;
+    if (!callback(&object, userData) || (maxResults && found >= maxResults)) break;
+  }
+  scanEnd(&scan);
+  log_d("search \"%s\": %u objects found", text, found);
+
+  return found;
+}
+
+//
+// helper functions: sequential reading of records [from, to) with block reads
+//
+bool SoapIndex::scanBegin(soapIndexScan_t *scan, File *file, uint32_t from, uint32_t to)
+{
+  scan->file = file;
+  scan->pos = from;
+  scan->count = 0;
+  scan->offset = 0;
+  scan->end = to;
+  scan->buffer = (uint8_t *)malloc(SOAP_INDEX_SCAN_BUFFER);
+  if (!scan->buffer) {
+    log_e("malloc() couldn't allocate memory");
+    return false;
+  }
+
+  return true;
+}
+
+const uint8_t *SoapIndex::scanNext(soapIndexScan_t *scan, uint32_t *offset)
+{
+  while (true) {
+    uint32_t at = scan->pos + scan->offset;
+    size_t left = scan->count - scan->offset;
+
+    if (at >= scan->end) return NULL;
+    if (left >= 4) {
+      const uint8_t *p = scan->buffer + scan->offset;
+      size_t size = (p[0] == SOAP_INDEX_RECORD_STRING) ? 4 + (p[1] | (p[2] << 8)) :
+                    (p[0] == SOAP_INDEX_RECORD_OBJECT) ? (p[2] | (p[3] << 8)) : 0;
+      if (size < 4 || size > SOAP_INDEX_SCAN_BUFFER) {
+        log_e("index file corrupt at offset %u", at);
+        return NULL;
+      }
+      if (left >= size) {
+        scan->offset += size;
+        *offset = at;
+        return p;
+      }
+    }
+    // keep rest of buffer, read behind it
+    memmove(scan->buffer, scan->buffer + scan->offset, left);
+    scan->pos = at;
+    scan->offset = 0;
+    scan->count = left;
+    size_t n = SOAP_INDEX_SCAN_BUFFER - left;
+    if (at + left + n > scan->end) n = scan->end - at - left;
+    m_atEnd = false;
+    if (n == 0 || !scan->file->seek(at + left)) return NULL;
+    int res = scan->file->read(scan->buffer + left, n);
+    if (res <= 0) return NULL;
+    scan->count += res;
+  }
+}
+
+void SoapIndex::scanEnd(soapIndexScan_t *scan)
+{
+  free(scan->buffer);
+  scan->buffer = NULL;
+}
@@ -0,0 +1,185 @@
+/*
+  SoapIndex is part of SoapESP32 library. It crawls the directory tree of a media
+  server and writes a compact binary index of all containers & items to a file
+  (SD, LittleFS...). An interrupted crawl is resumed by the next call to build(),
+  a new crawl copies directories with unchanged child count from the last index.
+  Lookup by object id uses a sorted id table at the end of the file, children() &
+  search() scan the file, nothing of the index is kept in RAM.
+*/
+
+#ifndef SoapIndex_h
+#define SoapIndex_h
+
+#include <FS.h>
+#include "SoapESP32.h"
+
+#define SOAP_INDEX_PATH           "/soapesp32.idx"     // index file, ".new" & ".job" are used while crawling
+#define SOAP_INDEX_MAGIC          0x31584449           // "IDX1"
+#define SOAP_INDEX_JOB_MAGIC      0x31424f4a           // "JOB1"
+#define SOAP_INDEX_HEADER_SIZE    64
+#define SOAP_INDEX_PAGE_SIZE      200     // objects per browse request while crawling
+#define SOAP_INDEX_MAX_RETRIES    3       // failed browse attempts before a directory gets skipped
+#define SOAP_INDEX_RECORD_MAX     1024    // max. size of an object record, bigger objects are not indexed
+#define SOAP_INDEX_STRING_MAX     255     // max. length of interned strings (uri prefix, album, artist)
+#define SOAP_INDEX_SCAN_BUFFER    2048    // block reads when scanning the index file
+#ifndef SOAP_INDEX_INTERN_SLOTS
+#define SOAP_INDEX_INTERN_SLOTS   2048    // string interning table while crawling (12 bytes each), power of 2
+#endif
+#ifndef SOAP_INDEX_SORT_ENTRIES
+#define SOAP_INDEX_SORT_ENTRIES   4096    // id table gets sorted in slices of this many entries (8 bytes each)
+#endif
+#define SOAP_INDEX_FIELDS         (SOAP_FIELD_URI | SOAP_FIELD_SIZE | SOAP_FIELD_CLASS | SOAP_FIELD_ALBUM | \
+                                   SOAP_FIELD_ARTIST | SOAP_FIELD_CHILD_COUNT | SOAP_FIELD_SEARCHABLE)
+
+// fields looked at by search()
+#define SOAP_INDEX_SEARCH_TITLE   0x01
+#define SOAP_INDEX_SEARCH_ALBUM   0x02
+#define SOAP_INDEX_SEARCH_ARTIST  0x04
+#define SOAP_INDEX_SEARCH_ALL     0x07
+
+// called after each directory page stored by build(), return false to pause crawling
+typedef bool (*soapIndexProgress_t)(uint32_t objects, void *userData);
+
+// index file header (offset 0)
+struct soapIndexHeader_t
+{
+  uint32_t magic;               // SOAP_INDEX_MAGIC
+  uint16_t version;
+  uint16_t complete;            // crawl finished, id table valid
+  uint32_t systemUpdateId;      // server's SystemUpdateID when crawl started
+  uint32_t serverIp;
+  uint16_t serverPort;
+  uint16_t reserved;
+  uint32_t rootId;              // string record: id of crawled directory
+  uint32_t rootChildren;        // records of crawled directory's children
+  uint32_t rootChildrenEnd;
+  uint32_t dataEnd;             // end of records
+  uint32_t table;               // id table: soapIndexTableEntry_t sorted by hash
+  uint32_t tableCount;
+  uint32_t objects;             // containers & items
+  uint32_t spare[4];
+};
+
+// state of an unfinished crawl (job file), written after each directory page
+struct soapIndexJob_t
+{
+  uint32_t magic;               // SOAP_INDEX_JOB_MAGIC
+  uint32_t dataEnd;             // committed end of records
+  uint32_t cursor;              // container record being crawled, 0: crawled directory, SOAP_INDEX_DONE: finished
+  uint32_t startingIndex;       // next page of container
+  uint32_t children;            // first child record of container, 0: not started
+  uint32_t objects;
+  uint32_t retries;             // failed attempts of current page
+};
+#define SOAP_INDEX_DONE           0xFFFFFFFF
+
+// object record, followed by id, title & uri (without interned prefix): 16 bit length, chars, '\0'
+// string records: 'S', 16 bit length, chars, '\0'
+struct __attribute__((packed)) soapIndexRecord_t
+{
+  uint8_t  type;                // 'O'
+  uint8_t  flags;               // SOAP_INDEX_FLAG_..., file type in upper nibble
+  uint16_t length;              // whole record
+  uint32_t parent;              // container record, 0: crawled directory
+  uint64_t size;                // item size or container child count
+  uint32_t ip;                  // download ip & port
+  uint16_t port;
+  uint16_t reserved;
+  uint32_t uriPrefix;           // string records, 0: empty
+  uint32_t album;
+  uint32_t artist;
+  uint32_t children;            // containers: records of children, set when crawled
+  uint32_t childrenEnd;
+};
+#define SOAP_INDEX_RECORD_OBJECT  'O'
+#define SOAP_INDEX_RECORD_STRING  'S'
+#define SOAP_INDEX_FLAG_DIR       0x01
+#define SOAP_INDEX_FLAG_NO_SIZE   0x02
+#define SOAP_INDEX_FLAG_SEARCH    0x04
+
+struct soapIndexTableEntry_t
+{
+  uint32_t hash;                // of object id
+  uint32_t offset;              // object record
+};
+
+// interned string while crawling
+struct soapIndexSlot_t
+{
+  uint32_t hash;
+  uint32_t check;               // second hash, makes collisions practically impossible
+  uint32_t ref;                 // string record, 0: empty slot
+};
+
+// sequential reading of records with block reads
+struct soapIndexScan_t
+{
+  File    *file;
+  uint8_t *buffer;
+  uint32_t pos;                 // file offset of buffer[0]
+  size_t   count;               // valid bytes in buffer
+  size_t   offset;              // next record in buffer
+  uint32_t end;
+};
+
+class SoapIndex {
+  public:
+    SoapIndex(fs::FS &fs, const char *path = SOAP_INDEX_PATH);
+    ~SoapIndex();
+
+    bool     build(SoapESP32 *soap, uint8_t srv, const char *objectId = "0",
+                   soapIndexProgress_t progress = NULL, void *userData = NULL);
+    bool     isUpToDate(SoapESP32 *soap, uint8_t srv);
+    bool     open(void);
+    void     close(void);
+    uint32_t count(void);
+    bool     lookup(const char *id, soapObject_t *object);
+    bool     children(const char *id, soapBrowseCallback_t callback, void *userData = NULL);
+    uint32_t search(const char *text, soapBrowseCallback_t callback, void *userData = NULL,
+                    uint8_t fields = SOAP_INDEX_SEARCH_ALL, uint32_t maxResults = 0);
+
+  private:
+    fs::FS            &m_fs;
+    String             m_path;
+    File               m_file;          // complete index (queries, source of unchanged directories)
+    soapIndexHeader_t  m_header;
+    File               m_out;           // index being crawled
+    soapIndexHeader_t  m_outHeader;
+    soapIndexJob_t     m_job;
+    uint32_t           m_end;           // end of records in m_out
+    uint32_t           m_objects;
+    bool               m_atEnd;         // m_out positioned at m_end
+    bool               m_ioError;
+    bool               m_copy;          // last index (m_file) is of same server & directory
+    soapIndexSlot_t   *m_slots;
+    uint32_t           m_slotsUsed;
+    uint32_t           m_parent;        // container record receiving browse results
+    uint8_t            m_record[SOAP_INDEX_RECORD_MAX];
+
+    static bool soapIndexAdd(const soapObject_t *object, void *userData);
+    bool     crawlFresh(SoapESP32 *soap, const soapServer_t *server, uint8_t srv, const char *objectId);
+    bool     crawlResume(const soapServer_t *server, const char *objectId);
+    bool     crawlContainer(SoapESP32 *soap, uint8_t srv);
+    bool     crawlCopy(uint32_t from, uint32_t to);
+    bool     crawlNext(uint32_t from);
+    bool     crawlCommit(void);
+    void     crawlRollback(void);
+    bool     crawlFinish(void);
+    void     crawlEnd(void);
+    bool     addObject(const soapObject_t *object, uint32_t parent);
+    uint32_t intern(const char *str, size_t len);
+    bool     internInsert(uint32_t hash, uint32_t check, uint32_t ref);
+    bool     append(const void *data, size_t len);
+    bool     writeAt(uint32_t offset, const void *data, size_t len);
+    bool     readAt(File &file, uint32_t offset, void *data, size_t len);
+    bool     readString(File &file, uint32_t ref, String *str);
+    bool     readRecord(File &file, uint32_t offset, uint8_t *record);
+    bool     readHeader(File &file, soapIndexHeader_t *header);
+    bool     findRecord(const char *id, uint32_t *offset);
+    bool     toObject(File &file, const uint8_t *record, const char *parentId, soapObject_t *object);
+    bool     scanBegin(soapIndexScan_t *scan, File *file, uint32_t from, uint32_t to);
+    const uint8_t *scanNext(soapIndexScan_t *scan, uint32_t *offset);
+    void     scanEnd(soapIndexScan_t *scan);
+};
+
+#endif
@@ -0,0 +1,104 @@
+/*
+  SoapRingBuffer is part of SoapESP32 library, see SoapRingBuffer.h
+*/
+
+#include "SoapRingBuffer.h"
+
+//
+// constructor, buffer memory is owned by caller
+//
+SoapRingBuffer::SoapRingBuffer(uint8_t *buffer, size_t size)
+  : m_buffer(buffer), m_size(buffer ? size : 0), m_head(0), m_tail(0)
+{
+}
+
+//
+// discard content, must not be called while producer or consumer are active
+//
+void SoapRingBuffer::reset()
+{
+  m_head.store(0, std::memory_order_relaxed);
+  m_tail.store(0, std::memory_order_release);
+}
+
+//
+// positions run from 0 to 2*size-1, that way a full buffer can be told from an empty one
+//
+size_t SoapRingBuffer::available()
+{
+  uint32_t head = m_head.load(std::memory_order_acquire), tail = m_tail.load(std::memory_order_acquire);
+
+  return (head >= tail) ? head - tail : head + 2 * m_size - tail;
+}
+
+size_t SoapRingBuffer::availableForWrite()
+{
+  return m_size - available();
+}
+
+//
+// contiguous block of readable data, len receives its size
+//
+const uint8_t *SoapRingBuffer::readPtr(size_t *len)
+{
+  uint32_t tail = m_tail.load(std::memory_order_relaxed);
+  size_t offset = (tail >= m_size) ? tail - m_size : tail;
+
+  *len = min(available(), m_size - offset);
+  return *len ? m_buffer + offset : NULL;
+}
+
+void SoapRingBuffer::consume(size_t len)
+{
+  if (len > available()) len = available();
+  if (len == 0) return;
+  m_tail.store((m_tail.load(std::memory_order_relaxed) + len) % (2 * m_size), std::memory_order_release);
+}
+
+size_t SoapRingBuffer::read(uint8_t *buf, size_t len)
+{
+  size_t count = 0, block;
+  const uint8_t *p;
+
+  // at most two blocks (before & after wrap around)
+  while (count < len && (p = readPtr(&block)) != NULL) {
+    block = min(block, len - count);
+    memcpy(buf + count, p, block);
+    consume(block);
+    count += block;
+  }
+  return count;
+}
+
+//
+// contiguous block of free space, len receives its size
+//
+uint8_t *SoapRingBuffer::writePtr(size_t *len)
+{
+  uint32_t head = m_head.load(std::memory_order_relaxed);
+  size_t offset = (head >= m_size) ? head - m_size : head;
+
+  *len = min(availableForWrite(), m_size - offset);
+  return *len ? m_buffer + offset : NULL;
+}
+
+void SoapRingBuffer::commit(size_t len)
+{
+  if (len > availableForWrite()) len = availableForWrite();
+  if (len == 0) return;
+  m_head.store((m_head.load(std::memory_order_relaxed) + len) % (2 * m_size), std::memory_order_release);
+}
+
+size_t SoapRingBuffer::write(const uint8_t *buf, size_t len)
+{
+  size_t count = 0, block;
+  uint8_t *p;
+
+  while (count < len && (p = writePtr(&block)) != NULL) {
+    block = min(block, len - count);
+    memcpy(p, buf + count, block);
+    commit(block);
+    count += block;
+  }
+  return count;
+}
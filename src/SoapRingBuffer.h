@@ -0,0 +1,42 @@
+/*
+  SoapRingBuffer is part of SoapESP32 library. It is a simple single producer/
+  single consumer ring buffer working on caller owned memory. The SoapESP32
+  reader task writes downloaded data straight into it (no intermediate copy),
+  typically an audio decoder task consumes it.
+*/
+
+#ifndef SoapRingBuffer_h
+#define SoapRingBuffer_h
+
+#include <Arduino.h>
+#include <atomic>
+
+class SoapRingBuffer {
+  public:
+    SoapRingBuffer(uint8_t *buffer, size_t size);
+
+    void   reset();
+    size_t size() { return m_size; }
+    size_t available();                           // bytes ready for reading
+    size_t availableForWrite();                   // free space
+
+    // consumer side
+    size_t read(uint8_t *buf, size_t len);
+    const uint8_t *readPtr(size_t *len);          // contiguous readable block, no copy
+    void   consume(size_t len);                   // release bytes obtained with readPtr()
+
+    // producer side
+    size_t write(const uint8_t *buf, size_t len);
+    uint8_t *writePtr(size_t *len);               // contiguous free block, no copy
+    void   commit(size_t len);                    // publish bytes written via writePtr()
+
+  private:
+    uint8_t          *m_buffer;
+    size_t            m_size;
+    // positions get published with release and read with acquire ordering (producer & consumer 
+    // may run on different cores), so data written to the buffer is visible before the position
+    std::atomic<uint32_t> m_head;                 // write position, changed by producer only
+    std::atomic<uint32_t> m_tail;                 // read position, changed by consumer only
+};
+
+#endif